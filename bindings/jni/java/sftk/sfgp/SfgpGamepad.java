@@ -0,0 +1,151 @@
+package sftk.sfgp;
+
+import com.qualcomm.robotcore.hardware.Gamepad;
+
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
+
+/**
+ * SFGP gamepad fed straight from an FTC SDK {@link Gamepad}.
+ *
+ * <p>Each instance owns a single direct {@link ByteBuffer} that the SDK
+ * gamepad is written into on every {@link #update(Gamepad)}. The native side
+ * reads that buffer in place and writes the resulting button masks back into
+ * it, so an update costs one JNI call and allocates nothing.
+ *
+ * <pre>{@code
+ * SfgpGamepad driver = new SfgpGamepad();
+ * while (opModeIsActive()) {
+ *     driver.update(gamepad1);
+ *     if (driver.justPressed(SfgpGamepad.A | SfgpGamepad.LEFT_BUMPER)) ...
+ * }
+ * driver.close();
+ * }</pre>
+ */
+public final class SfgpGamepad implements AutoCloseable {
+    static {
+        System.loadLibrary("sfgp_jni");
+    }
+
+    // Button bits, identical to SFGP_BUTTON_MASK() and the SDK byte array.
+    public static final int TOUCHPAD_FINGER_1 = 1 << 17;
+    public static final int TOUCHPAD_FINGER_2 = 1 << 16;
+    public static final int TOUCHPAD = 1 << 15;
+    public static final int LEFT_STICK_BUTTON = 1 << 14;
+    public static final int RIGHT_STICK_BUTTON = 1 << 13;
+    public static final int DPAD_UP = 1 << 12;
+    public static final int DPAD_DOWN = 1 << 11;
+    public static final int DPAD_LEFT = 1 << 10;
+    public static final int DPAD_RIGHT = 1 << 9;
+    public static final int A = 1 << 8;
+    public static final int B = 1 << 7;
+    public static final int X = 1 << 6;
+    public static final int Y = 1 << 5;
+    public static final int GUIDE = 1 << 4;
+    public static final int START = 1 << 3;
+    public static final int BACK = 1 << 2;
+    public static final int LEFT_BUMPER = 1 << 1;
+    public static final int RIGHT_BUMPER = 1;
+
+    // Offsets within the shared buffer, see sfgp_jni.c.
+    private static final int ID_OFFSET = 0;
+    private static final int TIMESTAMP_OFFSET = 4;
+    private static final int AXES_OFFSET = 12;
+    private static final int BUTTONS_OFFSET = 36;
+    private static final int MASKS_OFFSET = 40;
+
+    private final ByteBuffer buffer;
+    private long handle;
+
+    public SfgpGamepad() {
+        buffer = ByteBuffer.allocateDirect(nativeBufferSize())
+                .order(ByteOrder.nativeOrder());
+        handle = nativeCreate(buffer);
+    }
+
+    /**
+     * Copies {@code gamepad} into the shared buffer and decodes it.
+     *
+     * @return SFGP error code, {@code 0} on success.
+     * @throws IllegalStateException if this gamepad was closed.
+     */
+    public int update(Gamepad gamepad) {
+        if (handle == 0) {
+            throw new IllegalStateException("SfgpGamepad is closed");
+        }
+
+        buffer.putInt(ID_OFFSET, gamepad.getGamepadId());
+        buffer.putLong(TIMESTAMP_OFFSET, gamepad.timestamp);
+
+        buffer.putFloat(AXES_OFFSET, gamepad.left_stick_x);
+        buffer.putFloat(AXES_OFFSET + 4, gamepad.left_stick_y);
+        buffer.putFloat(AXES_OFFSET + 8, gamepad.right_stick_x);
+        buffer.putFloat(AXES_OFFSET + 12, gamepad.right_stick_y);
+        buffer.putFloat(AXES_OFFSET + 16, gamepad.left_trigger);
+        buffer.putFloat(AXES_OFFSET + 20, gamepad.right_trigger);
+
+        int buttons = 0;
+        if (gamepad.touchpad_finger_1) buttons |= TOUCHPAD_FINGER_1;
+        if (gamepad.touchpad_finger_2) buttons |= TOUCHPAD_FINGER_2;
+        if (gamepad.touchpad) buttons |= TOUCHPAD;
+        if (gamepad.left_stick_button) buttons |= LEFT_STICK_BUTTON;
+        if (gamepad.right_stick_button) buttons |= RIGHT_STICK_BUTTON;
+        if (gamepad.dpad_up) buttons |= DPAD_UP;
+        if (gamepad.dpad_down) buttons |= DPAD_DOWN;
+        if (gamepad.dpad_left) buttons |= DPAD_LEFT;
+        if (gamepad.dpad_right) buttons |= DPAD_RIGHT;
+        if (gamepad.a) buttons |= A;
+        if (gamepad.b) buttons |= B;
+        if (gamepad.x) buttons |= X;
+        if (gamepad.y) buttons |= Y;
+        if (gamepad.guide) buttons |= GUIDE;
+        if (gamepad.start) buttons |= START;
+        if (gamepad.back) buttons |= BACK;
+        if (gamepad.left_bumper) buttons |= LEFT_BUMPER;
+        if (gamepad.right_bumper) buttons |= RIGHT_BUMPER;
+        buffer.putInt(BUTTONS_OFFSET, buttons);
+
+        return nativeUpdate(handle);
+    }
+
+    /** Mask of every button currently held. */
+    public int pressedMask() {
+        return buffer.getInt(MASKS_OFFSET);
+    }
+
+    /** Mask of every button pressed since the last update. */
+    public int justPressedMask() {
+        return buffer.getInt(MASKS_OFFSET + 4);
+    }
+
+    /** Mask of every button released since the last update. */
+    public int justReleasedMask() {
+        return buffer.getInt(MASKS_OFFSET + 8);
+    }
+
+    /** Whether every button of {@code mask} is held. */
+    public boolean pressed(int mask) {
+        return (pressedMask() & mask) == mask;
+    }
+
+    /** Whether every button of {@code mask} is held and one was just pressed. */
+    public boolean justPressed(int mask) {
+        return pressed(mask) && (justPressedMask() & mask) != 0;
+    }
+
+    /** Whether any button of {@code mask} was just released. */
+    public boolean justReleased(int mask) {
+        return (justReleasedMask() & mask) != 0;
+    }
+
+    @Override
+    public void close() {
+        nativeDestroy(handle);
+        handle = 0;
+    }
+
+    private static native int nativeBufferSize();
+    private static native long nativeCreate(ByteBuffer buffer);
+    private static native void nativeDestroy(long handle);
+    private static native int nativeUpdate(long handle);
+}
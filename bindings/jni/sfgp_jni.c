@@ -0,0 +1,112 @@
+/**
+ * @file sfgp_jni.c
+ * @brief JNI binding of SFGP for the FTC SDK.
+ *
+ * The Java side (see java/sftk/sfgp/SfgpGamepad.java) owns one direct
+ * `ByteBuffer` per gamepad and writes the SDK gamepad into it in place each
+ * loop. The address of that buffer is resolved once on creation, so an update
+ * is a single JNI crossing that reads the frame and writes back the button
+ * masks without allocating or copying any Java arrays.
+ *
+ * Buffer layout, in native byte order:
+ *
+ *     [0, SFGP_FRAME_SIZE)                 gamepad data array
+ *     [SFGP_JNI_MASKS_OFFSET + 0, + 4)     pressed button mask
+ *     [SFGP_JNI_MASKS_OFFSET + 4, + 8)     just pressed button mask
+ *     [SFGP_JNI_MASKS_OFFSET + 8, + 12)    just released button mask
+ */
+
+
+#include <sftk/sfgp.h>
+
+#include <jni.h>
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+#define SFGP_JNI_MASKS_OFFSET   SFGP_FRAME_SIZE
+#define SFGP_JNI_BUFFER_SIZE    (SFGP_JNI_MASKS_OFFSET + (3 * sizeof (uint32_t)))
+
+
+/**
+ * @brief Native state behind every Java `SfgpGamepad`.
+ */
+typedef struct SFGP_JniGamepad {
+    SFGP_Gamepad pad;
+    SFGP_GamepadStorage storage;
+    uint8_t *buffer;    /**< Address of the Java side's direct buffer. */
+} SFGP_JniGamepad;
+
+
+static void _SFGP_JniThrow(JNIEnv *env, const char *class_name,
+        const char *message) {
+    jclass cls = (*env)->FindClass(env, class_name);
+    if (cls != NULL) (*env)->ThrowNew(env, cls, message);
+}
+
+
+JNIEXPORT jint JNICALL Java_sftk_sfgp_SfgpGamepad_nativeBufferSize(
+        JNIEnv *env, jclass cls) {
+    (void) env;
+    (void) cls;
+    return (jint) SFGP_JNI_BUFFER_SIZE;
+}
+
+JNIEXPORT jlong JNICALL Java_sftk_sfgp_SfgpGamepad_nativeCreate(
+        JNIEnv *env, jclass cls, jobject buffer) {
+    (void) cls;
+
+    uint8_t *address = (*env)->GetDirectBufferAddress(env, buffer);
+    if (address == NULL
+            || (*env)->GetDirectBufferCapacity(env, buffer)
+                < (jlong) SFGP_JNI_BUFFER_SIZE) {
+        _SFGP_JniThrow(env, "java/lang/IllegalArgumentException",
+                "SFGP requires a direct ByteBuffer of nativeBufferSize() bytes");
+        return 0;
+    }
+
+    SFGP_JniGamepad *self = malloc(sizeof (*self));
+    if (self == NULL) {
+        _SFGP_JniThrow(env, "java/lang/OutOfMemoryError",
+                "Failed to allocate SFGP gamepad");
+        return 0;
+    }
+
+    SFGP_InitGamepadWithStorage(&self->pad, &self->storage);
+    self->buffer = address;
+    memset(address, 0, SFGP_JNI_BUFFER_SIZE);
+
+    return (jlong) (intptr_t) self;
+}
+
+JNIEXPORT void JNICALL Java_sftk_sfgp_SfgpGamepad_nativeDestroy(
+        JNIEnv *env, jclass cls, jlong handle) {
+    (void) env;
+    (void) cls;
+
+    SFGP_JniGamepad *self = (SFGP_JniGamepad *) (intptr_t) handle;
+    if (self == NULL) return;
+
+    SFGP_DeinitGamepad(&self->pad);
+    free(self);
+}
+
+JNIEXPORT jint JNICALL Java_sftk_sfgp_SfgpGamepad_nativeUpdate(
+        JNIEnv *env, jclass cls, jlong handle) {
+    (void) env;
+    (void) cls;
+
+    SFGP_JniGamepad *self = (SFGP_JniGamepad *) (intptr_t) handle;
+    const SFGP_Error error = SFGP_UpdateGamepad(&self->pad, self->buffer);
+
+    const uint32_t masks[3] = {
+        SFGP_GetButtonsPressed(&self->pad),
+        SFGP_GetButtonsJustPressed(&self->pad),
+        SFGP_GetButtonsJustReleased(&self->pad),
+    };
+    memcpy(&self->buffer[SFGP_JNI_MASKS_OFFSET], masks, sizeof (masks));
+
+    return (jint) error;
+}
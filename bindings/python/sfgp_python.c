@@ -0,0 +1,325 @@
+/**
+ * @file sfgp_python.c
+ * @brief Python binding of SFGP batch decoding, for analysis of recorded
+ * gamepad frames with NumPy.
+ *
+ * Frames are read in place through the buffer protocol, so `bytes`,
+ * `mmap`, and NumPy arrays, memory mapped ones included, are decoded without
+ * being copied first. Accepted layouts:
+ *
+ *     1-D bytes       N * SFGP_FRAME_SIZE packed frames
+ *     2-D bytes       N rows of at least SFGP_FRAME_SIZE bytes, any row stride
+ *     1-D records     N elements of at least SFGP_FRAME_SIZE bytes each, such
+ *                     as a structured dtype whose first 40 bytes are a frame
+ *
+ * Every output is a NumPy array that @ref SFGP_DecodeFrames() writes into
+ * directly, with the GIL released while it runs.
+ */
+
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#define NPY_NO_DEPRECATED_API NPY_1_7_API_VERSION
+#include <numpy/arrayobject.h>
+
+#include <sftk/sfgp.h>
+
+#include <stdint.h>
+#include <stddef.h>
+
+
+static const char *const _SFGP_PY_AXIS_NAMES[SFGP_AXIS_ELEM] = {
+    "AXIS_LEFT_X", "AXIS_LEFT_Y", "AXIS_RIGHT_X", "AXIS_RIGHT_Y",
+    "AXIS_LEFT_TRIGGER", "AXIS_RIGHT_TRIGGER",
+};
+
+static const char *const _SFGP_PY_BUTTON_NAMES[SFGP_BUTTON_ELEM] = {
+    "BUTTON_TOUCHPAD_FINGER_1", "BUTTON_TOUCHPAD_FINGER_2", "BUTTON_TOUCHPAD",
+    "BUTTON_STICK_LEFT", "BUTTON_STICK_RIGHT",
+    "BUTTON_DPAD_UP", "BUTTON_DPAD_DOWN", "BUTTON_DPAD_LEFT",
+    "BUTTON_DPAD_RIGHT",
+    "BUTTON_A", "BUTTON_B", "BUTTON_X", "BUTTON_Y",
+    "BUTTON_GUIDE", "BUTTON_START", "BUTTON_BACK",
+    "BUTTON_BUMPER_LEFT", "BUTTON_BUMPER_RIGHT",
+};
+
+
+/**
+ * @brief Finds the frame stride of buffer \p view.
+ *
+ * @returns Number of frames, or -1 with an exception set.
+ */
+static Py_ssize_t _SFGP_PyGetFrames(const Py_buffer *const view,
+        size_t *const stride) {
+    const Py_ssize_t item = view->itemsize;
+
+    if (view->ndim == 1 && item == 1 && view->strides[0] == 1) {
+        if (view->shape[0] % SFGP_FRAME_SIZE != 0) {
+            PyErr_Format(PyExc_ValueError,
+                    "frames must be a multiple of %d bytes", SFGP_FRAME_SIZE);
+            return -1;
+        }
+
+        *stride = SFGP_FRAME_SIZE;
+        return view->shape[0] / SFGP_FRAME_SIZE;
+    }
+
+    if (view->ndim == 1 && item >= SFGP_FRAME_SIZE
+            && view->strides[0] >= item) {
+        *stride = (size_t) view->strides[0];
+        return view->shape[0];
+    }
+
+    if (view->ndim == 2 && item == 1 && view->strides[1] == 1
+            && view->shape[1] >= SFGP_FRAME_SIZE
+            && view->strides[0] >= view->shape[1]) {
+        *stride = (size_t) view->strides[0];
+        return view->shape[0];
+    }
+
+    PyErr_Format(PyExc_ValueError, "frames must be packed bytes, rows of at "
+            "least %d bytes, or records of at least %d bytes",
+            SFGP_FRAME_SIZE, SFGP_FRAME_SIZE);
+    return -1;
+}
+
+/**
+ * @brief Returns array \p key of \p out, checking it can take \p count
+ * elements per row of \p rows rows.
+ *
+ * Borrowed reference, or `NULL` with an exception set.
+ */
+static PyArrayObject *_SFGP_PyGetOutput(PyObject *const out,
+        const char *const key, int type, npy_intp rows, npy_intp count) {
+    PyObject *const obj = PyDict_GetItemString(out, key);
+    if (obj == NULL) {
+        PyErr_Format(PyExc_KeyError, "out is missing '%s'", key);
+        return NULL;
+    }
+
+    PyArrayObject *const array = (PyArrayObject *) obj;
+    const int ndim = (rows > 0) ? 2 : 1;
+
+    if (!PyArray_Check(obj) || PyArray_TYPE(array) != type
+            || PyArray_NDIM(array) != ndim
+            || !PyArray_IS_C_CONTIGUOUS(array) || !PyArray_ISWRITEABLE(array)
+            || (rows > 0 && PyArray_DIM(array, 0) != rows)
+            || PyArray_DIM(array, ndim - 1) < count) {
+        PyErr_Format(PyExc_ValueError, "out['%s'] must be a writeable "
+                "C-contiguous %s array of at least %zd frames", key,
+                (type == NPY_FLOAT32) ? "float32"
+                : (type == NPY_INT64) ? "int64" : "uint32", (Py_ssize_t) count);
+        return NULL;
+    }
+
+    return array;
+}
+
+/**
+ * @brief Creates dict of output arrays for \p count frames.
+ *
+ * New reference, or `NULL` with an exception set.
+ */
+static PyObject *_SFGP_PyNewOutput(npy_intp count) {
+    const npy_intp axes_shape[2] = { SFGP_AXIS_ELEM, count };
+    const struct {
+        const char *key;
+        int type;
+        int ndim;
+        const npy_intp *shape;
+    } fields[] = {
+        { "axes", NPY_FLOAT32, 2, axes_shape },
+        { "timestamps", NPY_INT64, 1, &count },
+        { "buttons", NPY_UINT32, 1, &count },
+        { "just_pressed", NPY_UINT32, 1, &count },
+        { "just_released", NPY_UINT32, 1, &count },
+    };
+
+    PyObject *const out = PyDict_New();
+    if (out == NULL) return NULL;
+
+    for (size_t i = 0; i < sizeof (fields) / sizeof (*fields); ++i) {
+        PyObject *const array = PyArray_SimpleNew(fields[i].ndim,
+                (npy_intp *) fields[i].shape, fields[i].type);
+        if (array == NULL
+                || PyDict_SetItemString(out, fields[i].key, array) < 0) {
+            Py_XDECREF(array);
+            Py_DECREF(out);
+            return NULL;
+        }
+
+        Py_DECREF(array);
+    }
+
+    return out;
+}
+
+
+PyDoc_STRVAR(_SFGP_PyDecodeFramesDoc,
+"decode_frames(frames, previous=0, out=None)\n"
+"--\n"
+"\n"
+"Decodes consecutive gamepad data arrays of a single gamepad.\n"
+"\n"
+"frames is any buffer of packed frames, rows of frames, or records starting\n"
+"with a frame, and is read in place. Button edges of the first frame are\n"
+"taken against the mask previous, typically the last of the previous call.\n"
+"\n"
+"Returns out, or a new dict if not given, holding:\n"
+"\n"
+"    axes            float32 (6, N), by AXIS_* index\n"
+"    timestamps      int64 (N,)\n"
+"    buttons         uint32 (N,), pressed button masks\n"
+"    just_pressed    uint32 (N,)\n"
+"    just_released   uint32 (N,)\n"
+"\n"
+"Arrays of out may be longer than N, leaving the rest untouched.");
+
+static PyObject *_SFGP_PyDecodeFrames(PyObject *self, PyObject *args,
+        PyObject *kwargs) {
+    (void) self;
+
+    static char *keywords[] = { "frames", "previous", "out", NULL };
+    PyObject *frames_obj, *out = Py_None;
+    unsigned long previous = 0;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O|kO", keywords,
+                &frames_obj, &previous, &out)) {
+        return NULL;
+    }
+
+    if (out != Py_None && !PyDict_Check(out)) {
+        PyErr_SetString(PyExc_TypeError, "out must be a dict");
+        return NULL;
+    }
+
+    Py_buffer view;
+    if (PyObject_GetBuffer(frames_obj, &view, PyBUF_STRIDED_RO) < 0)
+        return NULL;
+
+    size_t stride;
+    const Py_ssize_t count = _SFGP_PyGetFrames(&view, &stride);
+    if (count < 0) {
+        PyBuffer_Release(&view);
+        return NULL;
+    }
+
+    if (out == Py_None) {
+        out = _SFGP_PyNewOutput(count);
+    } else {
+        Py_INCREF(out);
+    }
+
+    if (out == NULL) {
+        PyBuffer_Release(&view);
+        return NULL;
+    }
+
+    PyArrayObject *const axes = _SFGP_PyGetOutput(out, "axes", NPY_FLOAT32,
+            SFGP_AXIS_ELEM, count);
+    PyArrayObject *const timestamps = (axes == NULL) ? NULL
+        : _SFGP_PyGetOutput(out, "timestamps", NPY_INT64, 0, count);
+    PyArrayObject *const buttons = (timestamps == NULL) ? NULL
+        : _SFGP_PyGetOutput(out, "buttons", NPY_UINT32, 0, count);
+    PyArrayObject *const pressed = (buttons == NULL) ? NULL
+        : _SFGP_PyGetOutput(out, "just_pressed", NPY_UINT32, 0, count);
+    PyArrayObject *const released = (pressed == NULL) ? NULL
+        : _SFGP_PyGetOutput(out, "just_released", NPY_UINT32, 0, count);
+
+    if (released == NULL) {
+        PyBuffer_Release(&view);
+        Py_DECREF(out);
+        return NULL;
+    }
+
+    SFGP_FrameBatch batch = {
+        .timestamps = PyArray_DATA(timestamps),
+        .buttons = PyArray_DATA(buttons),
+        .just_pressed = PyArray_DATA(pressed),
+        .just_released = PyArray_DATA(released),
+    };
+
+    for (int i = 0; i < SFGP_AXIS_ELEM; ++i)
+        batch.axes[i] = PyArray_GETPTR2(axes, i, 0);
+
+    Py_BEGIN_ALLOW_THREADS
+    SFGP_DecodeFrames(view.buf, stride, (size_t) count, (uint32_t) previous,
+            &batch);
+    Py_END_ALLOW_THREADS
+
+    PyBuffer_Release(&view);
+    return out;
+}
+
+
+PyDoc_STRVAR(_SFGP_PySetBatchKernelDoc,
+"set_batch_kernel(kernel)\n"
+"--\n"
+"\n"
+"Selects the KERNEL_* used by decode_frames(), returning the one actually\n"
+"used.");
+
+static PyObject *_SFGP_PySetBatchKernel(PyObject *self, PyObject *arg) {
+    (void) self;
+
+    const long kernel = PyLong_AsLong(arg);
+    if (kernel == -1 && PyErr_Occurred()) return NULL;
+    if (kernel < SFGP_BATCH_KERNEL_AUTO || kernel > SFGP_BATCH_KERNEL_AVX2) {
+        PyErr_SetString(PyExc_ValueError, "unknown batch kernel");
+        return NULL;
+    }
+
+    return PyLong_FromLong(SFGP_SetBatchKernel((SFGP_BatchKernel) kernel));
+}
+
+
+static PyMethodDef _SFGP_PY_METHODS[] = {
+    { "decode_frames", (PyCFunction) (void (*)(void)) _SFGP_PyDecodeFrames,
+        METH_VARARGS | METH_KEYWORDS, _SFGP_PyDecodeFramesDoc },
+    { "set_batch_kernel", _SFGP_PySetBatchKernel, METH_O,
+        _SFGP_PySetBatchKernelDoc },
+    { NULL, NULL, 0, NULL },
+};
+
+static struct PyModuleDef _SFGP_PY_MODULE = {
+    PyModuleDef_HEAD_INIT,
+    .m_name = "sfgp",
+    .m_doc = "Batch decoding of recorded FTC SDK gamepad data arrays.",
+    .m_size = -1,
+    .m_methods = _SFGP_PY_METHODS,
+};
+
+
+PyMODINIT_FUNC PyInit_sfgp(void) {
+    import_array();
+
+    PyObject *const module = PyModule_Create(&_SFGP_PY_MODULE);
+    if (module == NULL) return NULL;
+
+    int error = PyModule_AddIntConstant(module, "FRAME_SIZE", SFGP_FRAME_SIZE);
+    error |= PyModule_AddIntConstant(module, "KERNEL_AUTO",
+            SFGP_BATCH_KERNEL_AUTO);
+    error |= PyModule_AddIntConstant(module, "KERNEL_SCALAR",
+            SFGP_BATCH_KERNEL_SCALAR);
+    error |= PyModule_AddIntConstant(module, "KERNEL_SSE2",
+            SFGP_BATCH_KERNEL_SSE2);
+    error |= PyModule_AddIntConstant(module, "KERNEL_AVX2",
+            SFGP_BATCH_KERNEL_AVX2);
+
+    for (int i = 0; i < SFGP_AXIS_ELEM; ++i)
+        error |= PyModule_AddIntConstant(module, _SFGP_PY_AXIS_NAMES[i], i);
+
+    // Masks rather than indexes, to test the button arrays against directly.
+    for (int i = 0; i < SFGP_BUTTON_ELEM; ++i) {
+        error |= PyModule_AddIntConstant(module, _SFGP_PY_BUTTON_NAMES[i],
+                (long) SFGP_BUTTON_MASK(i));
+    }
+
+    if (error) {
+        Py_DECREF(module);
+        return NULL;
+    }
+
+    return module;
+}
@@ -16,9 +16,6 @@
  */
 
 
-// TODO: PS Support for buttons and triggers.
-
-
 #ifndef __SFTK_SFGP_HEADER__
 #define __SFTK_SFGP_HEADER__
 
@@ -28,6 +25,7 @@
 
 
 #include <stdint.h>
+#include <stddef.h>
 
 
 #if _WIN32
@@ -50,7 +48,16 @@
  */
 typedef enum SFGP_Error {
     SFGP_ERROR_OK = 0,
-    SFGP_ERROR_FAILED_ALLOCATION = -100
+    SFGP_ERROR_FAILED_ALLOCATION = -100,
+    SFGP_ERROR_EVENTS_TRUNCATED = -101,
+    SFGP_ERROR_IO = -102,
+    SFGP_ERROR_INVALID_FILE = -103,
+    SFGP_ERROR_UNSUPPORTED = -104,
+    SFGP_ERROR_MALFORMED_FRAME = -105,
+    SFGP_ERROR_UNSUPPORTED_VERSION = -106,
+    SFGP_ERROR_REGISTRY_FULL = -107,
+    SFGP_ERROR_RING_FULL = -108,
+    SFGP_ERROR_BUFFER_FULL = -109
 } SFGP_Error;
 
 
@@ -58,7 +65,8 @@ typedef enum SFGP_Error {
  * @brief Returns latest error reported by module.
  * 
  * Returns latest error reported by module before setting its internal error
- * state back to @ref SFGP_ERROR_OK.
+ * state back to @ref SFGP_ERROR_OK. Error state is kept per thread, so only
+ * errors raised by procedures called from the calling thread are returned.
  * 
  * @returns Latest error code.
  */
@@ -112,8 +120,32 @@ SFGP_EXPORT int8_t SFGP_IsTriggerReleased(const SFGP_Trigger *const self);
 SFGP_EXPORT int8_t SFGP_IsTriggerJustReleased(const SFGP_Trigger *const self);
 
 SFGP_EXPORT float SFGP_GetTriggerValue(const SFGP_Trigger *const self);
+
+/**
+ * @brief Returns trigger value as received, before any @ref SFGP_Shaper.
+ */
+SFGP_EXPORT float SFGP_GetTriggerRawValue(const SFGP_Trigger *const self);
+
+/**
+ * @brief Returns rate of change of trigger value in units per second.
+ *
+ * Computed from the timestamps embedded in the frames, so the result does not
+ * depend on how often the gamepad is updated. Frames repeating the previous
+ * timestamp leave it unchanged.
+ */
 SFGP_EXPORT float SFGP_GetTriggerVelocity(const SFGP_Trigger *const self);
 
+/**
+ * @brief Returns rate of change of trigger velocity in units per second
+ * squared.
+ *
+ * 0 until two velocities were taken over consecutive frames, so the first
+ * rate after init or a repeated timestamp does not show up as a spike.
+ *
+ * @see SFGP_GetTriggerVelocity()
+ */
+SFGP_EXPORT float SFGP_GetTriggerAcceleration(const SFGP_Trigger *const self);
+
 
 // ============================================================================
 //
@@ -139,7 +171,9 @@ SFGP_EXPORT int8_t SFGP_IsXAtZero(const SFGP_Joystick *const self);
 SFGP_EXPORT int8_t SFGP_IsXJustAtZero(const SFGP_Joystick *const self);
 
 SFGP_EXPORT float SFGP_GetXValue(const SFGP_Joystick *const self);
+SFGP_EXPORT float SFGP_GetXRawValue(const SFGP_Joystick *const self);
 SFGP_EXPORT float SFGP_GetXVelocity(const SFGP_Joystick *const self);
+SFGP_EXPORT float SFGP_GetXAcceleration(const SFGP_Joystick *const self);
 
 SFGP_EXPORT int8_t SFGP_IsYAtMax(const SFGP_Joystick *const self);
 SFGP_EXPORT int8_t SFGP_IsYJustAtMax(const SFGP_Joystick *const self);
@@ -151,7 +185,9 @@ SFGP_EXPORT int8_t SFGP_IsYAtZero(const SFGP_Joystick *const self);
 SFGP_EXPORT int8_t SFGP_IsYJustAtZero(const SFGP_Joystick *const self);
 
 SFGP_EXPORT float SFGP_GetYValue(const SFGP_Joystick *const self);
+SFGP_EXPORT float SFGP_GetYRawValue(const SFGP_Joystick *const self);
 SFGP_EXPORT float SFGP_GetYVelocity(const SFGP_Joystick *const self);
+SFGP_EXPORT float SFGP_GetYAcceleration(const SFGP_Joystick *const self);
 
 
 // ============================================================================
@@ -228,16 +264,122 @@ typedef enum SFGP_ButtonIndex {
     SFGP_BUTTON_ELEM
 } SFGP_ButtonIndex;
 
+/**
+ * @brief Bit representing button \p index within a button mask.
+ *
+ * Button masks use the same bit layout as the gamepad byte array, with the
+ * first @ref SFGP_ButtonIndex occupying the highest bit. Masks for several
+ * buttons can be combined with `|`.
+ *
+ * @see SFGP_GetButtonsPressed()
+ */
+#define SFGP_BUTTON_MASK(index) \
+    (UINT32_C(1) << (SFGP_BUTTON_ELEM - 1 - (index)))
 
-/** 
+/**
+ * @brief Every analog axis of a gamepad.
+ * @note These are organized in order in which they should appear in the passed
+ * gamepad data array.
+ *
+ * @see SFGP_FrameBatch
+ */
+typedef enum SFGP_AxisIndex {
+    SFGP_AXIS_LEFT_X,
+    SFGP_AXIS_LEFT_Y,
+    SFGP_AXIS_RIGHT_X,
+    SFGP_AXIS_RIGHT_Y,
+
+    SFGP_AXIS_LEFT_TRIGGER,
+    SFGP_AXIS_RIGHT_TRIGGER,
+
+    SFGP_AXIS_ELEM
+} SFGP_AxisIndex;
+
+/**
+ * @brief Ticks per second of timestamps embedded in gamepad data arrays.
+ *
+ * The FTC SDK stamps gamepads with `SystemClock.uptimeMillis()`.
+ */
+#define SFGP_TIMESTAMP_HZ 1000
+
+/**
+ * @brief Size in bytes of a single gamepad data array.
+ *
+ * 4 bytes of gamepad ID, 8 bytes of timestamp, 6 axes, and the button bits.
+ */
+#define SFGP_FRAME_SIZE 40
+
+/**
+ * @brief Fingers tracked by the touchpad of PS controllers.
+ */
+typedef enum SFGP_TouchpadFinger {
+    SFGP_FINGER_1,
+    SFGP_FINGER_2,
+
+    SFGP_FINGER_ELEM
+} SFGP_TouchpadFinger;
+
+/**
+ * @brief Latest version of the FTC SDK gamepad payload understood by
+ * @ref SFGP_DecodeGamepad().
+ *
+ * | Version | Size | Adds                                 |
+ * | ------- | ---- | ------------------------------------ |
+ * | 1       | 41   | version byte and gamepad data array  |
+ * | 2       | 42   | `GamepadUser` byte                   |
+ * | 3       | 43   | legacy `GamepadType` byte            |
+ * | 4       | 44   | `GamepadType` byte                   |
+ * | 5       | 60   | touchpad finger 1 and 2 x, y floats  |
+ */
+#define SFGP_PAYLOAD_VERSION_MAX 5
+
+/**
+ * @brief Size in bytes of the largest payload @ref SFGP_DecodeGamepad() reads.
+ */
+#define SFGP_PAYLOAD_SIZE_MAX 60
+
+
+/**
+ * @brief Size in bytes of @ref SFGP_GamepadStorage.
+ *
+ * Large enough to hold every button, trigger, and joystick of a single
+ * gamepad inline, spanning four cache lines when placed on a 64 byte
+ * boundary. The six axes alone take 144 bytes, so queries over a whole pad
+ * cannot fit in two lines without dropping per-axis state. Instead, all they
+ * read sits in the first three lines, and the fourth only holds touchpad and
+ * payload fields. Rounding up to 256 bytes keeps arrays of storage on line
+ * boundaries.
+ */
+#define SFGP_GAMEPAD_STORAGE_SIZE 256
+
+/**
+ * @brief Contiguous block holding the entire state of a single gamepad.
+ *
+ * The layout is internal to SFGP, but the block contains no pointers and may
+ * be freely copied (see @ref SFGP_CopyGamepad()). It can be declared
+ * statically or carved out of an arena and handed to
+ * @ref SFGP_InitGamepadWithStorage() so that no heap allocation takes place.
+ */
+typedef union SFGP_GamepadStorage {
+    uint8_t bytes[SFGP_GAMEPAD_STORAGE_SIZE];
+    uint64_t words[SFGP_GAMEPAD_STORAGE_SIZE / sizeof (uint64_t)];
+} SFGP_GamepadStorage;
+
+
+/**
  * @brief Gamepad data intended to be accessed by end user of SFGP.
- * 
+ *
  * This struct contains all Buttons, Triggers, and Joysticks found on the
- * minimum competition-compliant controllers.
- * 
- * @note PS Controller and rumble support has not been added as of current.
- * Please use respective bindings in order to access your gamepad directly to
- * access these features.
+ * minimum competition-compliant controllers. Every member points into a
+ * single @ref SFGP_GamepadStorage block.
+ *
+ * PS controller touchpad coordinates and the other fields of newer SDK
+ * payloads are available through @ref SFGP_DecodeGamepad() and the getters
+ * following it.
+ *
+ * @note Rumble and LED support has not been added as of current. Please use
+ * respective bindings in order to access your gamepad directly to access
+ * these features.
  */
 typedef struct SFGP_Gamepad {
     // unions for easier initialization and updating values. Could also be used
@@ -290,30 +432,1802 @@ typedef struct SFGP_Gamepad {
             SFGP_Button *right_bumper;
         };
     };
+
+    SFGP_GamepadStorage *storage;       /**< Block all of the above live
+                                          *  in. */
+    struct SFGP_EventBuffer *events;    /**< See
+                                          *  @ref SFGP_AttachEventBuffer(). */
+    struct SFGP_History *history;       /**< See @ref SFGP_AttachHistory(). */
+    struct SFGP_Matcher *matcher;       /**< See @ref SFGP_AttachMatcher(). */
+    const struct SFGP_Shaper *shaper;   /**< See @ref SFGP_AttachShaper(). */
+    struct SFGP_FilterBank *filters;    /**< See
+                                          *  @ref SFGP_AttachFilterBank(). */
+    struct SFGP_Stats *stats;           /**< See @ref SFGP_AttachStats(). */
+    uint8_t owns_storage;               /**< Set if storage was allocated by
+                                          *  @ref SFGP_InitGamepad(). */
 } SFGP_Gamepad;
 
 
 /**
  * @brief Initailizes internals of gamepad.
- * 
- * Allocates button, trigger, and joysticks arrays to be accessed directly by
- * end user. If an error does occur, its probably for the best that you end the
- * application prematurely.
- * 
+ *
+ * Allocates a single @ref SFGP_GamepadStorage block holding the button,
+ * trigger, and joystick state to be accessed directly by end user. If an
+ * error does occur, its probably for the best that you end the application
+ * prematurely.
+ *
  * @param[in]   pad: Pointer to gamepad object with members to be allocated
  *              and initialized.
- * 
- * @returns `SFGP_ERROR_OK` if everything goes ok, a negative error code if 
+ *
+ * @returns `SFGP_ERROR_OK` if everything goes ok, a negative error code if
  * otherwise.
- * 
+ *
  * @note This function does not check for `NULL` pointers on release.
  */
 SFGP_EXPORT SFGP_Error SFGP_InitGamepad(SFGP_Gamepad *const pad);
+
+/**
+ * @brief Initializes gamepad over caller provided storage.
+ *
+ * Same as @ref SFGP_InitGamepad(), except all state is placed within
+ * \p storage and the heap is never touched, so this cannot fail. \p storage is
+ * cleared and must outlive \p pad.
+ *
+ * @param[in]   pad: Pointer to gamepad object to be initialized.
+ * @param[in]   storage: Static, stack, or arena memory to hold gamepad state.
+ */
+SFGP_EXPORT void SFGP_InitGamepadWithStorage(SFGP_Gamepad *const pad,
+        SFGP_GamepadStorage *const storage);
+
+/**
+ * @brief Releases internals of gamepad.
+ *
+ * Storage handed over through @ref SFGP_InitGamepadWithStorage() is left
+ * untouched.
+ */
 SFGP_EXPORT void SFGP_DeinitGamepad(const SFGP_Gamepad *const pad);
 
+/**
+ * @brief Copies the entire state of \p src into \p dst.
+ *
+ * Both gamepads must already be initialized. Useful for taking snapshots
+ * which can then be queried like any other gamepad.
+ */
+SFGP_EXPORT void SFGP_CopyGamepad(SFGP_Gamepad *const dst,
+        const SFGP_Gamepad *const src);
+
+/**
+ * @brief Updates \p pad from a gamepad data array in host byte order.
+ *
+ * \p byte_array must hold at least @ref SFGP_FRAME_SIZE bytes laid out as
+ * described there. Nothing is validated beyond debug assertions, use
+ * @ref SFGP_DecodeGamepad() for data coming straight off the SDK.
+ *
+ * A frame identical to the latest one applied, timestamp included, leaves
+ * \p pad untouched, so `Just` queries keep reporting the edges of the
+ * original frame until a new one arrives. See
+ * @ref SFGP_GetGamepadGeneration().
+ *
+ * @returns `SFGP_ERROR_OK`.
+ */
 SFGP_EXPORT SFGP_Error SFGP_UpdateGamepad(SFGP_Gamepad *const pad, 
         const uint8_t *const byte_array);
 
+/**
+ * @brief Updates \p pad from a payload written by the SDK's
+ * `Gamepad.toByteArray()`.
+ *
+ * \p payload starts at the version byte, right after the 3 byte robocol
+ * header, and is big endian as written by Java. Every version up to
+ * @ref SFGP_PAYLOAD_VERSION_MAX is decoded with its full field set.
+ *
+ * \p pad is only touched if the whole frame is valid, and differs from the
+ * latest one applied as with @ref SFGP_UpdateGamepad().
+ *
+ * @param[in]   pad: Gamepad to update.
+ * @param[in]   payload: SDK gamepad payload.
+ * @param[in]   length: Number of readable bytes at \p payload.
+ *
+ * @returns `SFGP_ERROR_OK`, `SFGP_ERROR_UNSUPPORTED_VERSION` if the payload
+ * version is unknown, or `SFGP_ERROR_MALFORMED_FRAME` if \p length is too
+ * short for its version or an axis is out of range.
+ */
+SFGP_EXPORT SFGP_Error SFGP_DecodeGamepad(SFGP_Gamepad *const pad,
+        const uint8_t *const payload, size_t length);
+
+
+/**
+ * @brief Returns mask of every button currently held on \p pad.
+ * @see SFGP_BUTTON_MASK()
+ */
+SFGP_EXPORT uint32_t SFGP_GetButtonsPressed(const SFGP_Gamepad *const pad);
+
+/**
+ * @brief Returns mask of every button pressed since the last update.
+ * @see SFGP_BUTTON_MASK()
+ */
+SFGP_EXPORT uint32_t SFGP_GetButtonsJustPressed(const SFGP_Gamepad *const pad);
+
+/**
+ * @brief Returns mask of every button released since the last update.
+ * @see SFGP_BUTTON_MASK()
+ */
+SFGP_EXPORT uint32_t SFGP_GetButtonsJustReleased(
+        const SFGP_Gamepad *const pad);
+
+/**
+ * @brief Returns timestamp embedded in the latest frame passed to \p pad.
+ */
+SFGP_EXPORT int64_t SFGP_GetGamepadTimestamp(const SFGP_Gamepad *const pad);
+
+/**
+ * @brief Returns number of frames applied to \p pad since it was
+ * initialized.
+ *
+ * Only changes when an update actually changes the state of \p pad, so
+ * anything derived from a gamepad only needs recomputing when its generation
+ * differs from the one it was computed at. Wraps around after 2^32 frames.
+ */
+SFGP_EXPORT uint32_t SFGP_GetGamepadGeneration(const SFGP_Gamepad *const pad);
+
+/**
+ * @brief Returns gamepad ID embedded in the latest frame passed to \p pad.
+ */
+SFGP_EXPORT int32_t SFGP_GetGamepadId(const SFGP_Gamepad *const pad);
+
+/**
+ * @brief Returns payload version of the latest frame passed to \p pad.
+ *
+ * Frames passed through @ref SFGP_UpdateGamepad() count as version 1.
+ */
+SFGP_EXPORT uint8_t SFGP_GetGamepadVersion(const SFGP_Gamepad *const pad);
+
+/**
+ * @brief Returns SDK `GamepadUser` ID of \p pad, 0 before version 2.
+ */
+SFGP_EXPORT uint8_t SFGP_GetGamepadUser(const SFGP_Gamepad *const pad);
+
+/**
+ * @brief Returns SDK `GamepadType` ordinal of \p pad, 0 before version 4.
+ */
+SFGP_EXPORT uint8_t SFGP_GetGamepadType(const SFGP_Gamepad *const pad);
+
+/**
+ * @brief Returns x coordinate of touchpad \p finger, 0 before version 5.
+ */
+SFGP_EXPORT float SFGP_GetTouchpadX(const SFGP_Gamepad *const pad,
+        SFGP_TouchpadFinger finger);
+
+/**
+ * @brief Returns y coordinate of touchpad \p finger, 0 before version 5.
+ */
+SFGP_EXPORT float SFGP_GetTouchpadY(const SFGP_Gamepad *const pad,
+        SFGP_TouchpadFinger finger);
+
+
+// ============================================================================
+//
+//      Event:
+//      Compact list of everything that changed within a single update.
+//      
+// ============================================================================
+
+
+/**
+ * @brief Kinds of change reported by @ref SFGP_UpdateGamepadEvents().
+ *
+ * Each matches the `Just` query of the same name, so an event is emitted in
+ * exactly the updates that query would return true.
+ */
+typedef enum SFGP_EventEdge {
+    SFGP_EVENT_BUTTON_PRESSED,  /**< @ref SFGP_IsButtonJustPressed() */
+    SFGP_EVENT_BUTTON_RELEASED, /**< @ref SFGP_IsButtonJustReleased() */
+
+    SFGP_EVENT_AXIS_AT_MAX,     /**< @ref SFGP_IsXJustAtMax(),
+                                  *  @ref SFGP_IsTriggerJustPressed() */
+    SFGP_EVENT_AXIS_AT_MIN,     /**< @ref SFGP_IsXJustAtMin() */
+    SFGP_EVENT_AXIS_AT_ZERO     /**< @ref SFGP_IsXJustAtZero(),
+                                  *  @ref SFGP_IsTriggerJustReleased() */
+} SFGP_EventEdge;
+
+/**
+ * @brief Single change of a single control.
+ */
+typedef struct SFGP_Event {
+    int64_t timestamp;  /**< Timestamp of the frame the change happened in. */
+    float value;        /**< New value, 1 or 0 for buttons. */
+    uint8_t control;    /**< @ref SFGP_ButtonIndex for button edges,
+                          *  @ref SFGP_AxisIndex otherwise. */
+    uint8_t edge;       /**< @ref SFGP_EventEdge */
+} SFGP_Event;
+
+/**
+ * @brief Most events a single update can produce.
+ *
+ * Every button can change at once, while each axis reaches at most one of its
+ * limits.
+ */
+#define SFGP_MAX_EVENTS (SFGP_BUTTON_ELEM + SFGP_AXIS_ELEM)
+
+
+/**
+ * @brief Events collected over any number of updates.
+ *
+ * Once attached through @ref SFGP_AttachEventBuffer(), every frame applied to
+ * the gamepad appends its events, whichever call it came through. Read
+ * .events up to .count, then @ref SFGP_ClearEventBuffer().
+ */
+typedef struct SFGP_EventBuffer {
+    SFGP_Event *events;     /**< Destination of events. */
+    size_t capacity;        /**< Number of events .events can hold. */
+    size_t count;           /**< Events written since last cleared. */
+    int8_t truncated;       /**< Set if events were dropped for lack of
+                              *  room since last cleared. */
+} SFGP_EventBuffer;
+
+
+/**
+ * @brief Initializes an empty buffer writing to \p events.
+ *
+ * @param[out]  buffer: Buffer to initialize.
+ * @param[in]   events: Destination of events.
+ * @param[in]   capacity: Number of events \p events can hold.
+ */
+SFGP_EXPORT void SFGP_InitEventBuffer(SFGP_EventBuffer *const buffer,
+        SFGP_Event *const events, size_t capacity);
+
+/**
+ * @brief Empties \p buffer, clearing .truncated.
+ */
+SFGP_EXPORT void SFGP_ClearEventBuffer(SFGP_EventBuffer *const buffer);
+
+/**
+ * @brief Makes every following update of \p pad append to \p buffer.
+ *
+ * Passing `NULL` detaches any buffer from \p pad.
+ */
+SFGP_EXPORT void SFGP_AttachEventBuffer(SFGP_Gamepad *const pad,
+        SFGP_EventBuffer *const buffer);
+
+/**
+ * @brief Updates gamepad and lists every change it caused.
+ *
+ * Same as @ref SFGP_UpdateGamepad(), after which one @ref SFGP_Event is
+ * written to \p events per edge, buttons first and in index order. Most
+ * updates produce none, and a repeated frame never does. Any buffer attached
+ * to \p pad receives the same events.
+ *
+ * @param[in]   pad: Gamepad to update.
+ * @param[in]   byte_array: Gamepad data array.
+ * @param[out]  events: Destination of events.
+ * @param[in]   capacity: Number of events \p events can hold,
+ *              @ref SFGP_MAX_EVENTS is always enough.
+ * @param[out]  count: Number of events written.
+ *
+ * @returns `SFGP_ERROR_OK`, or `SFGP_ERROR_EVENTS_TRUNCATED` if more events
+ * occurred than fit in \p events.
+ */
+SFGP_EXPORT SFGP_Error SFGP_UpdateGamepadEvents(SFGP_Gamepad *const pad,
+        const uint8_t *const byte_array, SFGP_Event *const events,
+        size_t capacity, size_t *const count);
+
+
+
+// ============================================================================
+//
+//      Shared:
+//      Handing gamepad state from one thread over to others without locks.
+//      
+// ============================================================================
+
+
+/**
+ * @brief Gamepad updated by one thread and read by any number of others.
+ *
+ * The producer decodes into its own private gamepad and then publishes the
+ * whole state block under a sequence lock. The producer never waits, and
+ * consumers retry their copy in the rare case it raced with a publish, so
+ * every copy holds a matching last/current pair.
+ *
+ * @note Members are managed by the procedures below, do not access them
+ * directly.
+ */
+typedef struct SFGP_SharedGamepad {
+    SFGP_Gamepad producer;                  /**< Decoded into by producer. */
+    SFGP_GamepadStorage producer_storage;   /**< Storage of producer. */
+    SFGP_GamepadStorage published;          /**< Latest published state. */
+    uint32_t sequence;                      /**< Odd while publishing. */
+} SFGP_SharedGamepad;
+
+
+/**
+ * @brief Initializes \p shared, which cannot fail as nothing is allocated.
+ */
+SFGP_EXPORT void SFGP_InitSharedGamepad(SFGP_SharedGamepad *const shared);
+
+/**
+ * @brief Decodes \p byte_array and publishes the result.
+ *
+ * Must only ever be called from a single producer thread at a time. Never
+ * blocks.
+ *
+ * @returns Same as @ref SFGP_UpdateGamepad().
+ */
+SFGP_EXPORT SFGP_Error SFGP_UpdateSharedGamepad(
+        SFGP_SharedGamepad *const shared, const uint8_t *const byte_array);
+
+/**
+ * @brief Copies latest published state into \p dst.
+ *
+ * Safe to call from any number of threads concurrently with the producer.
+ * \p dst is then queried like any other gamepad.
+ *
+ * @param[in]   shared: Gamepad to read from.
+ * @param[out]  dst: Initialized gamepad owned by the calling thread.
+ */
+SFGP_EXPORT void SFGP_ReadSharedGamepad(const SFGP_SharedGamepad *const shared,
+        SFGP_Gamepad *const dst);
+
+
+// ============================================================================
+//
+//      Record:
+//      Capturing gamepad data arrays to disk and replaying them later.
+//      
+// ============================================================================
+
+
+/**
+ * @brief Appends gamepad data arrays to a recording file.
+ *
+ * Recording files consist of a header, every frame exactly as it was passed
+ * in, and an index of frame offsets written once the recording is closed.
+ *
+ * @note Members are managed by the procedures below, do not access them
+ * directly.
+ */
+typedef struct SFGP_Recorder {
+    void *file;         /**< `FILE *` being written to. */
+    uint64_t count;     /**< Frames recorded so far. */
+    uint64_t offset;    /**< Offset of next frame within file. */
+    uint64_t *index;    /**< Offset of every frame recorded so far. */
+    uint64_t capacity;  /**< Number of offsets index can hold. */
+} SFGP_Recorder;
+
+/**
+ * @brief Memory mapped recording file.
+ *
+ * Frames are handed out and decoded straight from the mapping without ever
+ * being copied.
+ */
+typedef struct SFGP_Replay {
+    const uint8_t *data;    /**< Mapped file. */
+    size_t size;            /**< Size of mapping in bytes. */
+    const uint64_t *index;  /**< Offset of every frame within data. */
+    uint64_t count;         /**< Number of frames. */
+    uint8_t owns_index;     /**< Set if index had to be rebuilt on open. */
+} SFGP_Replay;
+
+/**
+ * @brief Pacing of @ref SFGP_RunReplay().
+ */
+typedef enum SFGP_ReplayMode {
+    SFGP_REPLAY_UNTHROTTLED,    /**< As fast as frames can be decoded. */
+    SFGP_REPLAY_REAL_TIME       /**< Paced by the embedded timestamps. */
+} SFGP_ReplayMode;
+
+/**
+ * @brief Called by @ref SFGP_RunReplay() after each decoded frame.
+ *
+ * @returns Non-zero to stop the replay.
+ */
+typedef int (*SFGP_ReplayCallback)(SFGP_Gamepad *pad, uint64_t frame,
+        void *user);
+
+
+/**
+ * @brief Creates recording file at \p path, replacing any existing file.
+ *
+ * @returns `SFGP_ERROR_OK`, or `SFGP_ERROR_IO` if the file cannot be written.
+ */
+SFGP_EXPORT SFGP_Error SFGP_OpenRecorder(SFGP_Recorder *const rec,
+        const char *const path);
+
+/**
+ * @brief Appends a single gamepad data array of \p length bytes.
+ *
+ * @returns `SFGP_ERROR_OK`, `SFGP_ERROR_IO` if the file cannot be written, or
+ * `SFGP_ERROR_FAILED_ALLOCATION` if the index cannot grow.
+ */
+SFGP_EXPORT SFGP_Error SFGP_RecordFrame(SFGP_Recorder *const rec,
+        const uint8_t *const byte_array, size_t length);
+
+/**
+ * @brief Writes the frame index and closes the recording file.
+ *
+ * Files of recorders which were never closed can still be replayed, the index
+ * is then rebuilt when opened.
+ */
+SFGP_EXPORT SFGP_Error SFGP_CloseRecorder(SFGP_Recorder *const rec);
+
+
+/**
+ * @brief Maps recording file at \p path for replay.
+ *
+ * @returns `SFGP_ERROR_OK`, `SFGP_ERROR_IO` if the file cannot be mapped,
+ * `SFGP_ERROR_INVALID_FILE` if it is not a recording, or
+ * `SFGP_ERROR_UNSUPPORTED` on platforms without memory mapping.
+ */
+SFGP_EXPORT SFGP_Error SFGP_OpenReplay(SFGP_Replay *const replay,
+        const char *const path);
+
+SFGP_EXPORT void SFGP_CloseReplay(SFGP_Replay *const replay);
+
+/**
+ * @brief Returns frame number \p frame in place within the mapping.
+ *
+ * @param[in]   replay: Opened replay.
+ * @param[in]   frame: Index of frame, less than `replay->count`.
+ * @param[out]  length: Length of frame in bytes, may be `NULL`.
+ */
+SFGP_EXPORT const uint8_t *SFGP_GetReplayFrame(const SFGP_Replay *const replay,
+        uint64_t frame, size_t *const length);
+
+/**
+ * @brief Returns index of first frame stamped at or after \p timestamp.
+ *
+ * Frames are expected to be recorded in timestamp order. Returns
+ * `replay->count` if there is no such frame.
+ */
+SFGP_EXPORT uint64_t SFGP_FindReplayFrame(const SFGP_Replay *const replay,
+        int64_t timestamp);
+
+/**
+ * @brief Decodes every frame of \p replay into \p pad in order.
+ *
+ * @param[in]   replay: Opened replay.
+ * @param[in]   pad: Gamepad to decode into.
+ * @param[in]   mode: Pacing of frames.
+ * @param[in]   callback: Called after every frame, may be `NULL`.
+ * @param[in]   user: Passed along to \p callback.
+ *
+ * @returns `SFGP_ERROR_OK`, or `SFGP_ERROR_INVALID_FILE` on the first frame
+ * which is short or holds out of range axes.
+ */
+SFGP_EXPORT SFGP_Error SFGP_RunReplay(const SFGP_Replay *const replay,
+        SFGP_Gamepad *const pad, SFGP_ReplayMode mode,
+        SFGP_ReplayCallback callback, void *user);
+
+
+// ============================================================================
+//
+//      Batch:
+//      Decoding of many gamepad frames at once into structure-of-arrays form.
+//      
+// ============================================================================
+
+
+/**
+ * @brief Structure-of-arrays destination for @ref SFGP_DecodeFrames() and
+ * @ref SFGP_DecodeGamepadFrames().
+ *
+ * Every non-`NULL` array must hold at least as many elements as frames being
+ * decoded. Arrays left `NULL` are skipped, with the exception of `buttons`
+ * when used by @ref SFGP_DecodeGamepadFrames().
+ */
+typedef struct SFGP_FrameBatch {
+    float *axes[SFGP_AXIS_ELEM];    /**< Axis values, by @ref SFGP_AxisIndex. */
+    int64_t *timestamps;            /**< Timestamps embedded in each frame. */
+    uint32_t *buttons;              /**< Pressed button masks. */
+    uint32_t *just_pressed;         /**< Buttons pressed within each frame. */
+    uint32_t *just_released;        /**< Buttons released within each frame. */
+} SFGP_FrameBatch;
+
+/**
+ * @brief Implementations available to the batch decoder.
+ *
+ * All of these produce bit-identical results to @ref SFGP_UpdateGamepad().
+ */
+typedef enum SFGP_BatchKernel {
+    SFGP_BATCH_KERNEL_AUTO,     /**< Best kernel supported by the CPU. */
+    SFGP_BATCH_KERNEL_SCALAR,   /**< Portable C. */
+    SFGP_BATCH_KERNEL_SSE2,     /**< 4 frames per step, x86 only. */
+    SFGP_BATCH_KERNEL_AVX2      /**< 8 frames per step, x86 only. */
+} SFGP_BatchKernel;
+
+
+/**
+ * @brief Selects kernel used by the batch decoder.
+ *
+ * Kernels the CPU does not support fall back to the next best one.
+ *
+ * @param[in]   kernel: Requested kernel.
+ *
+ * @returns Kernel that will actually be used.
+ */
+SFGP_EXPORT SFGP_BatchKernel SFGP_SetBatchKernel(SFGP_BatchKernel kernel);
+
+/**
+ * @brief Decodes consecutive frames of a single gamepad.
+ *
+ * Button edges of each frame are relative to the frame before it, or to
+ * \p previous for the first one.
+ *
+ * @param[in]   frames: First of \p count gamepad data arrays.
+ * @param[in]   stride: Distance in bytes between two frames, at least
+ *              @ref SFGP_FRAME_SIZE.
+ * @param[in]   count: Number of frames to decode.
+ * @param[in]   previous: Button mask preceding the first frame, typically the
+ *              last mask of the previous batch.
+ * @param[out]  out: Arrays to decode into.
+ */
+SFGP_EXPORT void SFGP_DecodeFrames(const uint8_t *const frames, size_t stride,
+        size_t count, uint32_t previous, const SFGP_FrameBatch *const out);
+
+/**
+ * @brief Decodes one frame for each of \p count gamepads.
+ *
+ * Frame `i` belongs to gamepad `i`, whose state is element `i` of every array
+ * in \p out. Button edges are relative to the contents of `out->buttons`
+ * before the call, which is required.
+ *
+ * @param[in]   frames: First of \p count gamepad data arrays.
+ * @param[in]   stride: Distance in bytes between two frames, at least
+ *              @ref SFGP_FRAME_SIZE.
+ * @param[in]   count: Number of gamepads to decode.
+ * @param[in,out] out: Arrays to decode into.
+ */
+SFGP_EXPORT void SFGP_DecodeGamepadFrames(const uint8_t *const frames,
+        size_t stride, size_t count, const SFGP_FrameBatch *const out);
+
+
+
+// ============================================================================
+//
+//      History:
+//      Recent frames of a gamepad and timing queries over them.
+//      
+// ============================================================================
+
+
+/**
+ * @brief Default of @ref SFGP_History.window, in timestamp ticks.
+ */
+#define SFGP_HISTORY_WINDOW 1000
+
+/**
+ * @brief Default of @ref SFGP_History.double_tap, in timestamp ticks.
+ */
+#define SFGP_HISTORY_DOUBLE_TAP 250
+
+/**
+ * @brief Default of @ref SFGP_History.long_press, in timestamp ticks.
+ */
+#define SFGP_HISTORY_LONG_PRESS 500
+
+
+/**
+ * @brief Single frame kept by @ref SFGP_History.
+ */
+typedef struct SFGP_HistoryEntry {
+    int64_t timestamp;
+    float axes[SFGP_AXIS_ELEM];     /**< By @ref SFGP_AxisIndex. */
+    uint32_t buttons;               /**< Buttons held. */
+    uint32_t just_pressed;          /**< Buttons pressed on this frame. */
+} SFGP_HistoryEntry;
+
+/**
+ * @brief Ring of the most recent frames of a gamepad, along with per-button
+ * timing kept up to date as frames come in.
+ *
+ * Once attached through @ref SFGP_AttachHistory(), every update of the gamepad
+ * appends to the ring and advances the timing state, so every query below is
+ * O(1). Frames repeating the previous timestamp are merged into the newest
+ * entry, keeping the history independent of how often the gamepad is
+ * updated. All durations are measured between frame timestamps, in
+ * @ref SFGP_TIMESTAMP_HZ ticks.
+ *
+ * @note Only .window, .double_tap, and .long_press are meant to be changed,
+ * and only before the first frame arrives. Every other member is managed by
+ * the procedures below.
+ */
+typedef struct SFGP_History {
+    SFGP_HistoryEntry *entries;     /**< Caller provided ring. */
+    size_t capacity;                /**< Entries in ring. */
+    size_t head;                    /**< Entry written next. */
+    size_t length;                  /**< Entries filled. */
+    size_t counted;                 /**< Newest entries within .window. */
+
+    int64_t window;         /**< Span of @ref SFGP_GetPressCount(), > 0. */
+    int64_t double_tap;     /**< Max time between presses of a double tap. */
+    int64_t long_press;     /**< Min time held for a long press. */
+
+    int64_t press_time[SFGP_BUTTON_ELEM];   /**< Timestamp of latest press. */
+    uint16_t presses[SFGP_BUTTON_ELEM];     /**< Presses within .window. */
+
+    uint32_t pressed_once;          /**< Buttons pressed at least once. */
+    uint32_t double_tapped;         /**< Double taps on newest frame. */
+    uint32_t long_pressed;          /**< Buttons held past .long_press. */
+    uint32_t long_pressed_last;     /**< .long_pressed before newest frame. */
+} SFGP_History;
+
+
+/**
+ * @brief Initializes \p history over caller provided \p entries.
+ *
+ * Timing thresholds are set to their `SFGP_HISTORY_*` defaults. Nothing is
+ * allocated, \p entries must outlive \p history.
+ *
+ * @param[in]   history: History to initialize.
+ * @param[in]   entries: Ring of \p capacity entries.
+ * @param[in]   capacity: Number of frames to keep, at least 1.
+ */
+SFGP_EXPORT void SFGP_InitHistory(SFGP_History *const history,
+        SFGP_HistoryEntry *const entries, size_t capacity);
+
+/**
+ * @brief Makes every following update of \p pad feed \p history.
+ *
+ * Passing `NULL` detaches any history from \p pad.
+ */
+SFGP_EXPORT void SFGP_AttachHistory(SFGP_Gamepad *const pad,
+        SFGP_History *const history);
+
+/**
+ * @brief Returns number of frames currently kept.
+ */
+SFGP_EXPORT size_t SFGP_GetHistoryLength(const SFGP_History *const history);
+
+/**
+ * @brief Returns frame \p age updates old, 0 being the newest, or `NULL` if
+ * it is no longer kept.
+ */
+SFGP_EXPORT const SFGP_HistoryEntry *SFGP_GetHistoryEntry(
+        const SFGP_History *const history, size_t age);
+
+/**
+ * @brief Returns how long \p button has been held as of the newest frame, 0
+ * if it is released.
+ */
+SFGP_EXPORT int64_t SFGP_GetButtonHeldTime(const SFGP_History *const history,
+        SFGP_ButtonIndex button);
+
+/**
+ * @brief Returns time from the latest press of \p button to the newest frame,
+ * or -1 if it was never pressed.
+ *
+ * "Was A pressed within the last 150 ms" becomes a single comparison.
+ */
+SFGP_EXPORT int64_t SFGP_GetTimeSincePress(const SFGP_History *const history,
+        SFGP_ButtonIndex button);
+
+/**
+ * @brief Returns number of presses of \p button within the last
+ * @ref SFGP_History.window, limited to frames still kept.
+ */
+SFGP_EXPORT uint32_t SFGP_GetPressCount(const SFGP_History *const history,
+        SFGP_ButtonIndex button);
+
+/**
+ * @brief Whether \p button was pressed on the newest frame, no later than
+ * @ref SFGP_History.double_tap after its previous press.
+ */
+SFGP_EXPORT int8_t SFGP_IsButtonDoubleTapped(
+        const SFGP_History *const history, SFGP_ButtonIndex button);
+
+/**
+ * @brief Whether \p button has been held for at least
+ * @ref SFGP_History.long_press.
+ */
+SFGP_EXPORT int8_t SFGP_IsButtonLongPressed(
+        const SFGP_History *const history, SFGP_ButtonIndex button);
+
+/**
+ * @brief Whether \p button reached @ref SFGP_History.long_press on the newest
+ * frame.
+ */
+SFGP_EXPORT int8_t SFGP_IsButtonJustLongPressed(
+        const SFGP_History *const history, SFGP_ButtonIndex button);
+
+
+
+// ============================================================================
+//
+//      Matcher:
+//      Button chords and sequences compiled into a single automaton.
+//      
+// ============================================================================
+
+
+/**
+ * @brief Most steps a single sequence may consist of.
+ */
+#define SFGP_SEQUENCE_MAX 16
+
+/**
+ * @brief Internally managed set of compiled chord and sequence patterns.
+ *
+ * Patterns are registered with @ref SFGP_AddChord() and
+ * @ref SFGP_AddSequence(), then compiled once with @ref SFGP_CompileMatcher().
+ * Chords end up in a hash table keyed by their exact button mask and
+ * sequences in a single Aho-Corasick automaton over the press masks they are
+ * made of, so matching a frame costs the same however many patterns were
+ * registered.
+ *
+ * Once attached through @ref SFGP_AttachMatcher(), every update of the
+ * gamepad advances the matcher, and the patterns fired by the newest frame
+ * are available from @ref SFGP_GetMatches().
+ */
+typedef struct SFGP_Matcher SFGP_Matcher;
+
+
+/**
+ * @brief Allocates an empty matcher into \p matcher.
+ *
+ * @returns `SFGP_ERROR_OK`, or `SFGP_ERROR_FAILED_ALLOCATION`.
+ */
+SFGP_EXPORT SFGP_Error SFGP_CreateMatcher(SFGP_Matcher **const matcher);
+
+/**
+ * @brief Releases \p matcher, which must no longer be attached to a gamepad.
+ */
+SFGP_EXPORT void SFGP_DestroyMatcher(SFGP_Matcher *const matcher);
+
+/**
+ * @brief Registers a chord of buttons held together.
+ *
+ * The chord fires on the frame a press makes the held buttons exactly
+ * \p mask, provided every one of them was pressed within \p tolerance ticks of
+ * the first.
+ *
+ * @param[in]   matcher: Matcher to register with.
+ * @param[in]   id: Reported through @ref SFGP_GetMatches() when fired.
+ * @param[in]   mask: Buttons making up the chord, see @ref SFGP_BUTTON_MASK().
+ * @param[in]   tolerance: Max ticks between first and last press.
+ *
+ * @returns `SFGP_ERROR_OK`, or `SFGP_ERROR_FAILED_ALLOCATION`.
+ */
+SFGP_EXPORT SFGP_Error SFGP_AddChord(SFGP_Matcher *const matcher, uint32_t id,
+        uint32_t mask, int64_t tolerance);
+
+/**
+ * @brief Registers a sequence of presses.
+ *
+ * Each step is the exact mask of buttons pressed on a single frame, usually
+ * one button. The sequence fires on the frame of its last step, provided no
+ * other press came between its steps and no two steps were more than \p gap
+ * ticks apart.
+ *
+ * @param[in]   matcher: Matcher to register with.
+ * @param[in]   id: Reported through @ref SFGP_GetMatches() when fired.
+ * @param[in]   steps: Press masks, see @ref SFGP_BUTTON_MASK().
+ * @param[in]   length: Number of \p steps, at most @ref SFGP_SEQUENCE_MAX.
+ * @param[in]   gap: Max ticks between two consecutive steps.
+ *
+ * @returns `SFGP_ERROR_OK`, or `SFGP_ERROR_FAILED_ALLOCATION`.
+ */
+SFGP_EXPORT SFGP_Error SFGP_AddSequence(SFGP_Matcher *const matcher,
+        uint32_t id, const uint32_t *const steps, size_t length, int64_t gap);
+
+/**
+ * @brief Builds matching tables out of every pattern registered so far.
+ *
+ * May be called again after registering more patterns, which rebuilds the
+ * tables and resets any partially matched sequence.
+ *
+ * @returns `SFGP_ERROR_OK`, or `SFGP_ERROR_FAILED_ALLOCATION` in which case
+ * the previous tables are kept.
+ */
+SFGP_EXPORT SFGP_Error SFGP_CompileMatcher(SFGP_Matcher *const matcher);
+
+/**
+ * @brief Makes every following update of \p pad advance \p matcher.
+ *
+ * Passing `NULL` detaches any matcher from \p pad.
+ */
+SFGP_EXPORT void SFGP_AttachMatcher(SFGP_Gamepad *const pad,
+        SFGP_Matcher *const matcher);
+
+/**
+ * @brief Returns IDs of every pattern fired by the newest frame.
+ *
+ * @param[in]   matcher: Matcher to query.
+ * @param[out]  count: Number of IDs returned.
+ *
+ * @returns Array of \p count IDs, valid until the next update.
+ */
+SFGP_EXPORT const uint32_t *SFGP_GetMatches(const SFGP_Matcher *const matcher,
+        size_t *const count);
+
+
+
+// ============================================================================
+//
+//      Shaper:
+//      Deadzones and response curves applied to analog axes during updates.
+//      
+// ============================================================================
+
+
+/**
+ * @brief Response of a single joystick or trigger.
+ *
+ * Input magnitudes up to .deadzone come out as exactly 0 and those from
+ * .saturation on as exactly 1, with the range in between rescaled to [0, 1]
+ * (a scaled deadzone) and bent by .expo.
+ */
+typedef struct SFGP_Shape {
+    float deadzone;     /**< Inner deadzone in [0, .saturation). */
+    float saturation;   /**< Outer edge in (.deadzone, 1]. */
+    float expo;         /**< 0 linear to 1 cubic, `t + expo * (t^3 - t)`. */
+    uint8_t radial;     /**< Joysticks only, set to shape the magnitude of
+                          *  the stick instead of each axis on its own. */
+} SFGP_Shape;
+
+/**
+ * @brief Shapes of every analog axis of a gamepad, in structure-of-arrays
+ * form so every axis is shaped by the same straight line arithmetic at once.
+ *
+ * Once attached through @ref SFGP_AttachShaper(), values returned by
+ * @ref SFGP_GetXValue(), @ref SFGP_GetTriggerValue(), every threshold query,
+ * and velocities are those of the shaped axes. Values inside a deadzone are
+ * exactly 0, so @ref SFGP_IsXAtZero() and friends follow the deadzone. The
+ * unshaped values stay available through @ref SFGP_GetXRawValue() and
+ * friends.
+ *
+ * @note Members are managed by the procedures below, do not access them
+ * directly.
+ */
+typedef struct SFGP_Shaper {
+    float deadzone[SFGP_AXIS_ELEM];
+    float scale[SFGP_AXIS_ELEM];    /**< 1 / (saturation - deadzone). */
+    float expo[SFGP_AXIS_ELEM];
+    uint8_t radial[SFGP_AXIS_ELEM];
+} SFGP_Shaper;
+
+
+/**
+ * @brief Initializes \p shaper to pass every axis through unchanged.
+ */
+SFGP_EXPORT void SFGP_InitShaper(SFGP_Shaper *const shaper);
+
+/**
+ * @brief Sets shape of both axes of joystick \p stick.
+ */
+SFGP_EXPORT void SFGP_SetJoystickShape(SFGP_Shaper *const shaper,
+        SFGP_JoystickIndex stick, const SFGP_Shape *const shape);
+
+/**
+ * @brief Sets shape of trigger \p trigger, .radial is ignored.
+ */
+SFGP_EXPORT void SFGP_SetTriggerShape(SFGP_Shaper *const shaper,
+        SFGP_TriggerIndex trigger, const SFGP_Shape *const shape);
+
+/**
+ * @brief Makes every following update of \p pad shape its axes through
+ * \p shaper.
+ *
+ * Passing `NULL` detaches any shaper from \p pad. \p shaper may be shared
+ * between gamepads.
+ */
+SFGP_EXPORT void SFGP_AttachShaper(SFGP_Gamepad *const pad,
+        const SFGP_Shaper *const shaper);
+
+
+
+// ============================================================================
+//
+//      Filter:
+//      Low-pass, hysteresis, and debounce filtering of every control.
+//      
+// ============================================================================
+
+
+/**
+ * @brief Press threshold low-passed axes latch at, unless set otherwise
+ * through @ref SFGP_SetAxisHysteresis().
+ *
+ * A low-pass only approaches full scale, so a held trigger might never latch
+ * at the unfiltered threshold of 1.
+ */
+#define SFGP_FILTER_PRESS 0.98f
+
+/**
+ * @brief Filters for every control of a gamepad, with their running state.
+ *
+ * Each analog axis goes through a biquad low-pass (an EMA being the first
+ * order special case) and gets hysteresis on its max and min thresholds.
+ * Each button is debounced over a number of frames. Everything is kept in
+ * structure-of-arrays form and updated in one pass per frame.
+ *
+ * Once attached through @ref SFGP_AttachFilterBank(), frames are filtered
+ * before any @ref SFGP_Shaper. Filters only advance on frames with a new
+ * timestamp, so results do not depend on how often the gamepad is updated.
+ *
+ * @note Members are managed by the procedures below, do not access them
+ * directly. A bank holds running state, so it belongs to a single gamepad.
+ */
+typedef struct SFGP_FilterBank {
+    float b0[SFGP_AXIS_ELEM], b1[SFGP_AXIS_ELEM], b2[SFGP_AXIS_ELEM];
+    float a1[SFGP_AXIS_ELEM], a2[SFGP_AXIS_ELEM];
+    float z1[SFGP_AXIS_ELEM], z2[SFGP_AXIS_ELEM];  /**< Biquad state. */
+    float value[SFGP_AXIS_ELEM];                    /**< Latest output. */
+
+    float press[SFGP_AXIS_ELEM];    /**< Magnitude latching max or min. */
+    float release[SFGP_AXIS_ELEM];  /**< Magnitude clearing the latch. */
+
+    uint8_t debounce[SFGP_BUTTON_ELEM];     /**< Frames to accept a change. */
+    uint8_t pending[SFGP_BUTTON_ELEM];      /**< Frames a change has lasted. */
+    uint32_t buttons;                       /**< Debounced button mask. */
+
+    int64_t timestamp;      /**< Timestamp of latest filtered frame. */
+    uint8_t primed;         /**< Set once the first frame went through. */
+} SFGP_FilterBank;
+
+
+/**
+ * @brief Initializes \p bank to pass every control through unchanged.
+ */
+SFGP_EXPORT void SFGP_InitFilterBank(SFGP_FilterBank *const bank);
+
+/**
+ * @brief Smooths \p axis with an exponential moving average.
+ *
+ * @param[in]   bank: Bank to configure.
+ * @param[in]   axis: Axis to smooth.
+ * @param[in]   alpha: Weight of each new frame in (0, 1], 1 disabling it.
+ */
+SFGP_EXPORT void SFGP_SetAxisSmoothing(SFGP_FilterBank *const bank,
+        SFGP_AxisIndex axis, float alpha);
+
+/**
+ * @brief Filters \p axis through an arbitrary biquad.
+ *
+ * Coefficients are normalized so that a0 is 1, giving
+ * `y = b0 x + b1 x[-1] + b2 x[-2] - a1 y[-1] - a2 y[-2]`. The filter should
+ * have unity gain at DC, the output is clamped to the range of \p axis.
+ *
+ * Lowers a press threshold still at 1 to @ref SFGP_FILTER_PRESS.
+ */
+SFGP_EXPORT void SFGP_SetAxisBiquad(SFGP_FilterBank *const bank,
+        SFGP_AxisIndex axis, const float b[3], const float a[2]);
+
+/**
+ * @brief Sets hysteresis of max and min thresholds of \p axis.
+ *
+ * Max (pressed for triggers) and min are latched once the magnitude of the
+ * filtered value reaches \p press, and only cleared once it falls below
+ * \p release. Affects @ref SFGP_IsTriggerPressed(),
+ * @ref SFGP_IsXAtMax(), @ref SFGP_IsXAtMin(), their `Just` and y axis
+ * variants, and axis events.
+ *
+ * @param[in]   bank: Bank to configure.
+ * @param[in]   axis: Axis to configure.
+ * @param[in]   press: Magnitude in (0, 1] setting the latch, 1 by default
+ *              or @ref SFGP_FILTER_PRESS once low-passed.
+ * @param[in]   release: Magnitude in (0, \p press] clearing the latch.
+ */
+SFGP_EXPORT void SFGP_SetAxisHysteresis(SFGP_FilterBank *const bank,
+        SFGP_AxisIndex axis, float press, float release);
+
+/**
+ * @brief Only lets \p button change state once the change has lasted
+ * \p frames frames, 0 or 1 disabling it.
+ */
+SFGP_EXPORT void SFGP_SetButtonDebounce(SFGP_FilterBank *const bank,
+        SFGP_ButtonIndex button, uint8_t frames);
+
+/**
+ * @brief Makes every following update of \p pad go through \p bank.
+ *
+ * Passing `NULL` detaches any filter bank from \p pad.
+ */
+SFGP_EXPORT void SFGP_AttachFilterBank(SFGP_Gamepad *const pad,
+        SFGP_FilterBank *const bank);
+
+
+
+// ============================================================================
+//
+//      Packed:
+//      Compact fixed-point form of a gamepad's state.
+//      
+// ============================================================================
+
+
+/**
+ * @brief Quantized value of an axis at 1.0f.
+ *
+ * Quantization keeps every threshold exact: an axis maps to
+ * +-@ref SFGP_PACKED_AXIS_MAX only if it is at or past +-1, and to 0 only if
+ * it is exactly 0. Converting back divides by this value, giving exactly 1,
+ * -1, and 0 for those, so float and integer thresholds agree.
+ */
+#define SFGP_PACKED_AXIS_MAX 32767
+
+/**
+ * @brief Last and current state of a gamepad within a single 64 byte line.
+ *
+ * Holds everything the threshold and edge queries need: int16 fixed-point
+ * axes, button masks, and axis latches. Velocities and filter state are not
+ * kept. Meant for large numbers of pads and long histories where memory
+ * bandwidth dominates; place arrays on a 64 byte boundary so that every pad
+ * occupies exactly one cache line.
+ */
+typedef struct SFGP_PackedPad {
+    int64_t timestamp;
+    int32_t id;
+    uint32_t latches;                   /**< 4 bits per @ref SFGP_AxisIndex. */
+    uint32_t buttons_current;
+    uint32_t buttons_last;
+    int16_t current[SFGP_AXIS_ELEM];    /**< By @ref SFGP_AxisIndex. */
+    int16_t last[SFGP_AXIS_ELEM];       /**< By @ref SFGP_AxisIndex. */
+    uint8_t reserved[16];
+} SFGP_PackedPad;
+
+
+/**
+ * @brief Packs the state of \p src into \p dst.
+ */
+SFGP_EXPORT void SFGP_PackGamepad(SFGP_PackedPad *const dst,
+        const SFGP_Gamepad *const src);
+
+/**
+ * @brief Unpacks \p src into initialized gamepad \p dst.
+ *
+ * Every query of \p dst then answers as on the packed pad. Raw values are set
+ * to the current ones, velocities and acceleration to 0.
+ */
+SFGP_EXPORT void SFGP_UnpackGamepad(SFGP_Gamepad *const dst,
+        const SFGP_PackedPad *const src);
+
+/**
+ * @brief Updates \p pad straight from a gamepad data array, as
+ * @ref SFGP_UpdateGamepad() does for full gamepads, repeated frames
+ * included.
+ *
+ * @returns `SFGP_ERROR_OK`, or `SFGP_ERROR_MALFORMED_FRAME` if an axis is out
+ * of range or NaN, in which case \p pad is left untouched.
+ */
+SFGP_EXPORT SFGP_Error SFGP_UpdatePackedPad(SFGP_PackedPad *const pad,
+        const uint8_t *const byte_array);
+
+/**
+ * @brief Returns current value of \p axis converted back to float.
+ */
+SFGP_EXPORT float SFGP_GetPackedAxisValue(const SFGP_PackedPad *const pad,
+        SFGP_AxisIndex axis);
+
+SFGP_EXPORT int8_t SFGP_IsPackedAxisAtMax(const SFGP_PackedPad *const pad,
+        SFGP_AxisIndex axis);
+SFGP_EXPORT int8_t SFGP_IsPackedAxisJustAtMax(
+        const SFGP_PackedPad *const pad, SFGP_AxisIndex axis);
+
+SFGP_EXPORT int8_t SFGP_IsPackedAxisAtMin(const SFGP_PackedPad *const pad,
+        SFGP_AxisIndex axis);
+SFGP_EXPORT int8_t SFGP_IsPackedAxisJustAtMin(
+        const SFGP_PackedPad *const pad, SFGP_AxisIndex axis);
+
+SFGP_EXPORT int8_t SFGP_IsPackedAxisAtZero(const SFGP_PackedPad *const pad,
+        SFGP_AxisIndex axis);
+SFGP_EXPORT int8_t SFGP_IsPackedAxisJustAtZero(
+        const SFGP_PackedPad *const pad, SFGP_AxisIndex axis);
+
+/**
+ * @brief Packed counterparts of @ref SFGP_GetButtonsPressed() and friends.
+ * @see SFGP_BUTTON_MASK()
+ */
+SFGP_EXPORT uint32_t SFGP_GetPackedButtonsPressed(
+        const SFGP_PackedPad *const pad);
+SFGP_EXPORT uint32_t SFGP_GetPackedButtonsJustPressed(
+        const SFGP_PackedPad *const pad);
+SFGP_EXPORT uint32_t SFGP_GetPackedButtonsJustReleased(
+        const SFGP_PackedPad *const pad);
+
+
+// ============================================================================
+//
+//      Stats:
+//      Counters and latency histograms of gamepad updates.
+//      
+// ============================================================================
+
+
+/**
+ * @brief Bits of sub-bucket resolution of each power of two in a
+ * @ref SFGP_Histogram, every bucket being within 25% of its values.
+ */
+#define SFGP_HISTOGRAM_SUB_BITS 2
+
+/**
+ * @brief Buckets of a @ref SFGP_Histogram, covering values up to 2^25.
+ */
+#define SFGP_HISTOGRAM_BUCKETS 96
+
+/**
+ * @brief Log-linear histogram of non-negative values.
+ *
+ * Values below 2^SFGP_HISTOGRAM_SUB_BITS get a bucket each, every power of
+ * two above that is split into 2^SFGP_HISTOGRAM_SUB_BITS equal buckets.
+ * Recording is a handful of integer instructions whatever the value.
+ */
+typedef struct SFGP_Histogram {
+    uint64_t counts[SFGP_HISTOGRAM_BUCKETS];    /**< Values per bucket. */
+    uint64_t total;                             /**< Values recorded. */
+    int64_t max;                                /**< Largest value. */
+} SFGP_Histogram;
+
+/**
+ * @brief Lowest value counted into \p bucket.
+ */
+SFGP_EXPORT int64_t SFGP_GetHistogramBucketValue(size_t bucket);
+
+/**
+ * @brief Value at or below which \p percentile percent of \p histogram
+ * lies, rounded up to the top of its bucket.
+ *
+ * @returns 0 for an empty histogram.
+ */
+SFGP_EXPORT int64_t SFGP_GetHistogramPercentile(
+        const SFGP_Histogram *const histogram, double percentile);
+
+
+/**
+ * @brief Counters of every frame decoded into a gamepad.
+ *
+ * Attached through @ref SFGP_AttachStats(), and only recorded into when SFGP
+ * was built with the `stats` option, so that builds without it carry no
+ * cost at all.
+ *
+ * Frame age is taken against `CLOCK_MONOTONIC`, the clock behind the SDK's
+ * `SystemClock.uptimeMillis()`, so it is only meaningful for frames stamped
+ * on the same device.
+ *
+ * @note Members are written by the thread updating the gamepad. Read them
+ * from any thread through @ref SFGP_ReadStats().
+ */
+typedef struct SFGP_Stats {
+    uint64_t frames;        /**< Frames decoded. */
+    uint64_t duplicates;    /**< Frames repeating the previous timestamp. */
+    uint64_t dropped;       /**< Frames estimated missing from gaps. */
+
+    int64_t interval;       /**< Expected ms between frames, 0 to not count
+                              *  dropped frames. */
+    int64_t timestamp;      /**< Timestamp of latest frame. */
+
+    SFGP_Histogram age;     /**< Microseconds from frame timestamp to the end
+                              *  of its decode. */
+    SFGP_Histogram decode;  /**< Nanoseconds spent decoding each frame. */
+} SFGP_Stats;
+
+
+/**
+ * @brief Initializes \p stats with every counter at zero.
+ */
+SFGP_EXPORT void SFGP_InitStats(SFGP_Stats *const stats);
+
+/**
+ * @brief Sets the expected ms between frames, from which gaps in timestamps
+ * are counted as dropped frames.
+ *
+ * A gap of n intervals (rounded to the nearest) counts n - 1 dropped frames.
+ */
+SFGP_EXPORT void SFGP_SetStatsInterval(SFGP_Stats *const stats,
+        int64_t interval);
+
+/**
+ * @brief Records every frame later decoded into \p pad into \p stats.
+ *
+ * Passing NULL detaches the current stats.
+ *
+ * @returns SFGP_ERROR_UNSUPPORTED when SFGP was built without the `stats`
+ * option, in which case nothing is attached.
+ */
+SFGP_EXPORT SFGP_Error SFGP_AttachStats(SFGP_Gamepad *const pad,
+        SFGP_Stats *const stats);
+
+/**
+ * @brief Copies \p stats into \p snapshot.
+ *
+ * Safe to call from any thread while the gamepad is updated. Each member is
+ * copied whole, though members may be from consecutive frames.
+ */
+SFGP_EXPORT void SFGP_ReadStats(const SFGP_Stats *const stats,
+        SFGP_Stats *const snapshot);
+
+
+// ============================================================================
+//
+//      Registry:
+//      Every gamepad seen, routed to by the ID embedded in its frames.
+//      
+// ============================================================================
+
+
+/**
+ * @brief Internally managed set of gamepads keyed by gamepad ID.
+ *
+ * Every gamepad, its storage, and the table mapping IDs onto them live in a
+ * single block allocated up front for a fixed number of gamepads. Frames are
+ * routed to their gamepad through an open addressing hash table, and a
+ * gamepad is created the first time its ID shows up.
+ *
+ * Gamepads stay at the same address for as long as they are in the registry,
+ * so they can be kept, queried, and have history and the like attached as
+ * any other gamepad.
+ */
+typedef struct SFGP_Registry SFGP_Registry;
+
+
+/**
+ * @brief Allocates a registry for up to \p capacity gamepads into
+ * \p registry.
+ *
+ * @returns `SFGP_ERROR_OK`, or `SFGP_ERROR_FAILED_ALLOCATION`.
+ */
+SFGP_EXPORT SFGP_Error SFGP_CreateRegistry(SFGP_Registry **const registry,
+        size_t capacity);
+
+/**
+ * @brief Releases \p registry along with every gamepad in it.
+ */
+SFGP_EXPORT void SFGP_DestroyRegistry(SFGP_Registry *const registry);
+
+/**
+ * @brief Updates the gamepad of the ID embedded in \p byte_array with it, as
+ * @ref SFGP_UpdateGamepad() would.
+ *
+ * @param[in]   registry: Registry to route through.
+ * @param[in]   byte_array: Gamepad data array in host byte order.
+ * @param[out]  pad: Gamepad updated, may be NULL.
+ *
+ * @returns `SFGP_ERROR_OK`, or `SFGP_ERROR_REGISTRY_FULL` if the ID is new
+ * and every gamepad of \p registry is taken.
+ */
+SFGP_EXPORT SFGP_Error SFGP_RouteFrame(SFGP_Registry *const registry,
+        const uint8_t *const byte_array, SFGP_Gamepad **const pad);
+
+/**
+ * @brief Updates the gamepad of the ID embedded in SDK \p payload with it,
+ * as @ref SFGP_DecodeGamepad() would.
+ *
+ * No gamepad is created for a payload that fails to decode.
+ *
+ * @returns Same as @ref SFGP_DecodeGamepad(), or
+ * `SFGP_ERROR_REGISTRY_FULL`.
+ */
+SFGP_EXPORT SFGP_Error SFGP_RoutePayload(SFGP_Registry *const registry,
+        const uint8_t *const payload, size_t length, SFGP_Gamepad **const pad);
+
+/**
+ * @brief Returns gamepad of \p id, or NULL if it has not been seen.
+ */
+SFGP_EXPORT SFGP_Gamepad *SFGP_FindGamepad(
+        const SFGP_Registry *const registry, int32_t id);
+
+/**
+ * @brief Removes gamepad of \p id, whose memory is reused for the next new
+ * ID.
+ *
+ * @returns Whether there was a gamepad of \p id.
+ */
+SFGP_EXPORT int8_t SFGP_RemoveGamepad(SFGP_Registry *const registry,
+        int32_t id);
+
+/**
+ * @brief Returns number of gamepads in \p registry.
+ */
+SFGP_EXPORT size_t SFGP_GetRegistryCount(const SFGP_Registry *const registry);
+
+/**
+ * @brief Returns gamepad at \p index, below @ref SFGP_GetRegistryCount().
+ *
+ * Gamepads are kept in the order they were first seen, except that removing
+ * one moves the last gamepad into its place.
+ */
+SFGP_EXPORT SFGP_Gamepad *SFGP_GetRegistryGamepad(
+        const SFGP_Registry *const registry, size_t index);
+
+
+// ============================================================================
+//
+//      Ring:
+//      Frames handed over between processes through shared memory.
+//      
+// ============================================================================
+
+
+/**
+ * @brief Single producer, single consumer ring of gamepad data arrays in a
+ * file shared between processes.
+ *
+ * The file holds a header, the producer's and consumer's positions on cache
+ * lines of their own, and one cache line per frame. Frames are copied in by
+ * the producer and decoded straight out of the mapping by the consumer, so a
+ * handoff costs a copy of a single frame and, at most, one wake up.
+ *
+ * Placing the file on a memory backed file system such as /dev/shm keeps the
+ * ring off disk entirely.
+ *
+ * @note Members are managed by the procedures below, do not access them
+ * directly.
+ */
+typedef struct SFGP_FrameRing {
+    void *data;         /**< Mapped file. */
+    size_t size;        /**< Size of mapping in bytes. */
+} SFGP_FrameRing;
+
+/**
+ * @brief How @ref SFGP_ReadFrameRing() waits for a frame.
+ */
+typedef enum SFGP_RingWait {
+    SFGP_RING_NO_WAIT,  /**< Return right away. */
+    SFGP_RING_SPIN,     /**< Busy poll, lowest latency at a whole core. */
+    SFGP_RING_SLEEP     /**< Sleep on a futex until the producer wakes it,
+                          *  Linux and Android only. */
+} SFGP_RingWait;
+
+
+/**
+ * @brief Creates or replaces ring file \p path for \p capacity frames, and
+ * maps it into \p ring.
+ *
+ * @param[out]  ring: Ring to map into.
+ * @param[in]   path: File to create.
+ * @param[in]   capacity: Frames the ring holds, a power of 2.
+ *
+ * @returns `SFGP_ERROR_OK`, `SFGP_ERROR_IO`, or `SFGP_ERROR_UNSUPPORTED` on
+ * platforms without memory mapped files.
+ */
+SFGP_EXPORT SFGP_Error SFGP_CreateFrameRing(SFGP_FrameRing *const ring,
+        const char *const path, size_t capacity);
+
+/**
+ * @brief Maps existing ring file \p path into \p ring.
+ *
+ * @returns `SFGP_ERROR_OK`, `SFGP_ERROR_IO`, `SFGP_ERROR_INVALID_FILE` if
+ * \p path is not a ring, or `SFGP_ERROR_UNSUPPORTED`.
+ */
+SFGP_EXPORT SFGP_Error SFGP_OpenFrameRing(SFGP_FrameRing *const ring,
+        const char *const path);
+
+/**
+ * @brief Unmaps \p ring, leaving its file in place.
+ */
+SFGP_EXPORT void SFGP_CloseFrameRing(SFGP_FrameRing *const ring);
+
+/**
+ * @brief Appends gamepad data array \p byte_array to \p ring.
+ *
+ * Must only be called by the single producer of \p ring. Never blocks.
+ *
+ * @returns `SFGP_ERROR_OK`, or `SFGP_ERROR_RING_FULL` if the consumer has
+ * not kept up, in which case the frame is dropped.
+ */
+SFGP_EXPORT SFGP_Error SFGP_WriteFrameRing(SFGP_FrameRing *const ring,
+        const uint8_t *const byte_array);
+
+/**
+ * @brief Updates \p pad from the oldest frame of \p ring, as
+ * @ref SFGP_UpdateGamepad() would.
+ *
+ * Must only be called by the single consumer of \p ring. Frames come from
+ * another process, so unlike @ref SFGP_UpdateGamepad() they are validated
+ * first.
+ *
+ * @param[in]   ring: Ring to read from.
+ * @param[in]   pad: Gamepad to update.
+ * @param[in]   wait: How to wait for a frame when the ring is empty.
+ * @param[in]   timeout: Most nanoseconds to wait for, negative for no limit.
+ * @param[out]  read: Set if a frame was taken off the ring.
+ *
+ * @returns `SFGP_ERROR_OK`, `SFGP_ERROR_MALFORMED_FRAME` if the frame read
+ * was out of range and skipped, or `SFGP_ERROR_UNSUPPORTED` for a \p wait
+ * the platform lacks.
+ */
+SFGP_EXPORT SFGP_Error SFGP_ReadFrameRing(SFGP_FrameRing *const ring,
+        SFGP_Gamepad *const pad, SFGP_RingWait wait, int64_t timeout,
+        int8_t *const read);
+
+
+// ============================================================================
+//
+//      Synth:
+//      Scripted and seeded generation of gamepad data arrays.
+//      
+// ============================================================================
+
+
+/**
+ * @brief What a @ref SFGP_SynthStep does to each frame it covers.
+ */
+typedef enum SFGP_SynthKind {
+    SFGP_SYNTH_HOLD,    /**< Hold .buttons, leaving axes as they are. */
+    SFGP_SYNTH_RAMP,    /**< Move .axis linearly from .from to .to. */
+    SFGP_SYNTH_SWEEP,   /**< Turn stick .axis at full tilt from .from to .to
+                          *  turns, counterclockwise from +x. */
+    SFGP_SYNTH_MASH,    /**< Press a random subset of .buttons each frame. */
+    SFGP_SYNTH_RANDOM   /**< Random axes, and buttons out of .buttons. */
+} SFGP_SynthKind;
+
+/**
+ * @brief Single step of a synthesizer script, lasting .frames frames.
+ */
+typedef struct SFGP_SynthStep {
+    uint8_t kind;       /**< @ref SFGP_SynthKind. */
+    uint8_t axis;       /**< @ref SFGP_AxisIndex, or @ref SFGP_JoystickIndex
+                          *  for sweeps. */
+    uint32_t frames;    /**< Frames the step lasts. */
+    uint32_t buttons;   /**< Button mask, see @ref SFGP_BUTTON_MASK(). */
+    float from;         /**< Start of a ramp or sweep. */
+    float to;           /**< End of a ramp or sweep, reached on the step's
+                          *  last frame. */
+} SFGP_SynthStep;
+
+/**
+ * @brief Generates gamepad data arrays from a script and a seed.
+ *
+ * Output only depends on the script, seed, and clock it was set up with, so
+ * the same setup yields the same frames on every run. Axes and buttons carry
+ * over from one step into the next.
+ *
+ * @note Members are managed by the procedures below, do not access them
+ * directly.
+ */
+typedef struct SFGP_Synth {
+    const SFGP_SynthStep *steps;    /**< Script, NULL for endless random. */
+    size_t count;                   /**< Steps in script. */
+    size_t step;                    /**< Step being played. */
+    uint32_t frame;                 /**< Frame within step. */
+
+    uint64_t rng;                   /**< xorshift64* state. */
+    int64_t timestamp;              /**< Timestamp of next frame. */
+    int64_t interval;               /**< Timestamp increment per frame. */
+    int32_t id;                     /**< Gamepad ID of every frame. */
+
+    float axes[SFGP_AXIS_ELEM];     /**< Latest axes. */
+    uint32_t buttons;               /**< Latest buttons. */
+} SFGP_Synth;
+
+
+/**
+ * @brief Initializes \p synth to play \p count \p steps, seeded by \p seed.
+ *
+ * \p steps must outlive \p synth. Without \p steps every frame is
+ * @ref SFGP_SYNTH_RANDOM over all buttons, forever. Frames start at
+ * timestamp 0, 1 ms apart, with gamepad ID 0.
+ */
+SFGP_EXPORT void SFGP_InitSynth(SFGP_Synth *const synth,
+        const SFGP_SynthStep *const steps, size_t count, uint64_t seed);
+
+/**
+ * @brief Sets timestamp of the next frame of \p synth to \p timestamp, and
+ * the one of each frame after to \p interval more.
+ */
+SFGP_EXPORT void SFGP_SetSynthClock(SFGP_Synth *const synth,
+        int64_t timestamp, int64_t interval);
+
+/**
+ * @brief Sets gamepad ID of every frame of \p synth.
+ */
+SFGP_EXPORT void SFGP_SetSynthId(SFGP_Synth *const synth, int32_t id);
+
+/**
+ * @brief Writes up to \p count next frames of \p synth.
+ *
+ * @param[in]   synth: Synthesizer to play.
+ * @param[out]  frames: Destination, frame i being written at
+ *              `frames + (i * stride)`.
+ * @param[in]   stride: Bytes between frames, at least @ref SFGP_FRAME_SIZE.
+ * @param[in]   count: Most frames to write.
+ *
+ * @returns Number of frames written, less than \p count once the script
+ * ends.
+ */
+SFGP_EXPORT size_t SFGP_SynthesizeFrames(SFGP_Synth *const synth,
+        uint8_t *const frames, size_t stride, size_t count);
+
+
+// ============================================================================
+//
+//      Delta:
+//      Compact bit packed stream of gamepad frames.
+//      
+// ============================================================================
+
+
+/**
+ * @brief Default frames between keyframes of a delta stream.
+ */
+#define SFGP_DELTA_KEYFRAME_INTERVAL 256
+
+/**
+ * @brief Most bytes a single frame adds to a delta stream, keyframe
+ * included.
+ */
+#define SFGP_DELTA_FRAME_MAX 128
+
+/**
+ * @brief Latest frame of a delta stream, as stored.
+ */
+typedef struct SFGP_DeltaFrame {
+    int64_t timestamp;
+    int64_t delta;                  /**< From the frame before. */
+    int32_t id;
+    uint32_t buttons;
+    int16_t axes[SFGP_AXIS_ELEM];   /**< Quantized as in SFGP_PackedPad. */
+    float touchpad[SFGP_FINGER_ELEM][2];
+    uint8_t user;
+    uint8_t type;
+    uint8_t version;
+} SFGP_DeltaFrame;
+
+/**
+ * @brief Encodes the frames a gamepad is updated from into a delta stream.
+ *
+ * The stream is made of segments, each starting with a byte aligned keyframe
+ * holding one whole frame, followed by the rest of its frames bit packed as
+ * differences from the frame before. Each difference holds:
+ *
+ * - the change in timestamp delta,
+ * - which buttons flipped, if any,
+ * - which axes changed, and by how much,
+ * - the touchpad, if it changed.
+ *
+ * Changes are stored as zig-zag varints of 4 bit groups. Axes are quantized
+ * as in @ref SFGP_PackedPad first, so 0 and +-1 stay exact. A frame that only
+ * moves the clock at a steady rate takes 13 bits instead of the
+ * @ref SFGP_FRAME_SIZE bytes of a gamepad data array.
+ *
+ * Keyframes record their frame number and segment size, so readers can skip
+ * from one keyframe to the next without decoding anything in between.
+ *
+ * @note Members are managed by the procedures below, do not access them
+ * directly.
+ */
+typedef struct SFGP_DeltaWriter {
+    uint8_t *buffer;            /**< Stream is written to. */
+    size_t capacity;            /**< Bytes at buffer. */
+    size_t length;              /**< Bytes written to buffer. */
+    size_t segment;             /**< Offset of open keyframe, or SIZE_MAX. */
+
+    uint64_t bits;              /**< Bits not yet written, LSB first. */
+    uint32_t bit_count;         /**< Number of pending bits. */
+    uint32_t interval;          /**< Frames per segment. */
+    uint32_t frames;            /**< Frames in open segment. */
+    uint32_t generation;        /**< Generation of latest frame written. */
+    uint64_t frame;             /**< Frames written overall. */
+
+    SFGP_DeltaFrame last;
+} SFGP_DeltaWriter;
+
+/**
+ * @brief Decodes a delta stream back into gamepad updates.
+ *
+ * @note Members are managed by the procedures below, do not access them
+ * directly.
+ */
+typedef struct SFGP_DeltaReader {
+    const uint8_t *data;        /**< Stream. */
+    size_t size;                /**< Bytes in stream. */
+    size_t end;                 /**< Offset past current segment. */
+    size_t offset;              /**< Offset of next unread byte. */
+
+    uint64_t bits;              /**< Bits read ahead, LSB first. */
+    uint32_t bit_count;         /**< Number of bits read ahead. */
+    uint32_t remaining;         /**< Frames left in current segment. */
+    uint64_t frame;             /**< Number of next frame. */
+
+    SFGP_DeltaFrame last;
+} SFGP_DeltaReader;
+
+
+/**
+ * @brief Initializes \p writer to write into \p capacity bytes at \p buffer,
+ * starting a new segment every \p interval frames.
+ */
+SFGP_EXPORT void SFGP_InitDeltaWriter(SFGP_DeltaWriter *const writer,
+        uint8_t *const buffer, size_t capacity, uint32_t interval);
+
+/**
+ * @brief Appends the frame \p pad was last updated from to \p writer.
+ *
+ * Nothing is written if \p pad has not been updated since the previous call,
+ * as told by @ref SFGP_GetGamepadGeneration(), or never was. A new segment is
+ * started when the open one is full or the gamepad ID, user, type, or
+ * payload version changes.
+ *
+ * Only raw axes and buttons are stored, so a stream rebuilds the state of
+ * gamepads with the same filters and shapes attached.
+ *
+ * @returns `SFGP_ERROR_OK`, or `SFGP_ERROR_BUFFER_FULL` if fewer than
+ * @ref SFGP_DELTA_FRAME_MAX bytes are left, in which case nothing is
+ * written.
+ */
+SFGP_EXPORT SFGP_Error SFGP_WriteDelta(SFGP_DeltaWriter *const writer,
+        const SFGP_Gamepad *const pad);
+
+/**
+ * @brief Closes the open segment of \p writer, making every byte of its
+ * buffer readable.
+ *
+ * The next frame written starts a new segment.
+ *
+ * @returns Bytes in the buffer of \p writer.
+ */
+SFGP_EXPORT size_t SFGP_FlushDeltaWriter(SFGP_DeltaWriter *const writer);
+
+/**
+ * @brief Flushes \p writer and empties its buffer, for when its contents were
+ * handed off. Frame numbers carry on.
+ */
+SFGP_EXPORT void SFGP_ClearDeltaWriter(SFGP_DeltaWriter *const writer);
+
+
+/**
+ * @brief Initializes \p reader over \p size bytes of flushed stream at
+ * \p data, which must outlive \p reader.
+ */
+SFGP_EXPORT void SFGP_InitDeltaReader(SFGP_DeltaReader *const reader,
+        const uint8_t *const data, size_t size);
+
+/**
+ * @brief Updates \p pad from the next frame of \p reader.
+ *
+ * @param[in]   reader: Stream to read.
+ * @param[in]   pad: Gamepad to update.
+ * @param[out]  read: Set if a frame was read, clear at the end of the
+ *              stream.
+ *
+ * @returns `SFGP_ERROR_OK`, or `SFGP_ERROR_INVALID_FILE` if the stream is
+ * corrupt.
+ */
+SFGP_EXPORT SFGP_Error SFGP_ReadDelta(SFGP_DeltaReader *const reader,
+        SFGP_Gamepad *const pad, int8_t *const read);
+
+/**
+ * @brief Moves \p reader so that the next frame read is frame number
+ * \p frame, counted from the first frame ever written to the stream.
+ *
+ * Skips whole segments through their keyframes and only decodes frames of
+ * the segment holding \p frame. For `Just` queries to hold for \p frame as
+ * they did when recording, seek to the frame before and read both.
+ *
+ * @returns `SFGP_ERROR_OK`, `SFGP_ERROR_INVALID_FILE` if the stream is
+ * corrupt, or `SFGP_ERROR_UNSUPPORTED` if \p frame is not within the stream.
+ */
+SFGP_EXPORT SFGP_Error SFGP_SeekDelta(SFGP_DeltaReader *const reader,
+        uint64_t frame);
+
+
+// ============================================================================
+//
+//      Analytics:
+//      Driver statistics over many recording files at once.
+//      
+// ============================================================================
+
+
+/**
+ * @brief Bins of @ref SFGP_Analytics.utilization, splitting axis magnitude
+ * evenly over [0, 1].
+ */
+#define SFGP_ANALYTICS_BINS 10
+
+/**
+ * @brief Distinct chords counted by @ref SFGP_Analytics.
+ */
+#define SFGP_ANALYTICS_CHORDS 64
+
+/**
+ * @brief Gamepad IDs told apart within a single recording file.
+ */
+#define SFGP_ANALYTICS_GAMEPADS 4
+
+/**
+ * @brief Parameters of an analytics pass.
+ */
+typedef struct SFGP_AnalyticsConfig {
+    int64_t start;      /**< Ticks after a gamepad's first frame that
+                          *  first input is timed from, such as the end of
+                          *  autonomous. */
+    float deadzone;     /**< Axis magnitude counted as input. */
+    uint32_t threads;   /**< Workers, 0 for one per online CPU. */
+} SFGP_AnalyticsConfig;
+
+/**
+ * @brief Times a set of buttons was pressed together.
+ */
+typedef struct SFGP_ChordCount {
+    uint32_t buttons;   /**< Button mask, see @ref SFGP_BUTTON_MASK(). */
+    uint32_t count;     /**< Times completed. */
+} SFGP_ChordCount;
+
+/**
+ * @brief Aggregates of every gamepad in every file analyzed.
+ *
+ * Durations are in timestamp ticks, each frame lasting until the next frame
+ * of the same gamepad. A chord is counted whenever a press leaves two or
+ * more buttons held, under the mask of every button then held.
+ */
+typedef struct SFGP_Analytics {
+    uint64_t files;         /**< Files analyzed, failed ones included. */
+    uint64_t failed;        /**< Files that could not be read in full. */
+    uint64_t frames;        /**< Frames decoded. */
+    uint64_t skipped;       /**< Frames short, invalid, or of a gamepad past
+                              *  @ref SFGP_ANALYTICS_GAMEPADS in a file. */
+    uint64_t gamepads;      /**< Gamepads seen, counted once per file. */
+
+    uint64_t presses[SFGP_BUTTON_ELEM];     /**< By @ref SFGP_ButtonIndex. */
+    int64_t held[SFGP_BUTTON_ELEM];         /**< Ticks each was held. */
+
+    /** Ticks each axis spent at each magnitude. */
+    int64_t utilization[SFGP_AXIS_ELEM][SFGP_ANALYTICS_BINS];
+
+    SFGP_Histogram first_input;     /**< Ticks from config start to first
+                                      *  input, once per gamepad. */
+    uint64_t no_input;              /**< Gamepads never giving input after
+                                      *  config start. */
+
+    SFGP_ChordCount chords[SFGP_ANALYTICS_CHORDS];  /**< In first seen
+                                                      *  order. */
+    uint32_t chord_count;           /**< Entries of chords in use. */
+    uint64_t chords_dropped;        /**< Chords not counted for lack of
+                                      *  room. */
+} SFGP_Analytics;
+
+
+/**
+ * @brief Fills \p config with defaults: timing from the first frame, a
+ * deadzone of 0.1, and one worker per CPU.
+ */
+SFGP_EXPORT void SFGP_InitAnalyticsConfig(SFGP_AnalyticsConfig *const config);
+
+/**
+ * @brief Initializes \p analytics with every aggregate empty.
+ */
+SFGP_EXPORT void SFGP_InitAnalytics(SFGP_Analytics *const analytics);
+
+/**
+ * @brief Adds every aggregate of \p src into \p dst.
+ */
+SFGP_EXPORT void SFGP_MergeAnalytics(SFGP_Analytics *const dst,
+        const SFGP_Analytics *const src);
+
+/**
+ * @brief Adds recording file at \p path into \p analytics on the calling
+ * thread.
+ *
+ * The file is streamed in fixed size chunks rather than mapped, and each
+ * frame goes through the same validation and decode as a
+ * @ref SFGP_DecodeGamepad() update.
+ *
+ * @returns `SFGP_ERROR_OK`, `SFGP_ERROR_IO` if the file cannot be read,
+ * `SFGP_ERROR_INVALID_FILE` if it is not a recording, or
+ * `SFGP_ERROR_FAILED_ALLOCATION`. Aggregates of a file failing part way
+ * through are kept.
+ */
+SFGP_EXPORT SFGP_Error SFGP_AnalyzeFile(SFGP_Analytics *const analytics,
+        const char *const path, const SFGP_AnalyticsConfig *const config);
+
+/**
+ * @brief Adds \p count recording files into \p analytics, in parallel.
+ *
+ * Files are dealt out to a pool of `config->threads` workers, largest first,
+ * and workers out of files steal from the others. Each worker aggregates on
+ * its own, and the results are merged once every file is done, so nothing
+ * is shared between workers while they run. Files that cannot be read are
+ * counted in `failed` rather than stopping the pass.
+ *
+ * On platforms without pthreads, every file is analyzed on the calling
+ * thread.
+ *
+ * @returns `SFGP_ERROR_OK`, or `SFGP_ERROR_FAILED_ALLOCATION`.
+ */
+SFGP_EXPORT SFGP_Error SFGP_AnalyzeFiles(SFGP_Analytics *const analytics,
+        const char *const *const paths, size_t count,
+        const SFGP_AnalyticsConfig *const config);
+
 #ifdef __cplusplus
     }
 #endif // __cplusplus
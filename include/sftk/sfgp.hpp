@@ -0,0 +1,363 @@
+/**
+ * @file sftk/sfgp.hpp
+ * @brief C++ wrapper around SFGP gamepads, with controls named at compile
+ * time.
+ *
+ * @ref sftk::sfgp::Gamepad owns an @ref SFGP_Gamepad for its lifetime and
+ * answers every query through the inline ones of sftk/sfgp_inline.h. Controls
+ * are passed as tag types rather than values, so each query resolves to a
+ * fixed field offset and constant mask, and a chord such as
+ *
+ *     pad.just_pressed<A, LeftBumper>()
+ *
+ * compiles down to the same couple of mask tests as the hand written C.
+ *
+ * Nothing here is virtual, and nothing allocates beyond
+ * @ref SFGP_InitGamepad(). Requires C++17.
+ *
+ * @note As with sftk/sfgp_inline.h, code built with this header depends on
+ * the layout of @ref SFGP_GamepadState.
+ */
+
+
+#ifndef __SFTK_SFGP_HPP_HEADER__
+#define __SFTK_SFGP_HPP_HEADER__
+
+#include <sftk/sfgp.h>
+#include <sftk/sfgp_inline.h>
+
+#include <cstdint>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+
+
+#if __cplusplus < 201703L \
+        && !(defined(_MSVC_LANG) && _MSVC_LANG >= 201703L)
+    #error "sftk/sfgp.hpp requires C++17"
+#endif
+
+
+namespace sftk::sfgp {
+
+
+// ============================================================================
+//
+//      Tags:
+//      Controls, named at compile time.
+//
+// ============================================================================
+
+
+/**
+ * @brief Tag naming button \p I.
+ */
+template <SFGP_ButtonIndex I>
+struct ButtonTag {
+    static constexpr SFGP_ButtonIndex index = I;
+    static constexpr std::uint32_t mask = SFGP_BUTTON_MASK(I);
+};
+
+/**
+ * @brief Tag naming axis \p I, queried as the trigger it is stored as.
+ */
+template <SFGP_AxisIndex I>
+struct AxisTag {
+    static constexpr SFGP_AxisIndex index = I;
+};
+
+/**
+ * @brief Tag naming joystick \p I, holding tags of both its axes.
+ */
+template <SFGP_JoystickIndex I>
+struct JoystickTag {
+    static constexpr SFGP_JoystickIndex index = I;
+
+    using X = AxisTag<static_cast<SFGP_AxisIndex>(SFGP_AXIS_LEFT_X + (2 * I))>;
+    using Y = AxisTag<static_cast<SFGP_AxisIndex>(SFGP_AXIS_LEFT_Y + (2 * I))>;
+};
+
+
+template <class T>
+struct is_button : std::false_type {};
+template <SFGP_ButtonIndex I>
+struct is_button<ButtonTag<I>> : std::true_type {};
+
+template <class T>
+struct is_axis : std::false_type {};
+template <SFGP_AxisIndex I>
+struct is_axis<AxisTag<I>> : std::true_type {};
+
+
+/**
+ * @brief Mask of every button in \p Buttons, as @ref SFGP_BUTTON_MASK().
+ */
+template <class... Buttons>
+inline constexpr std::uint32_t button_mask = (UINT32_C(0) | ... | Buttons::mask);
+
+
+using TouchpadFinger1   = ButtonTag<SFGP_TOUCHPAD_FINGER_1>;
+using TouchpadFinger2   = ButtonTag<SFGP_TOUCHPAD_FINGER_2>;
+using Touchpad          = ButtonTag<SFGP_TOUCHPAD>;
+
+using LeftStickButton   = ButtonTag<SFGP_BUTTON_STICK_LEFT>;
+using RightStickButton  = ButtonTag<SFGP_BUTTON_STICK_RIGHT>;
+
+using DpadUp            = ButtonTag<SFGP_BUTTON_DPAD_UP>;
+using DpadDown          = ButtonTag<SFGP_BUTTON_DPAD_DOWN>;
+using DpadLeft          = ButtonTag<SFGP_BUTTON_DPAD_LEFT>;
+using DpadRight         = ButtonTag<SFGP_BUTTON_DPAD_RIGHT>;
+
+using A                 = ButtonTag<SFGP_BUTTON_A>;
+using B                 = ButtonTag<SFGP_BUTTON_B>;
+using X                 = ButtonTag<SFGP_BUTTON_X>;
+using Y                 = ButtonTag<SFGP_BUTTON_Y>;
+
+using Guide             = ButtonTag<SFGP_BUTTON_GUIDE>;
+using Start             = ButtonTag<SFGP_BUTTON_START>;
+using Back              = ButtonTag<SFGP_BUTTON_BACK>;
+
+using LeftBumper        = ButtonTag<SFGP_BUTTON_BUMPER_LEFT>;
+using RightBumper       = ButtonTag<SFGP_BUTTON_BUMPER_RIGHT>;
+
+using LeftStick         = JoystickTag<SFGP_JOYSTICK_LEFT>;
+using RightStick        = JoystickTag<SFGP_JOYSTICK_RIGHT>;
+
+using LeftTrigger       = AxisTag<SFGP_AXIS_LEFT_TRIGGER>;
+using RightTrigger      = AxisTag<SFGP_AXIS_RIGHT_TRIGGER>;
+
+
+// ============================================================================
+//
+//      Gamepad:
+//
+// ============================================================================
+
+
+/**
+ * @brief Owning handle to an @ref SFGP_Gamepad.
+ *
+ * Can be moved but not copied, use @ref Gamepad::copy_from() for snapshots.
+ * A moved from gamepad owns nothing, and may only be assigned to or
+ * destroyed.
+ *
+ * Button queries take any number of button tags and treat them as a chord:
+ *
+ * - pressed: every button is held,
+ * - released: no button is held,
+ * - just_pressed: every button is held, and they were not all held before,
+ * - just_released: not every button is held, and they all were before.
+ *
+ * With a single button these match the `SFGP_IsButton*` queries.
+ */
+class Gamepad {
+public:
+    /**
+     * @brief Initializes gamepad with @ref SFGP_InitGamepad().
+     *
+     * Throws `std::bad_alloc` if its storage cannot be allocated, or leaves
+     * the gamepad invalid when built without exceptions.
+     */
+    Gamepad() : pad_{} {
+        if (SFGP_InitGamepad(&pad_) != SFGP_ERROR_OK) {
+            pad_ = SFGP_Gamepad{};
+#if defined(__cpp_exceptions) || defined(_CPPUNWIND)
+            throw std::bad_alloc();
+#endif
+        }
+    }
+
+    /**
+     * @brief Initializes gamepad over \p storage, which must outlive it, with
+     * @ref SFGP_InitGamepadWithStorage().
+     */
+    explicit Gamepad(SFGP_GamepadStorage &storage) noexcept : pad_{} {
+        SFGP_InitGamepadWithStorage(&pad_, &storage);
+    }
+
+    ~Gamepad() { SFGP_DeinitGamepad(&pad_); }
+
+    Gamepad(const Gamepad &) = delete;
+    Gamepad &operator=(const Gamepad &) = delete;
+
+    // Every handle within SFGP_Gamepad points into its storage block rather
+    // than into the struct itself, so moving is a plain copy.
+    Gamepad(Gamepad &&other) noexcept : pad_(other.pad_) {
+        other.pad_ = SFGP_Gamepad{};
+    }
+
+    Gamepad &operator=(Gamepad &&other) noexcept {
+        if (this != &other) {
+            SFGP_DeinitGamepad(&pad_);
+            pad_ = other.pad_;
+            other.pad_ = SFGP_Gamepad{};
+        }
+
+        return *this;
+    }
+
+    /**
+     * @brief Whether gamepad holds state, clear once moved from.
+     */
+    bool valid() const noexcept { return pad_.storage != nullptr; }
+    explicit operator bool() const noexcept { return valid(); }
+
+    SFGP_Gamepad *get() noexcept { return &pad_; }
+    const SFGP_Gamepad *get() const noexcept { return &pad_; }
+
+    /** @see SFGP_UpdateGamepad() */
+    SFGP_Error update(const std::uint8_t *byte_array) noexcept {
+        return SFGP_UpdateGamepad(&pad_, byte_array);
+    }
+
+    /** @see SFGP_DecodeGamepad() */
+    SFGP_Error decode(const std::uint8_t *payload,
+            std::size_t length) noexcept {
+        return SFGP_DecodeGamepad(&pad_, payload, length);
+    }
+
+    /** @see SFGP_CopyGamepad() */
+    void copy_from(const Gamepad &src) noexcept {
+        SFGP_CopyGamepad(&pad_, &src.pad_);
+    }
+
+    // Buttons
+
+    template <class... Buttons>
+    bool pressed() const noexcept {
+        constexpr std::uint32_t mask = checked_mask<Buttons...>();
+        return (state().buttons_current & mask) == mask;
+    }
+
+    template <class... Buttons>
+    bool released() const noexcept {
+        constexpr std::uint32_t mask = checked_mask<Buttons...>();
+        return (state().buttons_current & mask) == 0;
+    }
+
+    template <class... Buttons>
+    bool just_pressed() const noexcept {
+        constexpr std::uint32_t mask = checked_mask<Buttons...>();
+        const SFGP_GamepadState &s = state();
+        return ((s.buttons_current & mask) == mask)
+            & ((s.buttons_last & mask) != mask);
+    }
+
+    template <class... Buttons>
+    bool just_released() const noexcept {
+        constexpr std::uint32_t mask = checked_mask<Buttons...>();
+        const SFGP_GamepadState &s = state();
+        return ((s.buttons_current & mask) != mask)
+            & ((s.buttons_last & mask) == mask);
+    }
+
+    /** @see SFGP_GetButtonsPressed() */
+    std::uint32_t buttons() const noexcept {
+        return _SFGP_InlineGetButtonsPressed(&pad_);
+    }
+
+    // Axes, joystick axes treating max and min as pressed along +-1.
+
+    template <class Axis>
+    float value() const noexcept {
+        return _SFGP_InlineGetTriggerValue(&axis<Axis>());
+    }
+
+    template <class Axis>
+    float raw_value() const noexcept {
+        return _SFGP_InlineGetTriggerRawValue(&axis<Axis>());
+    }
+
+    template <class Axis>
+    float velocity() const noexcept {
+        return _SFGP_InlineGetTriggerVelocity(&axis<Axis>());
+    }
+
+    template <class Axis>
+    float acceleration() const noexcept {
+        return _SFGP_InlineGetTriggerAcceleration(&axis<Axis>());
+    }
+
+    template <class Axis>
+    bool at_max() const noexcept {
+        return _SFGP_InlineIsTriggerPressed(&axis<Axis>());
+    }
+
+    template <class Axis>
+    bool just_at_max() const noexcept {
+        return _SFGP_InlineIsTriggerJustPressed(&axis<Axis>());
+    }
+
+    template <class Axis>
+    bool at_min() const noexcept {
+        return _SFGP_InlineIsTriggerAtMin(&axis<Axis>());
+    }
+
+    template <class Axis>
+    bool just_at_min() const noexcept {
+        return _SFGP_InlineIsTriggerJustAtMin(&axis<Axis>());
+    }
+
+    template <class Axis>
+    bool at_zero() const noexcept {
+        return _SFGP_InlineIsTriggerAtZero(&axis<Axis>());
+    }
+
+    template <class Axis>
+    bool just_at_zero() const noexcept {
+        return _SFGP_InlineIsTriggerJustAtZero(&axis<Axis>());
+    }
+
+    // Whole pad
+
+    std::int64_t timestamp() const noexcept {
+        return _SFGP_InlineGetGamepadTimestamp(&pad_);
+    }
+
+    std::uint32_t generation() const noexcept {
+        return _SFGP_InlineGetGamepadGeneration(&pad_);
+    }
+
+    std::int32_t id() const noexcept {
+        return _SFGP_InlineGetGamepadId(&pad_);
+    }
+
+    std::uint8_t version() const noexcept {
+        return _SFGP_InlineGetGamepadVersion(&pad_);
+    }
+
+    float touchpad_x(SFGP_TouchpadFinger finger) const noexcept {
+        return _SFGP_InlineGetTouchpadX(&pad_, finger);
+    }
+
+    float touchpad_y(SFGP_TouchpadFinger finger) const noexcept {
+        return _SFGP_InlineGetTouchpadY(&pad_, finger);
+    }
+
+private:
+    template <class... Buttons>
+    static constexpr std::uint32_t checked_mask() noexcept {
+        static_assert(sizeof... (Buttons) > 0, "No buttons given");
+        static_assert((is_button<Buttons>::value && ...),
+                "Expected button tags");
+        return button_mask<Buttons...>;
+    }
+
+    const SFGP_GamepadState &state() const noexcept {
+        return *_SFGP_GetState(&pad_);
+    }
+
+    template <class Axis>
+    const SFGP_Trigger &axis() const noexcept {
+        static_assert(is_axis<Axis>::value,
+                "Expected axis tag, such as LeftTrigger or LeftStick::X");
+        return state().axes[Axis::index];
+    }
+
+    SFGP_Gamepad pad_;
+};
+
+
+} // namespace sftk::sfgp
+
+#endif // __SFTK_SFGP_HPP_HEADER__
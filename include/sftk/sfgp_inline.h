@@ -0,0 +1,434 @@
+/**
+ * @file sftk/sfgp_inline.h
+ * @brief Header only queries over the published layout of gamepad state.
+ *
+ * Every `SFGP_Is*` and `SFGP_Get*` query of a button, trigger, joystick, or
+ * whole pad only reads a field or two of @ref SFGP_GamepadStorage. Including
+ * this header after (or instead of) sftk/sfgp.h defines all of them as
+ * `static inline` functions over the storage layout below, and redirects the
+ * public names to them, so compiled callers pay no call into the shared
+ * library for a query. The exported functions remain, and are still what
+ * bindings and function pointers resolve to.
+ *
+ * Defining `SFGP_INLINE_NO_REDIRECT` before including this header keeps the
+ * public names pointing at the exported functions, leaving the inline ones
+ * under their `_SFGP_Inline*` names.
+ *
+ * @note Code built with this header depends on the layout of
+ * @ref SFGP_GamepadState, and must be rebuilt along with SFGP whenever it
+ * changes.
+ */
+
+
+#ifndef __SFTK_SFGP_INLINE_HEADER__
+#define __SFTK_SFGP_INLINE_HEADER__
+
+#include <sftk/sfgp.h>
+
+#ifdef __cplusplus
+    extern "C" {
+#endif // __cplusplus
+
+
+#include <stdint.h>
+#include <stddef.h>
+#include <assert.h>
+
+
+// ============================================================================
+//
+//      Layout:
+//      Contents of SFGP_GamepadStorage.
+//      
+// ============================================================================
+
+
+/**
+ * @brief Handle to an individual button.
+ *
+ * Button state itself is kept as masks within @ref SFGP_GamepadState. Each
+ * handle only knows its own position within the state's handle array, which
+ * is enough to find its way back to the masks.
+ */
+struct SFGP_Button {
+    uint8_t index; /**< @ref SFGP_ButtonIndex of this button. */
+};
+
+
+/**
+ * @brief Every valid bit of a button mask.
+ */
+#define _SFGP_BUTTON_MASK_ALL ((UINT32_C(1) << SFGP_BUTTON_ELEM) - 1)
+
+
+/**
+ * @brief Data required to perform checks on an individual trigger.
+ */
+struct SFGP_Trigger {
+    float last;         /**< Last known value of trigger. */
+    float current;      /**< Latest known value of trigger. */
+    float velocity;     /**< Units per second between last and current. */
+    float acceleration; /**< Units per second squared of velocity. */
+    float raw;          /**< Latest value before filtering and shaping. */
+    uint8_t flags;      /**< `_SFGP_AXIS_*` latches, current and last. */
+    uint8_t has_rate;   /**< Set if velocity was taken over the latest dt. */
+};
+
+
+#define _SFGP_AXIS_AT_MAX       0x1     /**< Latched at or past max. */
+#define _SFGP_AXIS_AT_MIN       0x2     /**< Latched at or past min. */
+#define _SFGP_AXIS_LAST_SHIFT   2       /**< Shift of last latches. */
+
+/**
+ * @brief Whether latch \p flag of trigger \p self is currently set.
+ */
+static inline int8_t _SFGP_IsLatched(const SFGP_Trigger *const self,
+        uint8_t flag) {
+    return (self->flags & flag) != 0;
+}
+
+/**
+ * @brief Whether latch \p flag of trigger \p self was set this update.
+ */
+static inline int8_t _SFGP_IsJustLatched(const SFGP_Trigger *const self,
+        uint8_t flag) {
+    return (self->flags & ~(self->flags >> _SFGP_AXIS_LAST_SHIFT) & flag) != 0;
+}
+
+
+/**
+ * @brief Data required to perform checks on an individual joystick.
+ */
+struct SFGP_Joystick {
+    struct SFGP_Trigger x; /**< Trigger data representing joysticks x axis. */
+    struct SFGP_Trigger y; /**< Trigger data representing joysticks y axis. */
+};
+
+
+/**
+ * @brief Layout of @ref SFGP_GamepadStorage.
+ *
+ * Every control of a gamepad stored inline so that the whole pad occupies one
+ * contiguous block. Everything queries read comes first and fits within the
+ * first three cache lines, with fields of newer payloads behind them.
+ */
+typedef struct SFGP_GamepadState {
+    int64_t timestamp;          /**< Timestamp of latest frame. */
+
+    uint32_t buttons_last;      /**< Last known button mask.    */
+    uint32_t buttons_current;   /**< Latest known button mask.  */
+    uint32_t buttons_raw;       /**< Latest mask before filtering. */
+    uint32_t generation;        /**< Frames applied since init. */
+    int32_t id;                 /**< Gamepad ID of latest frame. */
+
+    // Joysticks and triggers are laid out back to back in the same order as
+    // the gamepad data array, so they can also be walked as a single array.
+    union {
+        struct {
+            SFGP_Joystick joysticks[SFGP_JOYSTICK_ELEM];
+            SFGP_Trigger triggers[SFGP_TRIGGER_ELEM];
+        };
+
+        SFGP_Trigger axes[SFGP_AXIS_ELEM]; /**< By @ref SFGP_AxisIndex. */
+    };
+
+    SFGP_Button buttons[SFGP_BUTTON_ELEM];
+
+    /** Latest touchpad finger x, y coordinates, from payload version 5. */
+    float touchpad[SFGP_FINGER_ELEM][2];
+
+    uint8_t user;               /**< SDK `GamepadUser`, from version 2. */
+    uint8_t type;               /**< SDK `GamepadType`, from version 4. */
+    uint8_t version;            /**< Payload version of latest frame. */
+} SFGP_GamepadState;
+
+
+/**
+ * @brief Returns state stored within \p pad's storage block.
+ */
+static inline SFGP_GamepadState *_SFGP_GetState(const SFGP_Gamepad *const pad) {
+    return (SFGP_GamepadState *) pad->storage;
+}
+
+/**
+ * @brief Returns state the button handle \p self is stored in.
+ */
+static inline const SFGP_GamepadState *_SFGP_GetButtonState(
+        const SFGP_Button *const self) {
+    return (const SFGP_GamepadState *) ((const uint8_t *) (self - self->index)
+            - offsetof(SFGP_GamepadState, buttons));
+}
+
+
+// ============================================================================
+//
+//      Button:
+//      Inline button queries.
+//      
+// ============================================================================
+
+
+static inline int8_t _SFGP_InlineIsButtonPressed(
+        const SFGP_Button *const self) {
+    assert(self != NULL);
+    const SFGP_GamepadState *state = _SFGP_GetButtonState(self);
+    return (state->buttons_current & SFGP_BUTTON_MASK(self->index)) != 0;
+}
+
+static inline int8_t _SFGP_InlineIsButtonJustPressed(
+        const SFGP_Button *const self) {
+    assert(self != NULL);
+    const SFGP_GamepadState *state = _SFGP_GetButtonState(self);
+    return (state->buttons_current & ~state->buttons_last
+            & SFGP_BUTTON_MASK(self->index)) != 0;
+}
+
+static inline int8_t _SFGP_InlineIsButtonReleased(
+        const SFGP_Button *const self) {
+    assert(self != NULL);
+    const SFGP_GamepadState *state = _SFGP_GetButtonState(self);
+    return (state->buttons_current & SFGP_BUTTON_MASK(self->index)) == 0;
+}
+
+static inline int8_t _SFGP_InlineIsButtonJustReleased(
+        const SFGP_Button *const self) {
+    assert(self != NULL);
+    const SFGP_GamepadState *state = _SFGP_GetButtonState(self);
+    return (~state->buttons_current & state->buttons_last
+            & SFGP_BUTTON_MASK(self->index)) != 0;
+}
+
+
+// ============================================================================
+//
+//      Trigger:
+//      Inline trigger queries, shared by both axes of a joystick.
+//      
+// ============================================================================
+
+
+static inline int8_t _SFGP_InlineIsTriggerPressed(
+        const SFGP_Trigger *const self) {
+    assert(self != NULL);
+    return _SFGP_IsLatched(self, _SFGP_AXIS_AT_MAX);
+}
+
+static inline int8_t _SFGP_InlineIsTriggerJustPressed(
+        const SFGP_Trigger *const self) {
+    assert(self != NULL);
+    return _SFGP_IsJustLatched(self, _SFGP_AXIS_AT_MAX);
+}
+
+static inline int8_t _SFGP_InlineIsTriggerAtMin(
+        const SFGP_Trigger *const self) {
+    assert(self != NULL);
+    return _SFGP_IsLatched(self, _SFGP_AXIS_AT_MIN);
+}
+
+static inline int8_t _SFGP_InlineIsTriggerJustAtMin(
+        const SFGP_Trigger *const self) {
+    assert(self != NULL);
+    return _SFGP_IsJustLatched(self, _SFGP_AXIS_AT_MIN);
+}
+
+static inline int8_t _SFGP_InlineIsTriggerReleased(
+        const SFGP_Trigger *const self) {
+    assert(self != NULL);
+    return self->current <= 0.0f;
+}
+
+static inline int8_t _SFGP_InlineIsTriggerJustReleased(
+        const SFGP_Trigger *const self) {
+    assert(self != NULL);
+    return self->current <= 0.0f && self->last > 0.0f;
+}
+
+static inline int8_t _SFGP_InlineIsTriggerAtZero(
+        const SFGP_Trigger *const self) {
+    assert(self != NULL);
+    return self->current == 0.0f;
+}
+
+static inline int8_t _SFGP_InlineIsTriggerJustAtZero(
+        const SFGP_Trigger *const self) {
+    assert(self != NULL);
+    return self->current == 0.0f && self->last != 0.0f;
+}
+
+static inline float _SFGP_InlineGetTriggerValue(
+        const SFGP_Trigger *const self) {
+    assert(self != NULL);
+    return self->current;
+}
+
+static inline float _SFGP_InlineGetTriggerRawValue(
+        const SFGP_Trigger *const self) {
+    assert(self != NULL);
+    return self->raw;
+}
+
+static inline float _SFGP_InlineGetTriggerVelocity(
+        const SFGP_Trigger *const self) {
+    assert(self != NULL);
+    return self->velocity;
+}
+
+static inline float _SFGP_InlineGetTriggerAcceleration(
+        const SFGP_Trigger *const self) {
+    assert(self != NULL);
+    return self->acceleration;
+}
+
+
+// ============================================================================
+//
+//      Gamepad:
+//      Inline whole pad queries.
+//      
+// ============================================================================
+
+
+static inline uint32_t _SFGP_InlineGetButtonsPressed(
+        const SFGP_Gamepad *const pad) {
+    assert(pad != NULL);
+    return _SFGP_GetState(pad)->buttons_current;
+}
+
+static inline uint32_t _SFGP_InlineGetButtonsJustPressed(
+        const SFGP_Gamepad *const pad) {
+    assert(pad != NULL);
+    const SFGP_GamepadState *state = _SFGP_GetState(pad);
+    return state->buttons_current & ~state->buttons_last;
+}
+
+static inline uint32_t _SFGP_InlineGetButtonsJustReleased(
+        const SFGP_Gamepad *const pad) {
+    assert(pad != NULL);
+    const SFGP_GamepadState *state = _SFGP_GetState(pad);
+    return ~state->buttons_current & state->buttons_last;
+}
+
+static inline int64_t _SFGP_InlineGetGamepadTimestamp(
+        const SFGP_Gamepad *const pad) {
+    assert(pad != NULL);
+    return _SFGP_GetState(pad)->timestamp;
+}
+
+static inline uint32_t _SFGP_InlineGetGamepadGeneration(
+        const SFGP_Gamepad *const pad) {
+    assert(pad != NULL);
+    return _SFGP_GetState(pad)->generation;
+}
+
+static inline int32_t _SFGP_InlineGetGamepadId(const SFGP_Gamepad *const pad) {
+    assert(pad != NULL);
+    return _SFGP_GetState(pad)->id;
+}
+
+static inline uint8_t _SFGP_InlineGetGamepadVersion(
+        const SFGP_Gamepad *const pad) {
+    assert(pad != NULL);
+    return _SFGP_GetState(pad)->version;
+}
+
+static inline uint8_t _SFGP_InlineGetGamepadUser(
+        const SFGP_Gamepad *const pad) {
+    assert(pad != NULL);
+    return _SFGP_GetState(pad)->user;
+}
+
+static inline uint8_t _SFGP_InlineGetGamepadType(
+        const SFGP_Gamepad *const pad) {
+    assert(pad != NULL);
+    return _SFGP_GetState(pad)->type;
+}
+
+static inline float _SFGP_InlineGetTouchpadX(const SFGP_Gamepad *const pad,
+        SFGP_TouchpadFinger finger) {
+    assert(pad != NULL);
+    assert(finger < SFGP_FINGER_ELEM);
+    return _SFGP_GetState(pad)->touchpad[finger][0];
+}
+
+static inline float _SFGP_InlineGetTouchpadY(const SFGP_Gamepad *const pad,
+        SFGP_TouchpadFinger finger) {
+    assert(pad != NULL);
+    assert(finger < SFGP_FINGER_ELEM);
+    return _SFGP_GetState(pad)->touchpad[finger][1];
+}
+
+
+// ============================================================================
+//
+//      Redirection:
+//      Public query names resolving to the inline queries.
+//      
+// ============================================================================
+
+
+#ifndef SFGP_INLINE_NO_REDIRECT
+
+// Function like macros, so taking the address of a query still yields the
+// exported function.
+
+#define SFGP_IsButtonPressed(self)      _SFGP_InlineIsButtonPressed(self)
+#define SFGP_IsButtonJustPressed(self)  _SFGP_InlineIsButtonJustPressed(self)
+#define SFGP_IsButtonReleased(self)     _SFGP_InlineIsButtonReleased(self)
+#define SFGP_IsButtonJustReleased(self) _SFGP_InlineIsButtonJustReleased(self)
+
+#define SFGP_IsTriggerPressed(self)     _SFGP_InlineIsTriggerPressed(self)
+#define SFGP_IsTriggerJustPressed(self) _SFGP_InlineIsTriggerJustPressed(self)
+#define SFGP_IsTriggerReleased(self)    _SFGP_InlineIsTriggerReleased(self)
+#define SFGP_IsTriggerJustReleased(self) \
+    _SFGP_InlineIsTriggerJustReleased(self)
+#define SFGP_GetTriggerValue(self)      _SFGP_InlineGetTriggerValue(self)
+#define SFGP_GetTriggerRawValue(self)   _SFGP_InlineGetTriggerRawValue(self)
+#define SFGP_GetTriggerVelocity(self)   _SFGP_InlineGetTriggerVelocity(self)
+#define SFGP_GetTriggerAcceleration(self) \
+    _SFGP_InlineGetTriggerAcceleration(self)
+
+#define SFGP_IsXAtMax(self)         _SFGP_InlineIsTriggerPressed(&(self)->x)
+#define SFGP_IsXJustAtMax(self)     _SFGP_InlineIsTriggerJustPressed(&(self)->x)
+#define SFGP_IsXAtMin(self)         _SFGP_InlineIsTriggerAtMin(&(self)->x)
+#define SFGP_IsXJustAtMin(self)     _SFGP_InlineIsTriggerJustAtMin(&(self)->x)
+#define SFGP_IsXAtZero(self)        _SFGP_InlineIsTriggerAtZero(&(self)->x)
+#define SFGP_IsXJustAtZero(self)    _SFGP_InlineIsTriggerJustAtZero(&(self)->x)
+#define SFGP_GetXValue(self)        _SFGP_InlineGetTriggerValue(&(self)->x)
+#define SFGP_GetXRawValue(self)     _SFGP_InlineGetTriggerRawValue(&(self)->x)
+#define SFGP_GetXVelocity(self)     _SFGP_InlineGetTriggerVelocity(&(self)->x)
+#define SFGP_GetXAcceleration(self) \
+    _SFGP_InlineGetTriggerAcceleration(&(self)->x)
+
+#define SFGP_IsYAtMax(self)         _SFGP_InlineIsTriggerPressed(&(self)->y)
+#define SFGP_IsYJustAtMax(self)     _SFGP_InlineIsTriggerJustPressed(&(self)->y)
+#define SFGP_IsYAtMin(self)         _SFGP_InlineIsTriggerAtMin(&(self)->y)
+#define SFGP_IsYJustAtMin(self)     _SFGP_InlineIsTriggerJustAtMin(&(self)->y)
+#define SFGP_IsYAtZero(self)        _SFGP_InlineIsTriggerAtZero(&(self)->y)
+#define SFGP_IsYJustAtZero(self)    _SFGP_InlineIsTriggerJustAtZero(&(self)->y)
+#define SFGP_GetYValue(self)        _SFGP_InlineGetTriggerValue(&(self)->y)
+#define SFGP_GetYRawValue(self)     _SFGP_InlineGetTriggerRawValue(&(self)->y)
+#define SFGP_GetYVelocity(self)     _SFGP_InlineGetTriggerVelocity(&(self)->y)
+#define SFGP_GetYAcceleration(self) \
+    _SFGP_InlineGetTriggerAcceleration(&(self)->y)
+
+#define SFGP_GetButtonsPressed(pad)     _SFGP_InlineGetButtonsPressed(pad)
+#define SFGP_GetButtonsJustPressed(pad) _SFGP_InlineGetButtonsJustPressed(pad)
+#define SFGP_GetButtonsJustReleased(pad) \
+    _SFGP_InlineGetButtonsJustReleased(pad)
+#define SFGP_GetGamepadTimestamp(pad)   _SFGP_InlineGetGamepadTimestamp(pad)
+#define SFGP_GetGamepadGeneration(pad)  _SFGP_InlineGetGamepadGeneration(pad)
+#define SFGP_GetGamepadId(pad)          _SFGP_InlineGetGamepadId(pad)
+#define SFGP_GetGamepadVersion(pad)     _SFGP_InlineGetGamepadVersion(pad)
+#define SFGP_GetGamepadUser(pad)        _SFGP_InlineGetGamepadUser(pad)
+#define SFGP_GetGamepadType(pad)        _SFGP_InlineGetGamepadType(pad)
+#define SFGP_GetTouchpadX(pad, finger)  _SFGP_InlineGetTouchpadX(pad, finger)
+#define SFGP_GetTouchpadY(pad, finger)  _SFGP_InlineGetTouchpadY(pad, finger)
+
+#endif // SFGP_INLINE_NO_REDIRECT
+
+
+#ifdef __cplusplus
+    }
+#endif // __cplusplus
+
+#endif // __SFTK_SFGP_INLINE_HEADER__
@@ -0,0 +1,608 @@
+/**
+ * @file analytics.c
+ * @brief Driver statistics over many recording files, on a work stealing
+ * pool of threads.
+ *
+ * Every file is read front to back in chunks of _SFGP_ANALYTICS_CHUNK bytes,
+ * so memory use stays flat however large the dataset, and each frame is
+ * decoded into a gamepad exactly as a live update would be. Aggregates are
+ * only ever written by the worker that owns them.
+ *
+ * Workers hold a Chase-Lev deque each, filled once before they start. An
+ * owner pops its largest remaining file off the bottom, a thief steals the
+ * smallest off the top, so big files start early and small ones fill in the
+ * gaps at the end.
+ */
+
+
+#include <sftk/sfgp.h>
+#include "sfgp_internal.h"
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <assert.h>
+
+#if !_WIN32
+    #include <fcntl.h>
+    #include <pthread.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif // !_WIN32
+
+
+#define _SFGP_ANALYTICS_CHUNK   (1u << 20)
+
+
+/**
+ * @brief Gamepad of a single file being analyzed.
+ */
+typedef struct _SFGP_AnalyticsPad {
+    SFGP_Gamepad pad;
+    SFGP_GamepadStorage storage;
+
+    int32_t id;
+    int64_t first;                  /**< Timestamp of first frame. */
+    int64_t last;                   /**< Timestamp of latest frame. */
+    uint32_t buttons;               /**< Held since latest frame. */
+    uint8_t bins[SFGP_AXIS_ELEM];   /**< Magnitude bins since latest frame. */
+    uint8_t answered;               /**< Set once first input was timed. */
+} _SFGP_AnalyticsPad;
+
+
+// ============================================================================
+//
+//      Aggregates:
+//
+// ============================================================================
+
+
+void SFGP_InitAnalyticsConfig(SFGP_AnalyticsConfig *const config) {
+    assert(config != NULL);
+
+    config->start = 0;
+    config->deadzone = 0.1f;
+    config->threads = 0;
+}
+
+void SFGP_InitAnalytics(SFGP_Analytics *const analytics) {
+    assert(analytics != NULL);
+    memset(analytics, 0, sizeof (*analytics));
+}
+
+/**
+ * @brief Counts \p count completions of chord \p buttons into \p self.
+ */
+static void _SFGP_CountChord(SFGP_Analytics *const self, uint32_t buttons,
+        uint32_t count) {
+    for (uint32_t i = 0; i < self->chord_count; ++i) {
+        if (self->chords[i].buttons == buttons) {
+            self->chords[i].count += count;
+            return;
+        }
+    }
+
+    if (self->chord_count == SFGP_ANALYTICS_CHORDS) {
+        self->chords_dropped += count;
+        return;
+    }
+
+    self->chords[self->chord_count++] = (SFGP_ChordCount) {
+        .buttons = buttons,
+        .count = count,
+    };
+}
+
+void SFGP_MergeAnalytics(SFGP_Analytics *const dst,
+        const SFGP_Analytics *const src) {
+    assert(dst != NULL);
+    assert(src != NULL);
+
+    dst->files += src->files;
+    dst->failed += src->failed;
+    dst->frames += src->frames;
+    dst->skipped += src->skipped;
+    dst->gamepads += src->gamepads;
+
+    for (int i = 0; i < SFGP_BUTTON_ELEM; ++i) {
+        dst->presses[i] += src->presses[i];
+        dst->held[i] += src->held[i];
+    }
+
+    for (int i = 0; i < SFGP_AXIS_ELEM; ++i) {
+        for (int j = 0; j < SFGP_ANALYTICS_BINS; ++j)
+            dst->utilization[i][j] += src->utilization[i][j];
+    }
+
+    for (int i = 0; i < SFGP_HISTOGRAM_BUCKETS; ++i)
+        dst->first_input.counts[i] += src->first_input.counts[i];
+    dst->first_input.total += src->first_input.total;
+    if (src->first_input.max > dst->first_input.max)
+        dst->first_input.max = src->first_input.max;
+    dst->no_input += src->no_input;
+
+    for (uint32_t i = 0; i < src->chord_count; ++i)
+        _SFGP_CountChord(dst, src->chords[i].buttons, src->chords[i].count);
+    dst->chords_dropped += src->chords_dropped;
+}
+
+
+// ============================================================================
+//
+//      Files:
+//
+// ============================================================================
+
+
+/**
+ * @brief Returns gamepad of \p pads for \p id, starting one if there is
+ * room, or `NULL`.
+ */
+static _SFGP_AnalyticsPad *_SFGP_GetAnalyticsPad(
+        _SFGP_AnalyticsPad *const pads, size_t *const count,
+        const _SFGP_Frame *const frame) {
+    for (size_t i = 0; i < *count; ++i)
+        if (pads[i].id == frame->id) return &pads[i];
+
+    if (*count == SFGP_ANALYTICS_GAMEPADS) return NULL;
+
+    _SFGP_AnalyticsPad *const self = &pads[(*count)++];
+    memset(self, 0, sizeof (*self));
+    SFGP_InitGamepadWithStorage(&self->pad, &self->storage);
+
+    self->id = frame->id;
+    self->first = frame->timestamp;
+    self->last = frame->timestamp;
+    return self;
+}
+
+/**
+ * @brief Decodes \p frame into \p self, adding what changed to \p out.
+ */
+static void _SFGP_AnalyzeFrame(SFGP_Analytics *const out,
+        _SFGP_AnalyticsPad *const self, const _SFGP_Frame *const frame,
+        const SFGP_AnalyticsConfig *const config) {
+    const SFGP_GamepadState *const state = _SFGP_GetState(&self->pad);
+    const uint32_t generation = state->generation;
+
+    // Whatever was held since the previous frame lasted until this one.
+    const int64_t dt = frame->timestamp - self->last;
+    if (dt > 0) {
+        for (uint32_t held = self->buttons; held != 0; held &= held - 1)
+            out->held[_SFGP_GetMaskIndex(held)] += dt;
+
+        for (int i = 0; i < SFGP_AXIS_ELEM; ++i)
+            out->utilization[i][self->bins[i]] += dt;
+    }
+
+    self->last = frame->timestamp;
+    ++out->frames;
+
+    _SFGP_ApplyFrame(&self->pad, frame);
+    if (state->generation == generation) return;
+
+    const uint32_t pressed = state->buttons_current & ~state->buttons_last;
+    for (uint32_t just = pressed; just != 0; just &= just - 1)
+        ++out->presses[_SFGP_GetMaskIndex(just)];
+
+    if (pressed != 0 && __builtin_popcount(state->buttons_current) >= 2)
+        _SFGP_CountChord(out, state->buttons_current, 1);
+
+    int moved = 0;
+    for (int i = 0; i < SFGP_AXIS_ELEM; ++i) {
+        const float magnitude = fabsf(state->axes[i].current);
+        const int bin = (int) (magnitude * SFGP_ANALYTICS_BINS);
+
+        self->bins[i] = (uint8_t) ((bin < SFGP_ANALYTICS_BINS)
+                ? bin : SFGP_ANALYTICS_BINS - 1);
+        moved |= magnitude >= config->deadzone;
+    }
+
+    self->buttons = state->buttons_current;
+
+    const int64_t since = frame->timestamp - self->first - config->start;
+    if (!self->answered && since >= 0
+            && (moved || state->buttons_current != 0)) {
+        SFGP_Histogram *const histogram = &out->first_input;
+        ++histogram->counts[_SFGP_GetHistogramBucket(since)];
+        ++histogram->total;
+        if (since > histogram->max) histogram->max = since;
+
+        self->answered = 1;
+    }
+}
+
+/**
+ * @brief Streams recording \p file through \p chunk into \p out.
+ */
+static SFGP_Error _SFGP_AnalyzeStream(SFGP_Analytics *const out,
+        FILE *const file, uint8_t *const chunk,
+        const SFGP_AnalyticsConfig *const config) {
+    _SFGP_RecordHeader header;
+
+    if (fread(&header, sizeof (header), 1, file) != 1
+            || memcmp(header.magic, _SFGP_RECORD_MAGIC,
+                sizeof (_SFGP_RECORD_MAGIC)) != 0
+            || header.version != _SFGP_RECORD_VERSION
+            || header.header_size != sizeof (header))
+        return _SFGP_SetError(SFGP_ERROR_INVALID_FILE);
+
+    // Frames of closed recordings end where the index starts, those of
+    // unclosed ones at the first torn frame.
+    const uint64_t end = (header.index_offset != 0)
+        ? header.index_offset : UINT64_MAX;
+
+    _SFGP_AnalyticsPad pads[SFGP_ANALYTICS_GAMEPADS];
+    size_t pad_count = 0;
+
+    uint64_t offset = sizeof (header);
+    size_t head = 0, tail = 0;
+    SFGP_Error error = SFGP_ERROR_OK;
+
+    while (offset < end) {
+        if (tail - head < sizeof (_SFGP_FrameHeader)) goto refill;
+
+        _SFGP_FrameHeader frame_header;
+        memcpy(&frame_header, &chunk[head], sizeof (frame_header));
+
+        const uint64_t size = sizeof (frame_header)
+            + _SFGP_Pad8(frame_header.length);
+        if (size > _SFGP_ANALYTICS_CHUNK || offset + size > end) {
+            error = _SFGP_SetError(SFGP_ERROR_INVALID_FILE);
+            break;
+        }
+
+        if (tail - head < size) goto refill;
+
+        _SFGP_Frame frame;
+        _SFGP_AnalyticsPad *pad = NULL;
+
+        if (frame_header.length >= SFGP_FRAME_SIZE) {
+            _SFGP_ReadFrame(&frame,
+                    &chunk[head + sizeof (frame_header)], 1, 0);
+            if (_SFGP_IsFrameValid(&frame))
+                pad = _SFGP_GetAnalyticsPad(pads, &pad_count, &frame);
+        }
+
+        if (pad != NULL) _SFGP_AnalyzeFrame(out, pad, &frame, config);
+        else ++out->skipped;
+
+        head += size;
+        offset += size;
+        continue;
+
+refill:
+        memmove(chunk, &chunk[head], tail - head);
+        tail -= head;
+        head = 0;
+
+        const size_t read = fread(&chunk[tail], 1,
+                _SFGP_ANALYTICS_CHUNK - tail, file);
+        if (read == 0) {
+            if (ferror(file)) error = _SFGP_SetError(SFGP_ERROR_IO);
+            else if (end != UINT64_MAX)
+                error = _SFGP_SetError(SFGP_ERROR_INVALID_FILE);
+            break;
+        }
+
+        tail += read;
+    }
+
+    out->gamepads += pad_count;
+    for (size_t i = 0; i < pad_count; ++i)
+        out->no_input += !pads[i].answered;
+
+    return error;
+}
+
+/**
+ * @brief Adds file at \p path to \p out, counting it as failed if it could
+ * not be read in full.
+ */
+static SFGP_Error _SFGP_AnalyzePath(SFGP_Analytics *const out,
+        const char *const path, uint8_t *const chunk,
+        const SFGP_AnalyticsConfig *const config) {
+    ++out->files;
+
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) {
+        ++out->failed;
+        return _SFGP_SetError(SFGP_ERROR_IO);
+    }
+
+    // Chunks are already large, stdio buffering would only add a copy.
+    setvbuf(file, NULL, _IONBF, 0);
+#if !_WIN32 && defined(POSIX_FADV_SEQUENTIAL)
+    posix_fadvise(fileno(file), 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+
+    const SFGP_Error error = _SFGP_AnalyzeStream(out, file, chunk, config);
+    fclose(file);
+
+    if (error != SFGP_ERROR_OK) ++out->failed;
+
+    return error;
+}
+
+
+SFGP_Error SFGP_AnalyzeFile(SFGP_Analytics *const analytics,
+        const char *const path, const SFGP_AnalyticsConfig *const config) {
+    assert(analytics != NULL);
+    assert(path != NULL);
+    assert(config != NULL);
+
+    uint8_t *const chunk = malloc(_SFGP_ANALYTICS_CHUNK);
+    if (chunk == NULL) return _SFGP_SetError(SFGP_ERROR_FAILED_ALLOCATION);
+
+    const SFGP_Error error = _SFGP_AnalyzePath(analytics, path, chunk, config);
+    free(chunk);
+
+    return error;
+}
+
+
+// ============================================================================
+//
+//      Pool:
+//
+// ============================================================================
+
+
+#if !_WIN32
+
+/**
+ * @brief Worker of the pool, with the ends of its deque a cache line apart
+ * from each other and from the rest.
+ *
+ * Padded rather than aligned, as calloc() does not promise cache line
+ * alignment.
+ */
+typedef struct _SFGP_AnalyticsWorker {
+    int64_t top;                    /**< Next file to steal. */
+    uint8_t top_padding[64 - sizeof (int64_t)];
+    int64_t bottom;                 /**< One past next file to pop. */
+    uint8_t bottom_padding[64 - sizeof (int64_t)];
+
+    struct _SFGP_AnalyticsPool *pool;
+    const size_t *files;            /**< Deque, indexes into pool paths. */
+    uint8_t *chunk;
+    pthread_t thread;
+    uint8_t started;
+    SFGP_Analytics result;
+} _SFGP_AnalyticsWorker;
+
+typedef struct _SFGP_AnalyticsPool {
+    const char *const *paths;
+    const SFGP_AnalyticsConfig *config;
+    _SFGP_AnalyticsWorker *workers;
+    size_t count;                   /**< Workers. */
+} _SFGP_AnalyticsPool;
+
+
+/**
+ * @brief Takes the bottom file off the deque of \p self, owner only.
+ *
+ * @returns Index of file, or SIZE_MAX once empty.
+ */
+static size_t _SFGP_PopFile(_SFGP_AnalyticsWorker *const self) {
+    const int64_t bottom = __atomic_load_n(&self->bottom, __ATOMIC_RELAXED) - 1;
+    __atomic_store_n(&self->bottom, bottom, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    int64_t top = __atomic_load_n(&self->top, __ATOMIC_RELAXED);
+
+    if (top > bottom) {
+        __atomic_store_n(&self->bottom, bottom + 1, __ATOMIC_RELAXED);
+        return SIZE_MAX;
+    }
+
+    size_t file = self->files[bottom];
+
+    // Last file left, race thieves for it.
+    if (top == bottom) {
+        if (!__atomic_compare_exchange_n(&self->top, &top, top + 1, 0,
+                    __ATOMIC_SEQ_CST, __ATOMIC_RELAXED))
+            file = SIZE_MAX;
+        __atomic_store_n(&self->bottom, bottom + 1, __ATOMIC_RELAXED);
+    }
+
+    return file;
+}
+
+/**
+ * @brief Takes the top file off the deque of \p victim.
+ *
+ * @returns Index of file, SIZE_MAX if empty, or SIZE_MAX - 1 if another
+ * thread got there first.
+ */
+static size_t _SFGP_StealFile(_SFGP_AnalyticsWorker *const victim) {
+    int64_t top = __atomic_load_n(&victim->top, __ATOMIC_ACQUIRE);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    const int64_t bottom = __atomic_load_n(&victim->bottom, __ATOMIC_ACQUIRE);
+
+    if (top >= bottom) return SIZE_MAX;
+
+    // Deques are never pushed to once started, so reading ahead of the
+    // claim is safe.
+    const size_t file = victim->files[top];
+    if (!__atomic_compare_exchange_n(&victim->top, &top, top + 1, 0,
+                __ATOMIC_SEQ_CST, __ATOMIC_RELAXED))
+        return SIZE_MAX - 1;
+
+    return file;
+}
+
+/**
+ * @brief Next file for \p self, its own or stolen, or SIZE_MAX once every
+ * deque is empty.
+ */
+static size_t _SFGP_NextFile(_SFGP_AnalyticsWorker *const self) {
+    const size_t file = _SFGP_PopFile(self);
+    if (file != SIZE_MAX) return file;
+
+    const _SFGP_AnalyticsPool *const pool = self->pool;
+    const size_t first = (size_t) (self - pool->workers);
+
+    for (;;) {
+        int contended = 0;
+
+        for (size_t i = 1; i < pool->count; ++i) {
+            _SFGP_AnalyticsWorker *const victim =
+                &pool->workers[(first + i) % pool->count];
+
+            const size_t stolen = _SFGP_StealFile(victim);
+            if (stolen < SIZE_MAX - 1) return stolen;
+            contended |= stolen == SIZE_MAX - 1;
+        }
+
+        if (!contended) return SIZE_MAX;
+    }
+}
+
+static void *_SFGP_RunWorker(void *arg) {
+    _SFGP_AnalyticsWorker *const self = arg;
+    const _SFGP_AnalyticsPool *const pool = self->pool;
+
+    for (size_t file; (file = _SFGP_NextFile(self)) != SIZE_MAX; ) {
+        _SFGP_AnalyzePath(&self->result, pool->paths[file], self->chunk,
+                pool->config);
+    }
+
+    return NULL;
+}
+
+
+typedef struct _SFGP_SizedFile {
+    size_t index;
+    int64_t size;
+} _SFGP_SizedFile;
+
+static int _SFGP_CompareSizes(const void *a, const void *b) {
+    const int64_t x = ((const _SFGP_SizedFile *) a)->size;
+    const int64_t y = ((const _SFGP_SizedFile *) b)->size;
+    return (x < y) - (x > y);
+}
+
+/**
+ * @brief Deals out \p count files across \p workers, largest first, each
+ * deque ending up smallest at the top and largest at the bottom.
+ *
+ * @returns Deque storage of every worker, or `NULL`.
+ */
+static size_t *_SFGP_DealFiles(_SFGP_AnalyticsWorker *const workers,
+        size_t worker_count, const char *const *const paths, size_t count) {
+    _SFGP_SizedFile *const sized = malloc(sizeof (*sized) * count);
+    size_t *const files = malloc(sizeof (*files) * count);
+
+    if (sized == NULL || files == NULL) {
+        free(sized);
+        free(files);
+        return NULL;
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        struct stat st;
+        sized[i].index = i;
+        sized[i].size = (stat(paths[i], &st) == 0) ? (int64_t) st.st_size : 0;
+    }
+
+    qsort(sized, count, sizeof (*sized), _SFGP_CompareSizes);
+
+    // Worker w gets every worker_count-th file from w, filled from the
+    // bottom of its slice up.
+    size_t start = 0;
+    for (size_t w = 0; w < worker_count; ++w) {
+        const size_t share = (count / worker_count)
+            + (w < count % worker_count);
+
+        for (size_t j = 0; j < share; ++j)
+            files[start + share - 1 - j] = sized[w + (j * worker_count)].index;
+
+        workers[w].files = &files[start];
+        workers[w].top = 0;
+        workers[w].bottom = (int64_t) share;
+        start += share;
+    }
+
+    free(sized);
+    return files;
+}
+
+#endif // !_WIN32
+
+
+SFGP_Error SFGP_AnalyzeFiles(SFGP_Analytics *const analytics,
+        const char *const *const paths, size_t count,
+        const SFGP_AnalyticsConfig *const config) {
+    assert(analytics != NULL);
+    assert(paths != NULL || count == 0);
+    assert(config != NULL);
+
+    if (count == 0) return SFGP_ERROR_OK;
+
+#if _WIN32
+    uint8_t *const chunk = malloc(_SFGP_ANALYTICS_CHUNK);
+    if (chunk == NULL) return _SFGP_SetError(SFGP_ERROR_FAILED_ALLOCATION);
+
+    for (size_t i = 0; i < count; ++i)
+        _SFGP_AnalyzePath(analytics, paths[i], chunk, config);
+
+    free(chunk);
+    return SFGP_ERROR_OK;
+#else
+    size_t worker_count = config->threads;
+    if (worker_count == 0) {
+        const long online = sysconf(_SC_NPROCESSORS_ONLN);
+        worker_count = (online > 0) ? (size_t) online : 1;
+    }
+    if (worker_count > count) worker_count = count;
+
+    _SFGP_AnalyticsWorker *const workers =
+        calloc(worker_count, sizeof (*workers));
+    if (workers == NULL) return _SFGP_SetError(SFGP_ERROR_FAILED_ALLOCATION);
+
+    size_t *const files = _SFGP_DealFiles(workers, worker_count, paths, count);
+    SFGP_Error error = (files != NULL)
+        ? SFGP_ERROR_OK
+        : _SFGP_SetError(SFGP_ERROR_FAILED_ALLOCATION);
+
+    _SFGP_AnalyticsPool pool = {
+        .paths = paths,
+        .config = config,
+        .workers = workers,
+        .count = worker_count,
+    };
+
+    for (size_t i = 0; i < worker_count && error == SFGP_ERROR_OK; ++i) {
+        workers[i].pool = &pool;
+        workers[i].chunk = malloc(_SFGP_ANALYTICS_CHUNK);
+        if (workers[i].chunk == NULL)
+            error = _SFGP_SetError(SFGP_ERROR_FAILED_ALLOCATION);
+    }
+
+    if (error == SFGP_ERROR_OK) {
+        // The calling thread is worker 0. Files of any worker that fails to
+        // start are stolen by the rest.
+        for (size_t i = 1; i < worker_count; ++i) {
+            workers[i].started = pthread_create(&workers[i].thread, NULL,
+                    _SFGP_RunWorker, &workers[i]) == 0;
+        }
+
+        _SFGP_RunWorker(&workers[0]);
+
+        for (size_t i = 1; i < worker_count; ++i)
+            if (workers[i].started) pthread_join(workers[i].thread, NULL);
+
+        for (size_t i = 0; i < worker_count; ++i)
+            SFGP_MergeAnalytics(analytics, &workers[i].result);
+    }
+
+    for (size_t i = 0; i < worker_count; ++i) free(workers[i].chunk);
+    free(files);
+    free(workers);
+
+    return error;
+#endif // _WIN32
+}
@@ -0,0 +1,359 @@
+/**
+ * @file batch.c
+ * @brief Decoding of many gamepad frames at once into structure-of-arrays
+ * form.
+ *
+ * Every kernel performs the same work as @ref SFGP_UpdateGamepad(), which is
+ * nothing more than moving bits from an array of frames into one array per
+ * field, so all of them are bit-identical. The vector kernels transpose groups
+ * of frames at a time and finish off any remainder with the scalar kernel.
+ */
+
+
+#include <sftk/sfgp.h>
+#include "sfgp_internal.h"
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <assert.h>
+
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    #define _SFGP_BATCH_X86 1
+    #include <immintrin.h>
+#else
+    #define _SFGP_BATCH_X86 0
+#endif // x86
+
+
+/**
+ * @brief Signature shared by every batch kernel.
+ *
+ * @param[in]   frames: First frame to decode.
+ * @param[in]   stride: Distance in bytes between two frames.
+ * @param[in]   count: Number of frames to decode.
+ * @param[in]   previous: Button masks preceding each frame, or `NULL` if
+ *              frames are consecutive frames of one gamepad.
+ * @param[in]   carry: Button mask preceding the first frame when \p previous
+ *              is `NULL`.
+ * @param[out]  out: Arrays to decode into.
+ */
+typedef void (*_SFGP_BatchKernelFn)(const uint8_t *frames, size_t stride,
+        size_t count, const uint32_t *previous, uint32_t carry,
+        const SFGP_FrameBatch *out);
+
+
+/**
+ * @brief Returns \p batch with every array advanced by \p offset elements.
+ */
+static SFGP_FrameBatch _SFGP_OffsetBatch(const SFGP_FrameBatch *batch,
+        size_t offset) {
+    SFGP_FrameBatch result = { 0 };
+
+    for (int a = 0; a < SFGP_AXIS_ELEM; ++a) {
+        if (batch->axes[a] != NULL) result.axes[a] = &batch->axes[a][offset];
+    }
+
+    if (batch->timestamps != NULL)
+        result.timestamps = &batch->timestamps[offset];
+    if (batch->buttons != NULL)
+        result.buttons = &batch->buttons[offset];
+    if (batch->just_pressed != NULL)
+        result.just_pressed = &batch->just_pressed[offset];
+    if (batch->just_released != NULL)
+        result.just_released = &batch->just_released[offset];
+
+    return result;
+}
+
+
+// ============================================================================
+//
+//      Scalar:
+//
+// ============================================================================
+
+
+static void _SFGP_DecodeScalar(const uint8_t *frames, size_t stride,
+        size_t count, const uint32_t *previous, uint32_t carry,
+        const SFGP_FrameBatch *out) {
+    for (size_t i = 0; i < count; ++i) {
+        const uint8_t *frame = frames + (stride * i);
+
+        for (int a = 0; a < SFGP_AXIS_ELEM; ++a) {
+            if (out->axes[a] == NULL) continue;
+            memcpy(&out->axes[a][i],
+                    &frame[_SFGP_FRAME_AXES_OFFSET + (sizeof (float) * a)],
+                    sizeof (float));
+        }
+
+        if (out->timestamps != NULL) {
+            memcpy(&out->timestamps[i], &frame[_SFGP_FRAME_TIMESTAMP_OFFSET],
+                    sizeof (int64_t));
+        }
+
+        uint32_t current = 0x0;
+        memcpy(&current, &frame[_SFGP_FRAME_BUTTONS_OFFSET], sizeof (current));
+        current &= _SFGP_BUTTON_MASK_ALL;
+
+        const uint32_t last = (previous != NULL) ? previous[i] : carry;
+        if (out->just_pressed != NULL) out->just_pressed[i] = current & ~last;
+        if (out->just_released != NULL) out->just_released[i] = ~current & last;
+        if (out->buttons != NULL) out->buttons[i] = current;
+
+        carry = current;
+    }
+}
+
+
+#if _SFGP_BATCH_X86
+
+// ============================================================================
+//
+//      SSE2:
+//
+// ============================================================================
+
+
+/**
+ * @brief Stores \p value into \p dst if present, for SSE2 kernel.
+ */
+#define _SFGP_STORE_PS(dst, i, value) \
+    do { if ((dst) != NULL) _mm_storeu_ps(&(dst)[i], (value)); } while (0)
+
+#define _SFGP_STORE_SI128(dst, i, value) \
+    do { if ((dst) != NULL) \
+        _mm_storeu_si128((__m128i *) &(dst)[i], (value)); } while (0)
+
+
+__attribute__((target("sse2")))
+static void _SFGP_DecodeSSE2(const uint8_t *frames, size_t stride,
+        size_t count, const uint32_t *previous, uint32_t carry,
+        const SFGP_FrameBatch *out) {
+    const __m128i valid = _mm_set1_epi32((int32_t) _SFGP_BUTTON_MASK_ALL);
+    size_t i = 0;
+
+    for (; i + 4 <= count; i += 4) {
+        const uint8_t *frame = frames + (stride * i);
+
+        // Two overlapping 16 byte loads per frame cover every axis and the
+        // button bits without reading past the end of the frame:
+        // (lx, ly, rx, ry) and (ry, lt, rt, buttons).
+        const uint8_t *sticks = &frame[_SFGP_FRAME_AXES_OFFSET];
+        const uint8_t *tail = sticks + (sizeof (float) * SFGP_AXIS_RIGHT_Y);
+
+        __m128 s0 = _mm_loadu_ps((const float *) &sticks[0 * stride]);
+        __m128 s1 = _mm_loadu_ps((const float *) &sticks[1 * stride]);
+        __m128 s2 = _mm_loadu_ps((const float *) &sticks[2 * stride]);
+        __m128 s3 = _mm_loadu_ps((const float *) &sticks[3 * stride]);
+        _MM_TRANSPOSE4_PS(s0, s1, s2, s3);
+
+        __m128 t0 = _mm_loadu_ps((const float *) &tail[0 * stride]);
+        __m128 t1 = _mm_loadu_ps((const float *) &tail[1 * stride]);
+        __m128 t2 = _mm_loadu_ps((const float *) &tail[2 * stride]);
+        __m128 t3 = _mm_loadu_ps((const float *) &tail[3 * stride]);
+        _MM_TRANSPOSE4_PS(t0, t1, t2, t3);
+
+        _SFGP_STORE_PS(out->axes[SFGP_AXIS_LEFT_X], i, s0);
+        _SFGP_STORE_PS(out->axes[SFGP_AXIS_LEFT_Y], i, s1);
+        _SFGP_STORE_PS(out->axes[SFGP_AXIS_RIGHT_X], i, s2);
+        _SFGP_STORE_PS(out->axes[SFGP_AXIS_RIGHT_Y], i, s3);
+        _SFGP_STORE_PS(out->axes[SFGP_AXIS_LEFT_TRIGGER], i, t1);
+        _SFGP_STORE_PS(out->axes[SFGP_AXIS_RIGHT_TRIGGER], i, t2);
+
+        const __m128i current = _mm_and_si128(_mm_castps_si128(t3), valid);
+        __m128i last;
+        if (previous != NULL) {
+            last = _mm_loadu_si128((const __m128i *) &previous[i]);
+        } else {
+            last = _mm_or_si128(_mm_slli_si128(current, 4),
+                    _mm_cvtsi32_si128((int32_t) carry));
+            carry = (uint32_t) _mm_cvtsi128_si32(
+                    _mm_shuffle_epi32(current, _MM_SHUFFLE(3, 3, 3, 3)));
+        }
+
+        _SFGP_STORE_SI128(out->just_pressed, i, _mm_andnot_si128(last, current));
+        _SFGP_STORE_SI128(out->just_released, i, _mm_andnot_si128(current, last));
+        _SFGP_STORE_SI128(out->buttons, i, current);
+
+        if (out->timestamps != NULL) {
+            for (int f = 0; f < 4; ++f) {
+                memcpy(&out->timestamps[i + f],
+                        &frame[(stride * f) + _SFGP_FRAME_TIMESTAMP_OFFSET],
+                        sizeof (int64_t));
+            }
+        }
+    }
+
+    const SFGP_FrameBatch rest = _SFGP_OffsetBatch(out, i);
+    _SFGP_DecodeScalar(frames + (stride * i), stride, count - i,
+            (previous != NULL) ? &previous[i] : NULL, carry, &rest);
+}
+
+
+// ============================================================================
+//
+//      AVX2:
+//
+// ============================================================================
+
+
+#define _SFGP_STORE256_PS(dst, i, value) \
+    do { if ((dst) != NULL) _mm256_storeu_ps(&(dst)[i], (value)); } while (0)
+
+#define _SFGP_STORE256_SI256(dst, i, value) \
+    do { if ((dst) != NULL) \
+        _mm256_storeu_si256((__m256i *) &(dst)[i], (value)); } while (0)
+
+
+__attribute__((target("avx2")))
+static void _SFGP_DecodeAVX2(const uint8_t *frames, size_t stride,
+        size_t count, const uint32_t *previous, uint32_t carry,
+        const SFGP_FrameBatch *out) {
+    // Gather indexes are 32 bits wide, so each step gathers relative to its
+    // own first frame to stay within range regardless of batch size.
+    if (stride > INT32_MAX / 8) {
+        _SFGP_DecodeScalar(frames, stride, count, previous, carry, out);
+        return;
+    }
+
+    const int32_t s = (int32_t) stride;
+    const __m256i index = _mm256_setr_epi32(0, s, 2 * s, 3 * s,
+            4 * s, 5 * s, 6 * s, 7 * s);
+    const __m256i valid = _mm256_set1_epi32((int32_t) _SFGP_BUTTON_MASK_ALL);
+    const __m256i rotate = _mm256_setr_epi32(7, 0, 1, 2, 3, 4, 5, 6);
+    size_t i = 0;
+
+    for (; i + 8 <= count; i += 8) {
+        const uint8_t *frame = frames + (stride * i);
+
+        for (int a = 0; a < SFGP_AXIS_ELEM; ++a) {
+            if (out->axes[a] == NULL) continue;
+
+            const float *base = (const float *)
+                &frame[_SFGP_FRAME_AXES_OFFSET + (sizeof (float) * a)];
+            _SFGP_STORE256_PS(out->axes[a], i,
+                    _mm256_i32gather_ps(base, index, 1));
+        }
+
+        const __m256i current = _mm256_and_si256(valid,
+                _mm256_i32gather_epi32(
+                    (const int *) &frame[_SFGP_FRAME_BUTTONS_OFFSET], index, 1));
+        __m256i last;
+        if (previous != NULL) {
+            last = _mm256_loadu_si256((const __m256i *) &previous[i]);
+        } else {
+            // Rotate every mask one lane up and slot carry into lane 0.
+            last = _mm256_blend_epi32(
+                    _mm256_permutevar8x32_epi32(current, rotate),
+                    _mm256_set1_epi32((int32_t) carry), 0x01);
+            carry = (uint32_t) _mm256_extract_epi32(current, 7);
+        }
+
+        _SFGP_STORE256_SI256(out->just_pressed, i,
+                _mm256_andnot_si256(last, current));
+        _SFGP_STORE256_SI256(out->just_released, i,
+                _mm256_andnot_si256(current, last));
+        _SFGP_STORE256_SI256(out->buttons, i, current);
+
+        if (out->timestamps != NULL) {
+            for (int f = 0; f < 8; ++f) {
+                memcpy(&out->timestamps[i + f],
+                        &frame[(stride * f) + _SFGP_FRAME_TIMESTAMP_OFFSET],
+                        sizeof (int64_t));
+            }
+        }
+    }
+
+    // Remainder of less than 8 frames.
+    const SFGP_FrameBatch rest = _SFGP_OffsetBatch(out, i);
+    _SFGP_DecodeSSE2(frames + (stride * i), stride, count - i,
+            (previous != NULL) ? &previous[i] : NULL, carry, &rest);
+}
+
+#endif // _SFGP_BATCH_X86
+
+
+// ============================================================================
+//
+//      Dispatch:
+//
+// ============================================================================
+
+
+/**
+ * @brief Kernel used by batch decoder, selected on first use.
+ *
+ * Accessed atomically, as first uses may race. Every racing selection stores
+ * the same kernel, so relaxed ordering suffices.
+ */
+static _SFGP_BatchKernelFn _SFGP_batch_kernel = NULL;
+
+
+SFGP_BatchKernel SFGP_SetBatchKernel(SFGP_BatchKernel kernel) {
+#if _SFGP_BATCH_X86
+    __builtin_cpu_init();
+
+    if (kernel == SFGP_BATCH_KERNEL_AUTO) kernel = SFGP_BATCH_KERNEL_AVX2;
+    if (kernel == SFGP_BATCH_KERNEL_AVX2 && !__builtin_cpu_supports("avx2"))
+        kernel = SFGP_BATCH_KERNEL_SSE2;
+    if (kernel == SFGP_BATCH_KERNEL_SSE2 && !__builtin_cpu_supports("sse2"))
+        kernel = SFGP_BATCH_KERNEL_SCALAR;
+#else
+    kernel = SFGP_BATCH_KERNEL_SCALAR;
+#endif // _SFGP_BATCH_X86
+
+    _SFGP_BatchKernelFn fn;
+    switch (kernel) {
+#if _SFGP_BATCH_X86
+    case SFGP_BATCH_KERNEL_AVX2:
+        fn = _SFGP_DecodeAVX2;
+        break;
+    case SFGP_BATCH_KERNEL_SSE2:
+        fn = _SFGP_DecodeSSE2;
+        break;
+#endif // _SFGP_BATCH_X86
+    default:
+        kernel = SFGP_BATCH_KERNEL_SCALAR;
+        fn = _SFGP_DecodeScalar;
+        break;
+    }
+
+    __atomic_store_n(&_SFGP_batch_kernel, fn, __ATOMIC_RELAXED);
+    return kernel;
+}
+
+/**
+ * @brief Returns kernel used by batch decoder, selecting it on first use.
+ */
+static inline _SFGP_BatchKernelFn _SFGP_GetBatchKernel(void) {
+    _SFGP_BatchKernelFn fn = __atomic_load_n(&_SFGP_batch_kernel,
+            __ATOMIC_RELAXED);
+
+    if (fn == NULL) {
+        SFGP_SetBatchKernel(SFGP_BATCH_KERNEL_AUTO);
+        fn = __atomic_load_n(&_SFGP_batch_kernel, __ATOMIC_RELAXED);
+    }
+
+    return fn;
+}
+
+
+void SFGP_DecodeFrames(const uint8_t *const frames, size_t stride,
+        size_t count, uint32_t previous, const SFGP_FrameBatch *const out) {
+    assert(frames != NULL || count == 0);
+    assert(stride >= SFGP_FRAME_SIZE);
+    assert(out != NULL);
+
+    _SFGP_GetBatchKernel()(frames, stride, count, NULL, previous, out);
+}
+
+void SFGP_DecodeGamepadFrames(const uint8_t *const frames, size_t stride,
+        size_t count, const SFGP_FrameBatch *const out) {
+    assert(frames != NULL || count == 0);
+    assert(stride >= SFGP_FRAME_SIZE);
+    assert(out != NULL && out->buttons != NULL);
+
+    _SFGP_GetBatchKernel()(frames, stride, count, out->buttons, 0x0, out);
+}
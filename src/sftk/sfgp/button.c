@@ -11,39 +11,33 @@
 #include <assert.h>
 
 
-/**
- * @brief Data required to perform checks on an individual button
- */
-struct SFGP_Button {
-    uint8_t last            : 1; /**< Last known value of button.   */
-    uint8_t current         : 1; /**< Latest known value of button. */
-};
+int8_t SFGP_IsButtonPressed(const SFGP_Button *const self) {
+    return _SFGP_InlineIsButtonPressed(self);
+}
 
+int8_t SFGP_IsButtonJustPressed(const SFGP_Button *const self) {
+    return _SFGP_InlineIsButtonJustPressed(self);
+}
 
-void _SFGP_SetButton(SFGP_Button *const self, int8_t value) {
-    assert(value == 1 || value == 0);
+int8_t SFGP_IsButtonReleased(const SFGP_Button *const self) {
+    return _SFGP_InlineIsButtonReleased(self);
+}
 
-    self->last = self->current;
-    self->current = value;
+int8_t SFGP_IsButtonJustReleased(const SFGP_Button * const self) {
+    return _SFGP_InlineIsButtonJustReleased(self);
 }
 
 
-int8_t SFGP_IsButtonPressed(const SFGP_Button *const self) {
-    assert(self != NULL);
-    return self->current;
-}
+// Whole pad
 
-int8_t SFGP_IsButtonJustPressed(const SFGP_Button *const self) {
-    assert(self != NULL);
-    return self->current && !self->last;
+uint32_t SFGP_GetButtonsPressed(const SFGP_Gamepad *const pad) {
+    return _SFGP_InlineGetButtonsPressed(pad);
 }
 
-int8_t SFGP_IsButtonReleased(const SFGP_Button *const self) {
-    assert(self != NULL);
-    return !self->current;
+uint32_t SFGP_GetButtonsJustPressed(const SFGP_Gamepad *const pad) {
+    return _SFGP_InlineGetButtonsJustPressed(pad);
 }
 
-int8_t SFGP_IsButtonJustReleased(const SFGP_Button *const self) {
-    assert(self != NULL);
-    return !self->current && self->last;
-}
\ No newline at end of file
+uint32_t SFGP_GetButtonsJustReleased(const SFGP_Gamepad *const pad) {
+    return _SFGP_InlineGetButtonsJustReleased(pad);
+}
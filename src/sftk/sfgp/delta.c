@@ -0,0 +1,485 @@
+/**
+ * @file delta.c
+ * @brief Bit packed delta encoding of gamepad frames.
+ *
+ * Stream layout, all keyframe integers in host byte order:
+ *
+ *     segment     _SFGP_DeltaKey, then .frames - 1 records, padded to a byte
+ *     record      LSB first bit fields:
+ *                 varint  zig-zag change in timestamp delta
+ *                 1       buttons changed, followed by SFGP_BUTTON_ELEM bits
+ *                         of buttons flipped
+ *                 6       axes changed, followed by a zig-zag varint of the
+ *                         change of each, in SFGP_AxisIndex order
+ *                 1       touchpad changed, followed by 32 bits per
+ *                         coordinate
+ *
+ * Varints are groups of 4 value bits and 1 continuation bit, least
+ * significant group first.
+ */
+
+
+#include <sftk/sfgp.h>
+#include "sfgp_internal.h"
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <assert.h>
+
+
+#define _SFGP_DELTA_MAGIC       "SFGK"
+#define _SFGP_VARINT_BITS       4
+
+
+/**
+ * @brief Byte aligned frame opening every segment.
+ */
+typedef struct _SFGP_DeltaKey {
+    char magic[4];              /**< _SFGP_DELTA_MAGIC, not null terminated. */
+    uint32_t bytes;             /**< Segment size, this keyframe included. */
+    uint32_t frames;            /**< Frames in segment, this one included. */
+    int32_t id;
+    uint64_t first;             /**< Number of this frame. */
+    int64_t timestamp;
+    uint32_t buttons;
+    int16_t axes[SFGP_AXIS_ELEM];
+    float touchpad[SFGP_FINGER_ELEM][2];
+    uint8_t user;
+    uint8_t type;
+    uint8_t version;
+    uint8_t reserved[5];
+} _SFGP_DeltaKey;
+
+_Static_assert(sizeof (_SFGP_DeltaKey) == 72,
+        "_SFGP_DeltaKey must not be padded");
+_Static_assert(sizeof (_SFGP_DeltaKey) + 1 + 48 <= SFGP_DELTA_FRAME_MAX,
+        "SFGP_DELTA_FRAME_MAX does not fit the longest frame");
+
+
+static inline uint64_t _SFGP_ZigZag(int64_t value) {
+    return ((uint64_t) value << 1) ^ (uint64_t) (value >> 63);
+}
+
+static inline int64_t _SFGP_UnZigZag(uint64_t value) {
+    return (int64_t) (value >> 1) ^ -(int64_t) (value & 1);
+}
+
+
+// ============================================================================
+//
+//      Writer:
+//
+// ============================================================================
+
+
+/**
+ * @brief Appends the low \p count bits of \p value, at most 32.
+ */
+static void _SFGP_PutBits(SFGP_DeltaWriter *const self, uint64_t value,
+        uint32_t count) {
+    self->bits |= (value & ((UINT64_C(1) << count) - 1)) << self->bit_count;
+    self->bit_count += count;
+
+    for (; self->bit_count >= 8; self->bit_count -= 8) {
+        self->buffer[self->length++] = (uint8_t) self->bits;
+        self->bits >>= 8;
+    }
+}
+
+static void _SFGP_PutVarint(SFGP_DeltaWriter *const self, uint64_t value) {
+    const uint64_t mask = (1u << _SFGP_VARINT_BITS) - 1;
+
+    for (;;) {
+        const uint64_t group = value & mask;
+        value >>= _SFGP_VARINT_BITS;
+
+        const uint64_t more = value != 0;
+        _SFGP_PutBits(self, group | (more << _SFGP_VARINT_BITS),
+                _SFGP_VARINT_BITS + 1);
+        if (!more) break;
+    }
+}
+
+/**
+ * @brief Pads the open segment to a byte and fills in its keyframe.
+ */
+static void _SFGP_CloseSegment(SFGP_DeltaWriter *const self) {
+    if (self->segment == SIZE_MAX) return;
+
+    if (self->bit_count > 0) _SFGP_PutBits(self, 0, 8 - self->bit_count);
+
+    uint8_t *const key = &self->buffer[self->segment];
+    const uint32_t bytes = (uint32_t) (self->length - self->segment);
+    memcpy(key + offsetof(_SFGP_DeltaKey, bytes), &bytes, sizeof (bytes));
+    memcpy(key + offsetof(_SFGP_DeltaKey, frames), &self->frames,
+            sizeof (self->frames));
+
+    self->segment = SIZE_MAX;
+    self->frames = 0;
+}
+
+static void _SFGP_OpenSegment(SFGP_DeltaWriter *const self,
+        const SFGP_DeltaFrame *const frame) {
+    _SFGP_DeltaKey key;
+    memset(&key, 0, sizeof (key));
+    memcpy(key.magic, _SFGP_DELTA_MAGIC, sizeof (key.magic));
+
+    key.id = frame->id;
+    key.first = self->frame;
+    key.timestamp = frame->timestamp;
+    key.buttons = frame->buttons;
+    memcpy(key.axes, frame->axes, sizeof (key.axes));
+    memcpy(key.touchpad, frame->touchpad, sizeof (key.touchpad));
+    key.user = frame->user;
+    key.type = frame->type;
+    key.version = frame->version;
+
+    self->segment = self->length;
+    memcpy(&self->buffer[self->length], &key, sizeof (key));
+    self->length += sizeof (key);
+}
+
+static void _SFGP_PutRecord(SFGP_DeltaWriter *const self,
+        const SFGP_DeltaFrame *const frame) {
+    const SFGP_DeltaFrame *const last = &self->last;
+
+    _SFGP_PutVarint(self, _SFGP_ZigZag((int64_t) ((uint64_t) frame->delta
+                    - (uint64_t) last->delta)));
+
+    const uint32_t flipped = frame->buttons ^ last->buttons;
+    _SFGP_PutBits(self, flipped != 0, 1);
+    if (flipped != 0) _SFGP_PutBits(self, flipped, SFGP_BUTTON_ELEM);
+
+    uint32_t changed = 0x0;
+    for (int i = 0; i < SFGP_AXIS_ELEM; ++i)
+        changed |= (uint32_t) (frame->axes[i] != last->axes[i]) << i;
+
+    _SFGP_PutBits(self, changed, SFGP_AXIS_ELEM);
+    for (int i = 0; i < SFGP_AXIS_ELEM; ++i) {
+        if (changed & (1u << i)) {
+            _SFGP_PutVarint(self, _SFGP_ZigZag(
+                        (int64_t) frame->axes[i] - last->axes[i]));
+        }
+    }
+
+    const int touched = memcmp(frame->touchpad, last->touchpad,
+            sizeof (frame->touchpad)) != 0;
+    _SFGP_PutBits(self, touched, 1);
+    if (touched) {
+        for (int i = 0; i < SFGP_FINGER_ELEM; ++i) {
+            for (int j = 0; j < 2; ++j) {
+                uint32_t bits;
+                memcpy(&bits, &frame->touchpad[i][j], sizeof (bits));
+                _SFGP_PutBits(self, bits, 32);
+            }
+        }
+    }
+}
+
+
+void SFGP_InitDeltaWriter(SFGP_DeltaWriter *const writer,
+        uint8_t *const buffer, size_t capacity, uint32_t interval) {
+    assert(writer != NULL);
+    assert(buffer != NULL || capacity == 0);
+    assert(interval > 0);
+
+    memset(writer, 0, sizeof (*writer));
+    writer->buffer = buffer;
+    writer->capacity = capacity;
+    writer->segment = SIZE_MAX;
+    writer->interval = interval;
+}
+
+SFGP_Error SFGP_WriteDelta(SFGP_DeltaWriter *const writer,
+        const SFGP_Gamepad *const pad) {
+    assert(writer != NULL);
+    assert(pad != NULL && pad->storage != NULL);
+
+    const SFGP_GamepadState *const state = _SFGP_GetState(pad);
+    if (state->version == 0) return SFGP_ERROR_OK;
+    if (writer->frame > 0 && state->generation == writer->generation)
+        return SFGP_ERROR_OK;
+
+    if (writer->capacity - writer->length < SFGP_DELTA_FRAME_MAX)
+        return _SFGP_SetError(SFGP_ERROR_BUFFER_FULL);
+
+    SFGP_DeltaFrame frame;
+    memset(&frame, 0, sizeof (frame));
+
+    frame.timestamp = state->timestamp;
+    frame.id = state->id;
+    frame.buttons = state->buttons_raw;
+    for (int i = 0; i < SFGP_AXIS_ELEM; ++i)
+        frame.axes[i] = _SFGP_QuantizeAxis(state->axes[i].raw);
+    memcpy(frame.touchpad, state->touchpad, sizeof (frame.touchpad));
+    frame.user = state->user;
+    frame.type = state->type;
+    frame.version = state->version;
+
+    const SFGP_DeltaFrame *const last = &writer->last;
+    const int same_source = (frame.id == last->id)
+        & (frame.user == last->user)
+        & (frame.type == last->type)
+        & (frame.version == last->version);
+
+    if (writer->frames >= writer->interval || !same_source)
+        _SFGP_CloseSegment(writer);
+
+    if (writer->segment == SIZE_MAX) {
+        _SFGP_OpenSegment(writer, &frame);
+    } else {
+        frame.delta = (int64_t) ((uint64_t) frame.timestamp
+                - (uint64_t) last->timestamp);
+        _SFGP_PutRecord(writer, &frame);
+    }
+
+    writer->last = frame;
+    writer->generation = state->generation;
+    ++writer->frames;
+    ++writer->frame;
+
+    return SFGP_ERROR_OK;
+}
+
+size_t SFGP_FlushDeltaWriter(SFGP_DeltaWriter *const writer) {
+    assert(writer != NULL);
+
+    _SFGP_CloseSegment(writer);
+    return writer->length;
+}
+
+void SFGP_ClearDeltaWriter(SFGP_DeltaWriter *const writer) {
+    assert(writer != NULL);
+
+    _SFGP_CloseSegment(writer);
+    writer->length = 0;
+}
+
+
+// ============================================================================
+//
+//      Reader:
+//
+// ============================================================================
+
+
+/**
+ * @brief Takes the next \p count bits, at most 32, from the current segment.
+ *
+ * @returns Whether the segment held that many bits.
+ */
+static int _SFGP_GetBits(SFGP_DeltaReader *const self, uint32_t count,
+        uint64_t *const value) {
+    while (self->bit_count < count) {
+        if (self->offset >= self->end) return 0;
+
+        self->bits |= (uint64_t) self->data[self->offset++] << self->bit_count;
+        self->bit_count += 8;
+    }
+
+    *value = self->bits & ((UINT64_C(1) << count) - 1);
+    self->bits >>= count;
+    self->bit_count -= count;
+    return 1;
+}
+
+static int _SFGP_GetVarint(SFGP_DeltaReader *const self,
+        uint64_t *const value) {
+    *value = 0;
+
+    for (uint32_t shift = 0; shift < 64; shift += _SFGP_VARINT_BITS) {
+        uint64_t group;
+        if (!_SFGP_GetBits(self, _SFGP_VARINT_BITS + 1, &group)) return 0;
+
+        *value |= (group & ((1u << _SFGP_VARINT_BITS) - 1)) << shift;
+        if (!(group >> _SFGP_VARINT_BITS)) return 1;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Reads keyframe at \p offset, checking it lies within the stream.
+ */
+static int _SFGP_GetKey(const SFGP_DeltaReader *const self, size_t offset,
+        _SFGP_DeltaKey *const key) {
+    if (self->size - offset < sizeof (*key)) return 0;
+
+    memcpy(key, &self->data[offset], sizeof (*key));
+    return (memcmp(key->magic, _SFGP_DELTA_MAGIC, sizeof (key->magic)) == 0)
+        & (key->bytes >= sizeof (*key))
+        & (key->bytes <= self->size - offset)
+        & (key->frames > 0)
+        & ((key->buttons & ~_SFGP_BUTTON_MASK_ALL) == 0);
+}
+
+/**
+ * @brief Enters segment of keyframe \p key found at \p offset.
+ */
+static void _SFGP_EnterSegment(SFGP_DeltaReader *const self, size_t offset,
+        const _SFGP_DeltaKey *const key) {
+    SFGP_DeltaFrame *const frame = &self->last;
+    memset(frame, 0, sizeof (*frame));
+
+    frame->timestamp = key->timestamp;
+    frame->id = key->id;
+    frame->buttons = key->buttons;
+    memcpy(frame->axes, key->axes, sizeof (frame->axes));
+    memcpy(frame->touchpad, key->touchpad, sizeof (frame->touchpad));
+    frame->user = key->user;
+    frame->type = key->type;
+    frame->version = key->version;
+
+    self->end = offset + key->bytes;
+    self->offset = offset + sizeof (*key);
+    self->bits = 0;
+    self->bit_count = 0;
+    self->remaining = key->frames - 1;
+    self->frame = key->first;
+}
+
+static int _SFGP_GetRecord(SFGP_DeltaReader *const self) {
+    SFGP_DeltaFrame *const frame = &self->last;
+    uint64_t value;
+
+    if (!_SFGP_GetVarint(self, &value)) return 0;
+    frame->delta = (int64_t) ((uint64_t) frame->delta
+            + (uint64_t) _SFGP_UnZigZag(value));
+    frame->timestamp = (int64_t) ((uint64_t) frame->timestamp
+            + (uint64_t) frame->delta);
+
+    if (!_SFGP_GetBits(self, 1, &value)) return 0;
+    if (value) {
+        if (!_SFGP_GetBits(self, SFGP_BUTTON_ELEM, &value)) return 0;
+        frame->buttons ^= (uint32_t) value;
+    }
+
+    uint64_t changed;
+    if (!_SFGP_GetBits(self, SFGP_AXIS_ELEM, &changed)) return 0;
+    for (int i = 0; i < SFGP_AXIS_ELEM; ++i) {
+        if (!(changed & (1u << i))) continue;
+        if (!_SFGP_GetVarint(self, &value)) return 0;
+
+        const int64_t axis = frame->axes[i] + _SFGP_UnZigZag(value);
+        if (axis > SFGP_PACKED_AXIS_MAX || axis < -SFGP_PACKED_AXIS_MAX)
+            return 0;
+        frame->axes[i] = (int16_t) axis;
+    }
+
+    if (!_SFGP_GetBits(self, 1, &value)) return 0;
+    if (value) {
+        for (int i = 0; i < SFGP_FINGER_ELEM; ++i) {
+            for (int j = 0; j < 2; ++j) {
+                if (!_SFGP_GetBits(self, 32, &value)) return 0;
+
+                const uint32_t bits = (uint32_t) value;
+                memcpy(&frame->touchpad[i][j], &bits, sizeof (bits));
+            }
+        }
+    }
+
+    return 1;
+}
+
+/**
+ * @brief Moves \p self to its next frame, entering the next segment once the
+ * current one runs out.
+ *
+ * @returns `SFGP_ERROR_OK` with \p read set if \p self moved, or
+ * `SFGP_ERROR_INVALID_FILE`.
+ */
+static SFGP_Error _SFGP_NextDelta(SFGP_DeltaReader *const self,
+        int8_t *const read) {
+    *read = 0;
+
+    if (self->remaining == 0) {
+        if (self->end >= self->size) return SFGP_ERROR_OK;
+
+        _SFGP_DeltaKey key;
+        if (!_SFGP_GetKey(self, self->end, &key))
+            return _SFGP_SetError(SFGP_ERROR_INVALID_FILE);
+        _SFGP_EnterSegment(self, self->end, &key);
+    } else {
+        if (!_SFGP_GetRecord(self))
+            return _SFGP_SetError(SFGP_ERROR_INVALID_FILE);
+        --self->remaining;
+    }
+
+    ++self->frame;
+    *read = 1;
+    return SFGP_ERROR_OK;
+}
+
+
+void SFGP_InitDeltaReader(SFGP_DeltaReader *const reader,
+        const uint8_t *const data, size_t size) {
+    assert(reader != NULL);
+    assert(data != NULL || size == 0);
+
+    memset(reader, 0, sizeof (*reader));
+    reader->data = data;
+    reader->size = size;
+}
+
+SFGP_Error SFGP_ReadDelta(SFGP_DeltaReader *const reader,
+        SFGP_Gamepad *const pad, int8_t *const read) {
+    assert(reader != NULL);
+    assert(pad != NULL && pad->storage != NULL);
+    assert(read != NULL);
+
+    const SFGP_Error error = _SFGP_NextDelta(reader, read);
+    if (error != SFGP_ERROR_OK || !*read) return error;
+
+    const SFGP_DeltaFrame *const last = &reader->last;
+    _SFGP_Frame frame;
+    memset(&frame, 0, sizeof (frame));
+
+    frame.timestamp = last->timestamp;
+    frame.id = last->id;
+    for (int i = 0; i < SFGP_AXIS_ELEM; ++i)
+        frame.axes[i] = _SFGP_DequantizeAxis(last->axes[i]);
+    frame.buttons = last->buttons;
+    memcpy(frame.touchpad, last->touchpad, sizeof (frame.touchpad));
+    frame.user = last->user;
+    frame.type = last->type;
+    frame.version = last->version;
+
+    if (!_SFGP_IsFrameValid(&frame))
+        return _SFGP_SetError(SFGP_ERROR_INVALID_FILE);
+
+    _SFGP_ApplyFrame(pad, &frame);
+    return SFGP_ERROR_OK;
+}
+
+SFGP_Error SFGP_SeekDelta(SFGP_DeltaReader *const reader, uint64_t frame) {
+    assert(reader != NULL);
+
+    // Hop keyframes from the start, never decoding a record of a segment
+    // before the one holding frame.
+    _SFGP_DeltaKey key;
+    size_t offset = 0;
+
+    for (;; offset += key.bytes) {
+        if (offset >= reader->size)
+            return _SFGP_SetError(SFGP_ERROR_UNSUPPORTED);
+        if (!_SFGP_GetKey(reader, offset, &key))
+            return _SFGP_SetError(SFGP_ERROR_INVALID_FILE);
+
+        if (frame < key.first) return _SFGP_SetError(SFGP_ERROR_UNSUPPORTED);
+        if (frame - key.first < key.frames) break;
+    }
+
+    // Land right before the keyframe, then decode up to frame.
+    reader->end = offset;
+    reader->remaining = 0;
+    reader->frame = key.first;
+
+    for (uint64_t skip = frame - key.first; skip > 0; --skip) {
+        int8_t read;
+        const SFGP_Error error = _SFGP_NextDelta(reader, &read);
+        if (error != SFGP_ERROR_OK) return error;
+    }
+
+    return SFGP_ERROR_OK;
+}
@@ -7,10 +7,18 @@
 #include "sfgp_internal.h"
 
 
+#if defined(_MSC_VER)
+    #define _SFGP_THREAD_LOCAL __declspec(thread)
+#else
+    #define _SFGP_THREAD_LOCAL _Thread_local
+#endif // _MSC_VER
+
+
 /**
- * @brief For storing SFGP's current error state.
+ * @brief For storing SFGP's current error state, one per thread so that
+ * threads updating different gamepads cannot clobber each others errors.
  */
-static SFGP_Error _SFGP_error = SFGP_ERROR_OK;
+static _SFGP_THREAD_LOCAL SFGP_Error _SFGP_error = SFGP_ERROR_OK;
 
 
 
@@ -0,0 +1,137 @@
+/**
+ * @file event.c
+ * @brief Compact list of everything that changed within a single update.
+ */
+
+
+#include <sftk/sfgp.h>
+#include "sfgp_internal.h"
+
+#include <stdint.h>
+#include <stddef.h>
+#include <assert.h>
+
+
+/**
+ * @brief Returns edge reached by an axis this update, or -1 if none.
+ *
+ * Mirrors the `Just` queries in trigger.c and joystick.c.
+ */
+static int _SFGP_GetAxisEdge(const SFGP_Trigger *const axis,
+        SFGP_AxisIndex index) {
+    if (_SFGP_IsJustLatched(axis, _SFGP_AXIS_AT_MAX))
+        return SFGP_EVENT_AXIS_AT_MAX;
+
+    if (index >= SFGP_AXIS_LEFT_TRIGGER) {
+        if (axis->current <= 0.0f && axis->last > 0.0f)
+            return SFGP_EVENT_AXIS_AT_ZERO;
+        return -1;
+    }
+
+    if (_SFGP_IsJustLatched(axis, _SFGP_AXIS_AT_MIN))
+        return SFGP_EVENT_AXIS_AT_MIN;
+    if (axis->current == 0.0f && axis->last != 0.0f)
+        return SFGP_EVENT_AXIS_AT_ZERO;
+
+    return -1;
+}
+
+
+/**
+ * @brief Appends \p event to \p self, or flags it as truncated if full.
+ */
+static void _SFGP_PushEvent(SFGP_EventBuffer *const self,
+        SFGP_Event event) {
+    if (self->count < self->capacity) {
+        self->events[self->count++] = event;
+    } else {
+        self->truncated = 1;
+    }
+}
+
+void _SFGP_EmitEvents(SFGP_EventBuffer *const self,
+        const SFGP_GamepadState *const state) {
+    const uint32_t changed = state->buttons_current ^ state->buttons_last;
+    if (changed != 0) {
+        for (int i = 0; i < SFGP_BUTTON_ELEM; ++i) {
+            const uint32_t mask = SFGP_BUTTON_MASK(i);
+            if (!(changed & mask)) continue;
+
+            const int8_t pressed = (state->buttons_current & mask) != 0;
+            _SFGP_PushEvent(self, (SFGP_Event) {
+                .timestamp = state->timestamp,
+                .value = pressed ? 1.0f : 0.0f,
+                .control = (uint8_t) i,
+                .edge = pressed
+                    ? SFGP_EVENT_BUTTON_PRESSED
+                    : SFGP_EVENT_BUTTON_RELEASED,
+            });
+        }
+    }
+
+    for (int i = 0; i < SFGP_AXIS_ELEM; ++i) {
+        const int edge = _SFGP_GetAxisEdge(&state->axes[i], i);
+        if (edge < 0) continue;
+
+        _SFGP_PushEvent(self, (SFGP_Event) {
+            .timestamp = state->timestamp,
+            .value = state->axes[i].current,
+            .control = (uint8_t) i,
+            .edge = (uint8_t) edge,
+        });
+    }
+}
+
+
+void SFGP_InitEventBuffer(SFGP_EventBuffer *const buffer,
+        SFGP_Event *const events, size_t capacity) {
+    assert(buffer != NULL);
+    assert(events != NULL || capacity == 0);
+
+    buffer->events = events;
+    buffer->capacity = capacity;
+    SFGP_ClearEventBuffer(buffer);
+}
+
+void SFGP_ClearEventBuffer(SFGP_EventBuffer *const buffer) {
+    assert(buffer != NULL);
+
+    buffer->count = 0;
+    buffer->truncated = 0;
+}
+
+void SFGP_AttachEventBuffer(SFGP_Gamepad *const pad,
+        SFGP_EventBuffer *const buffer) {
+    assert(pad != NULL);
+    pad->events = buffer;
+}
+
+
+SFGP_Error SFGP_UpdateGamepadEvents(SFGP_Gamepad *const pad,
+        const uint8_t *const byte_array, SFGP_Event *const events,
+        size_t capacity, size_t *const count) {
+    assert(pad != NULL);
+    assert(events != NULL || capacity == 0);
+    assert(count != NULL);
+
+    *count = 0;
+
+    const SFGP_GamepadState *state = _SFGP_GetState(pad);
+    const uint32_t generation = state->generation;
+
+    const SFGP_Error error = SFGP_UpdateGamepad(pad, byte_array);
+    if (error != SFGP_ERROR_OK) return error;
+
+    // A repeated frame changes nothing, its edges were reported already.
+    if (state->generation == generation) return SFGP_ERROR_OK;
+
+    SFGP_EventBuffer buffer;
+    SFGP_InitEventBuffer(&buffer, events, capacity);
+    _SFGP_EmitEvents(&buffer, state);
+
+    *count = buffer.count;
+    if (buffer.truncated)
+        return _SFGP_SetError(SFGP_ERROR_EVENTS_TRUNCATED);
+
+    return SFGP_ERROR_OK;
+}
@@ -0,0 +1,147 @@
+/**
+ * @file filter.c
+ * @brief Low-pass, hysteresis, and debounce filtering of every control.
+ *
+ * Every filter parameter and state variable is an array over all axes or all
+ * buttons, and each frame goes through them in fixed length loops without
+ * data dependent branches so the compiler can vectorize them. Hysteresis is
+ * applied by @ref _SFGP_LatchTrigger() as the frame is applied, with the
+ * thresholds kept here.
+ */
+
+
+#include <sftk/sfgp.h>
+#include "sfgp_internal.h"
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <math.h>
+#include <assert.h>
+
+
+void SFGP_InitFilterBank(SFGP_FilterBank *const bank) {
+    assert(bank != NULL);
+
+    memset(bank, 0, sizeof (*bank));
+    for (int i = 0; i < SFGP_AXIS_ELEM; ++i) {
+        bank->b0[i] = 1.0f;
+        bank->press[i] = 1.0f;
+        bank->release[i] = 1.0f;
+    }
+}
+
+void SFGP_SetAxisSmoothing(SFGP_FilterBank *const bank, SFGP_AxisIndex axis,
+        float alpha) {
+    assert(alpha > 0.0f && alpha <= 1.0f);
+
+    const float b[3] = { alpha, 0.0f, 0.0f };
+    const float a[2] = { alpha - 1.0f, 0.0f };
+    SFGP_SetAxisBiquad(bank, axis, b, a);
+}
+
+void SFGP_SetAxisBiquad(SFGP_FilterBank *const bank, SFGP_AxisIndex axis,
+        const float b[3], const float a[2]) {
+    assert(bank != NULL);
+    assert(axis < SFGP_AXIS_ELEM);
+    assert(b != NULL && a != NULL);
+
+    bank->b0[axis] = b[0];
+    bank->b1[axis] = b[1];
+    bank->b2[axis] = b[2];
+    bank->a1[axis] = a[0];
+    bank->a2[axis] = a[1];
+
+    if (bank->press[axis] == 1.0f) {
+        bank->press[axis] = SFGP_FILTER_PRESS;
+        bank->release[axis] = fminf(bank->release[axis], SFGP_FILTER_PRESS);
+    }
+
+    // Restart from the latest output rather than from silence.
+    const float y = bank->value[axis];
+    bank->z2[axis] = (b[2] - a[1]) * y;
+    bank->z1[axis] = ((b[1] - a[0]) * y) + bank->z2[axis];
+}
+
+void SFGP_SetAxisHysteresis(SFGP_FilterBank *const bank, SFGP_AxisIndex axis,
+        float press, float release) {
+    assert(bank != NULL);
+    assert(axis < SFGP_AXIS_ELEM);
+    assert(press > 0.0f && press <= 1.0f);
+    assert(release > 0.0f && release <= press);
+
+    bank->press[axis] = press;
+    bank->release[axis] = release;
+}
+
+void SFGP_SetButtonDebounce(SFGP_FilterBank *const bank,
+        SFGP_ButtonIndex button, uint8_t frames) {
+    assert(bank != NULL);
+    assert(button < SFGP_BUTTON_ELEM);
+
+    bank->debounce[button] = frames;
+    bank->pending[button] = 0;
+}
+
+void SFGP_AttachFilterBank(SFGP_Gamepad *const pad,
+        SFGP_FilterBank *const bank) {
+    assert(pad != NULL);
+    pad->filters = bank;
+}
+
+
+/**
+ * @brief Takes the first frame through \p self as its steady state.
+ */
+static void _SFGP_PrimeFilterBank(SFGP_FilterBank *const self,
+        const float axes[SFGP_AXIS_ELEM], uint32_t buttons) {
+    for (int i = 0; i < SFGP_AXIS_ELEM; ++i) {
+        const float x = axes[i];
+        self->z2[i] = (self->b2[i] - self->a2[i]) * x;
+        self->z1[i] = ((self->b1[i] - self->a1[i]) * x) + self->z2[i];
+        self->value[i] = x;
+    }
+
+    self->buttons = buttons;
+    self->primed = 1;
+}
+
+void _SFGP_FilterFrame(SFGP_FilterBank *const self, int64_t timestamp,
+        float axes[SFGP_AXIS_ELEM], uint32_t *const buttons) {
+    if (!self->primed) {
+        _SFGP_PrimeFilterBank(self, axes, *buttons);
+    } else if (timestamp != self->timestamp) {
+        // Transposed direct form II biquad, one lane per axis.
+        for (int i = 0; i < SFGP_AXIS_ELEM; ++i) {
+            const float x = axes[i];
+            const float y = (self->b0[i] * x) + self->z1[i];
+
+            self->z1[i] = (self->b1[i] * x) - (self->a1[i] * y) + self->z2[i];
+            self->z2[i] = (self->b2[i] * x) - (self->a2[i] * y);
+
+            const float min = (i < SFGP_AXIS_LEFT_TRIGGER) ? -1.0f : 0.0f;
+            self->value[i] = fminf(fmaxf(y, min), 1.0f);
+        }
+
+        // A button flips once its raw state has differed from the debounced
+        // one for .debounce consecutive frames.
+        uint8_t flip[SFGP_BUTTON_ELEM];
+        for (int i = 0; i < SFGP_BUTTON_ELEM; ++i) {
+            const uint32_t shift = SFGP_BUTTON_ELEM - 1 - i;
+            const uint8_t differs = ((*buttons ^ self->buttons) >> shift) & 1u;
+            const uint8_t pending = differs ? self->pending[i] + 1 : 0;
+
+            flip[i] = pending >= self->debounce[i];
+            self->pending[i] = flip[i] ? 0 : pending;
+        }
+
+        uint32_t changed = 0x0;
+        for (int i = 0; i < SFGP_BUTTON_ELEM; ++i)
+            changed |= (uint32_t) flip[i] << (SFGP_BUTTON_ELEM - 1 - i);
+        self->buttons ^= (*buttons ^ self->buttons) & changed;
+    }
+
+    self->timestamp = timestamp;
+    memcpy(axes, self->value, sizeof (self->value));
+    *buttons = self->buttons;
+}
@@ -7,104 +7,301 @@
 #include <assert.h>
 
 
-// TODO: Document
-static SFGP_Error _SFGP_InitGamepadArray(void **array, size_t nmemb, size_t size) {
-    assert(array != NULL);
-    assert(nmemb > 0);
-    assert(size > 0);
-
-    void *buffer = calloc(nmemb, size);
-    if (buffer == NULL) return _SFGP_SetError(SFGP_ERROR_FAILED_ALLOCATION);
-
-    for (int i = 0; i < nmemb; i++) {
-        // This may be evil and bad and especially evil.
-        array[i] = buffer + (size * i);
-    }
+/**
+ * @brief Points every control member of \p pad into \p storage.
+ */
+static void _SFGP_BindGamepad(SFGP_Gamepad *const pad,
+        SFGP_GamepadStorage *const storage) {
+    assert(pad != NULL);
+    assert(storage != NULL);
 
-    return SFGP_ERROR_OK;
+    pad->storage = storage;
+    SFGP_GamepadState *const state = _SFGP_GetState(pad);
+
+    for (int i = 0; i < SFGP_JOYSTICK_ELEM; ++i)
+        pad->joysticks[i] = &state->joysticks[i];
+    for (int i = 0; i < SFGP_TRIGGER_ELEM; ++i)
+        pad->triggers[i] = &state->triggers[i];
+    for (int i = 0; i < SFGP_BUTTON_ELEM; ++i) {
+        state->buttons[i].index = (uint8_t) i;
+        pad->buttons[i] = &state->buttons[i];
+    }
 }
 
 
 SFGP_Error SFGP_InitGamepad(SFGP_Gamepad *const pad) {
     assert(pad != NULL);
 
-    if (_SFGP_InitGamepadArray((void **) pad->buttons, SFGP_BUTTON_ELEM, sizeof (*pad->buttons)) != SFGP_ERROR_OK)
-        goto error;
-    if (_SFGP_InitGamepadArray((void **) pad->triggers, SFGP_BUTTON_ELEM, sizeof (*pad->triggers)) != SFGP_ERROR_OK)
-        goto error;
-    if (_SFGP_InitGamepadArray((void **) pad->joysticks, SFGP_BUTTON_ELEM, sizeof (*pad->joysticks)) != SFGP_ERROR_OK)
-        goto error;
+    SFGP_GamepadStorage *storage = malloc(sizeof (*storage));
+    if (storage == NULL) return _SFGP_SetError(SFGP_ERROR_FAILED_ALLOCATION);
+
+    SFGP_InitGamepadWithStorage(pad, storage);
+    pad->owns_storage = 1;
 
     return SFGP_ERROR_OK;
+}
+
+void SFGP_InitGamepadWithStorage(SFGP_Gamepad *const pad,
+        SFGP_GamepadStorage *const storage) {
+    assert(pad != NULL);
+    assert(storage != NULL);
 
-error:
-    SFGP_DeinitGamepad(pad);
-    // SFGP error state already set.
-    return SFGP_ERROR_FAILED_ALLOCATION;
+    memset(storage, 0, sizeof (*storage));
+    _SFGP_BindGamepad(pad, storage);
+    pad->events = NULL;
+    pad->history = NULL;
+    pad->matcher = NULL;
+    pad->shaper = NULL;
+    pad->filters = NULL;
+    pad->stats = NULL;
+    pad->owns_storage = 0;
 }
 
 void SFGP_DeinitGamepad(const SFGP_Gamepad *const pad) {
     assert(pad != NULL);
 
-    free(pad->buttons[0]);
-    free(pad->triggers[0]);
-    free(pad->joysticks[0]); // TODO: Test the work.
+    if (pad->owns_storage) free(pad->storage);
 }
 
+void SFGP_CopyGamepad(SFGP_Gamepad *const dst,
+        const SFGP_Gamepad *const src) {
+    assert(dst != NULL && dst->storage != NULL);
+    assert(src != NULL && src->storage != NULL);
+
+    *dst->storage = *src->storage;
+}
+
+/**
+ * @brief Whether \p frame is the very frame \p self was last updated from.
+ *
+ * Compared field by field against what the state already keeps of the
+ * frame, which is everything but the button mask before filtering.
+ */
+static int _SFGP_IsFrameApplied(const SFGP_GamepadState *const self,
+        const _SFGP_Frame *const frame) {
+    int same = (self->version == frame->version)
+        & (self->timestamp == frame->timestamp)
+        & (self->id == frame->id)
+        & (self->buttons_raw == frame->buttons)
+        & (self->user == frame->user)
+        & (self->type == frame->type);
+
+    for (int i = 0; i < SFGP_AXIS_ELEM; ++i)
+        same &= self->axes[i].raw == frame->axes[i];
+    for (int i = 0; i < SFGP_FINGER_ELEM; ++i) {
+        same &= (self->touchpad[i][0] == frame->touchpad[i][0])
+            & (self->touchpad[i][1] == frame->touchpad[i][1]);
+    }
+
+    return same;
+}
+
+void _SFGP_ApplyFrame(SFGP_Gamepad *const pad,
+        const _SFGP_Frame *const frame) {
+    SFGP_GamepadState *const state = _SFGP_GetState(pad);
+
+    if (_SFGP_IsFrameApplied(state, frame)) return;
+
+    // Rates are taken against the embedded timestamps rather than per call,
+    // so they do not depend on how often the caller's loop runs. Without a
+    // previous frame there is nothing to take a rate against.
+    const float dt = (state->version != 0)
+        ? (float) (frame->timestamp - state->timestamp) / SFGP_TIMESTAMP_HZ
+        : 0.0f;
+
+    state->timestamp = frame->timestamp;
+    state->id = frame->id;
+    state->buttons_raw = frame->buttons;
+    ++state->generation;
+
+    float axes[SFGP_AXIS_ELEM];
+    uint32_t buttons = frame->buttons;
+    memcpy(axes, frame->axes, sizeof (axes));
+
+    if (pad->filters != NULL)
+        _SFGP_FilterFrame(pad->filters, frame->timestamp, axes, &buttons);
+    if (pad->shaper != NULL) _SFGP_ShapeAxes(pad->shaper, axes, axes);
+
+    for (int i = 0; i < SFGP_JOYSTICK_ELEM; ++i) {
+        _SFGP_SetJoystick(&state->joysticks[i],
+                axes[SFGP_AXIS_LEFT_X + (2 * i)],
+                axes[SFGP_AXIS_LEFT_Y + (2 * i)], dt);
+    }
+
+    for (int i = 0; i < SFGP_TRIGGER_ELEM; ++i) {
+        _SFGP_SetTrigger(&state->triggers[i],
+                axes[SFGP_AXIS_LEFT_TRIGGER + i], dt);
+    }
+
+    for (int i = 0; i < SFGP_AXIS_ELEM; ++i) {
+        state->axes[i].raw = frame->axes[i];
+
+        if (pad->filters != NULL) {
+            _SFGP_LatchTrigger(&state->axes[i], pad->filters->press[i],
+                    pad->filters->release[i]);
+        } else {
+            _SFGP_LatchTrigger(&state->axes[i], 1.0f, 1.0f);
+        }
+    }
+
+    _SFGP_SetButtons(state, buttons);
+
+    memcpy(state->touchpad, frame->touchpad, sizeof (state->touchpad));
+    state->user = frame->user;
+    state->type = frame->type;
+    state->version = frame->version;
+
+    if (pad->history != NULL) _SFGP_UpdateHistory(pad->history, state);
+    if (pad->matcher != NULL) _SFGP_UpdateMatcher(pad->matcher, state);
+    if (pad->events != NULL) _SFGP_EmitEvents(pad->events, state);
+}
+
+
 SFGP_Error SFGP_UpdateGamepad(SFGP_Gamepad *const pad, 
         const uint8_t *const byte_array) {
     assert(pad != NULL);
     assert(byte_array != NULL);
 
-    // It is assumed that byte_array contains the required size to querry for
-    // all button states, if this is not the case (it never should be
-    // considering how you should be passing gamepad state in bindings), expect
-    // a segmentation fault!
-    
-    // All operations are based on those found in Gamepad class within the 
-    // FTC SDK.
+    // It is assumed that byte_array holds a full SFGP_FRAME_SIZE frame, as
+    // handed over by bindings. Use SFGP_DecodeGamepad() for anything else.
+#ifdef SFGP_STATS
+    const int64_t start = (pad->stats != NULL) ? _SFGP_GetStatsTime() : 0;
+#endif // SFGP_STATS
 
-    // NOTE: we could also check for version but we are currently only
-    // searching for buttons available in version 1, so theres no need. THIS
-    // WILL NOT BE THE CASE IN THE FUTURE.
+    _SFGP_Frame frame;
+    _SFGP_ReadFrame(&frame, byte_array, 1, 0);
+    _SFGP_ApplyFrame(pad, &frame);
 
-    // 4 bytes store gamepad ID, 8 bytes store the current timestamp.
-    const size_t joystick_offset = 4 + 8;
+#ifdef SFGP_STATS
+    if (pad->stats != NULL) _SFGP_RecordStats(pad->stats, &frame, start);
+#endif // SFGP_STATS
 
-    
-    float stick_x_buf = 0.0f, stick_y_buf = 0.0f;
-    for (int i = 0; i < SFGP_JOYSTICK_ELEM; ++i) {
-        size_t elem = joystick_offset + (sizeof (float) * i * 2);
+    return SFGP_ERROR_OK;
+}
 
-        memcpy(&stick_x_buf, &byte_array[elem], sizeof (stick_x_buf));
-        memcpy(&stick_y_buf, &byte_array[elem + sizeof (float)], sizeof (stick_y_buf));
 
-        _SFGP_SetJoystick(pad->joysticks[i], stick_x_buf, stick_y_buf);
-    }
+// ============================================================================
+//
+//      SDK payloads:
+//
+// ============================================================================
 
-    const size_t trigger_offset = joystick_offset 
-        + (SFGP_JOYSTICK_ELEM * sizeof (float) * 2);
 
-    float trigger_buf = 0.0f;
-    for (int i = 0; i < SFGP_TRIGGER_ELEM; ++i) {
-        size_t elem = trigger_offset + (sizeof (float) * i);
+/**
+ * @brief Size of each known SDK payload version, version byte included.
+ */
+static const size_t _SFGP_PAYLOAD_SIZE[SFGP_PAYLOAD_VERSION_MAX + 1] = {
+    [1] = 1 + SFGP_FRAME_SIZE,
+    [2] = 1 + SFGP_FRAME_SIZE + 1,
+    [3] = 1 + SFGP_FRAME_SIZE + 2,
+    [4] = 1 + SFGP_FRAME_SIZE + 3,
+    [5] = SFGP_PAYLOAD_SIZE_MAX,
+};
+
+_Static_assert(1 + SFGP_FRAME_SIZE + 3
+        + (SFGP_FINGER_ELEM * 2 * sizeof (float))
+        == SFGP_PAYLOAD_SIZE_MAX, "SFGP_PAYLOAD_SIZE_MAX does not match v5");
 
-        memcpy(&trigger_buf, &byte_array[elem], sizeof(trigger_buf));
-        _SFGP_SetTrigger(pad->triggers[i], trigger_buf);
+
+typedef void (*_SFGP_PayloadDecoder)(_SFGP_Frame *const frame,
+        const uint8_t *const body);
+
+#define _SFGP_DEFINE_PAYLOAD_DECODER(version)                                  \
+    static void _SFGP_DecodeV##version(_SFGP_Frame *const frame,              \
+            const uint8_t *const body) {                                       \
+        _SFGP_ReadFrame(frame, body, version, 1);                              \
     }
 
-    const size_t button_offset = joystick_offset
-        + (SFGP_TRIGGER_ELEM * sizeof(float));
+_SFGP_DEFINE_PAYLOAD_DECODER(1)
+_SFGP_DEFINE_PAYLOAD_DECODER(2)
+_SFGP_DEFINE_PAYLOAD_DECODER(3)
+_SFGP_DEFINE_PAYLOAD_DECODER(4)
+_SFGP_DEFINE_PAYLOAD_DECODER(5)
 
-    uint32_t button_data = 0x0;
-    memcpy(&button_data, &byte_array[button_offset], sizeof (button_data));
+#undef _SFGP_DEFINE_PAYLOAD_DECODER
 
-    for (int i = 0; i < SFGP_BUTTON_ELEM; ++i) {
-        int8_t value = (button_data << i) & 1u;
-        _SFGP_SetButton(pad->buttons[i], value);
+static const _SFGP_PayloadDecoder
+        _SFGP_PAYLOAD_DECODER[SFGP_PAYLOAD_VERSION_MAX + 1] = {
+    [1] = _SFGP_DecodeV1,
+    [2] = _SFGP_DecodeV2,
+    [3] = _SFGP_DecodeV3,
+    [4] = _SFGP_DecodeV4,
+    [5] = _SFGP_DecodeV5,
+};
+
+
+int _SFGP_IsFrameValid(const _SFGP_Frame *const frame) {
+    static const float min[SFGP_AXIS_ELEM] = { -1.0f, -1.0f, -1.0f, -1.0f,
+                                               0.0f, 0.0f };
+    int valid = 1;
+    for (int i = 0; i < SFGP_AXIS_ELEM; ++i)
+        valid &= (frame->axes[i] >= min[i]) & (frame->axes[i] <= 1.0f);
+    return valid;
+}
+
+
+SFGP_Error SFGP_DecodeGamepad(SFGP_Gamepad *const pad,
+        const uint8_t *const payload, size_t length) {
+    assert(pad != NULL);
+    assert(payload != NULL || length == 0);
+
+#ifdef SFGP_STATS
+    const int64_t start = (pad->stats != NULL) ? _SFGP_GetStatsTime() : 0;
+#endif // SFGP_STATS
+
+    const uint8_t version = (length > 0) ? payload[0] : 0;
+    const int known = (version > 0 && version <= SFGP_PAYLOAD_VERSION_MAX);
+    if (!known || length < _SFGP_PAYLOAD_SIZE[version]) {
+        return _SFGP_SetError((length > 0 && !known)
+                ? SFGP_ERROR_UNSUPPORTED_VERSION : SFGP_ERROR_MALFORMED_FRAME);
     }
 
-    // No errors currently, but I expect there to be at least some in the 
-    // future.
+    _SFGP_Frame frame;
+    _SFGP_PAYLOAD_DECODER[version](&frame, &payload[1]);
+
+    if (!_SFGP_IsFrameValid(&frame))
+        return _SFGP_SetError(SFGP_ERROR_MALFORMED_FRAME);
+
+    _SFGP_ApplyFrame(pad, &frame);
+
+#ifdef SFGP_STATS
+    if (pad->stats != NULL) _SFGP_RecordStats(pad->stats, &frame, start);
+#endif // SFGP_STATS
+
     return SFGP_ERROR_OK;
-}
\ No newline at end of file
+}
+
+
+int64_t SFGP_GetGamepadTimestamp(const SFGP_Gamepad *const pad) {
+    return _SFGP_InlineGetGamepadTimestamp(pad);
+}
+
+uint32_t SFGP_GetGamepadGeneration(const SFGP_Gamepad *const pad) {
+    return _SFGP_InlineGetGamepadGeneration(pad);
+}
+
+int32_t SFGP_GetGamepadId(const SFGP_Gamepad *const pad) {
+    return _SFGP_InlineGetGamepadId(pad);
+}
+
+uint8_t SFGP_GetGamepadVersion(const SFGP_Gamepad *const pad) {
+    return _SFGP_InlineGetGamepadVersion(pad);
+}
+
+uint8_t SFGP_GetGamepadUser(const SFGP_Gamepad *const pad) {
+    return _SFGP_InlineGetGamepadUser(pad);
+}
+
+uint8_t SFGP_GetGamepadType(const SFGP_Gamepad *const pad) {
+    return _SFGP_InlineGetGamepadType(pad);
+}
+
+float SFGP_GetTouchpadX(const SFGP_Gamepad *const pad,
+        SFGP_TouchpadFinger finger) {
+    return _SFGP_InlineGetTouchpadX(pad, finger);
+}
+
+float SFGP_GetTouchpadY(const SFGP_Gamepad *const pad,
+        SFGP_TouchpadFinger finger) {
+    return _SFGP_InlineGetTouchpadY(pad, finger);
+}
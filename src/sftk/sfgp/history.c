@@ -0,0 +1,209 @@
+/**
+ * @file history.c
+ * @brief Recent frames of a gamepad and timing queries over them.
+ *
+ * Every query is answered from per-button state advanced once per frame.
+ * Press counts are kept over a sliding window: presses are added as frames
+ * enter the ring and taken back out as their frame falls out of the window
+ * or gets overwritten, which costs amortized O(1) per frame.
+ */
+
+
+#include <sftk/sfgp.h>
+#include "sfgp_internal.h"
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <assert.h>
+
+
+/**
+ * @brief Adds \p delta to the press count of every button within \p mask.
+ */
+static void _SFGP_CountPresses(SFGP_History *const self, uint32_t mask,
+        int delta) {
+    for (; mask != 0; mask &= mask - 1)
+        self->presses[_SFGP_GetMaskIndex(mask)] += (uint16_t) delta;
+}
+
+/**
+ * @brief Returns index within the ring of the entry \p age frames old.
+ */
+static inline size_t _SFGP_GetEntryIndex(const SFGP_History *const self,
+        size_t age) {
+    return (self->head + self->capacity - 1 - age) % self->capacity;
+}
+
+
+void SFGP_InitHistory(SFGP_History *const history,
+        SFGP_HistoryEntry *const entries, size_t capacity) {
+    assert(history != NULL);
+    assert(entries != NULL);
+    assert(capacity > 0);
+
+    memset(history, 0, sizeof (*history));
+    history->entries = entries;
+    history->capacity = capacity;
+
+    history->window = SFGP_HISTORY_WINDOW;
+    history->double_tap = SFGP_HISTORY_DOUBLE_TAP;
+    history->long_press = SFGP_HISTORY_LONG_PRESS;
+}
+
+void SFGP_AttachHistory(SFGP_Gamepad *const pad, SFGP_History *const history) {
+    assert(pad != NULL);
+    pad->history = history;
+}
+
+
+void _SFGP_UpdateHistory(SFGP_History *const self,
+        const SFGP_GamepadState *const state) {
+    assert(self->window > 0);
+
+    const int64_t now = state->timestamp;
+    const uint32_t buttons = state->buttons_current;
+    const uint32_t pressed = buttons & ~state->buttons_last;
+    uint32_t new_presses = pressed;
+
+    SFGP_HistoryEntry *newest = (self->length > 0)
+        ? &self->entries[_SFGP_GetEntryIndex(self, 0)]
+        : NULL;
+
+    if (newest != NULL && newest->timestamp == now) {
+        // Same frame passed in again, fold it into the newest entry. Each
+        // button is counted at most once per entry so it can be taken back
+        // out exactly.
+        new_presses &= ~newest->just_pressed;
+        newest->just_pressed |= pressed;
+    } else {
+        if (self->length == self->capacity && self->counted == self->length) {
+            // Oldest entry is about to be overwritten while still counted.
+            _SFGP_CountPresses(self,
+                    self->entries[self->head].just_pressed, -1);
+            --self->counted;
+        }
+
+        newest = &self->entries[self->head];
+        newest->timestamp = now;
+        newest->just_pressed = pressed;
+
+        self->head = (self->head + 1) % self->capacity;
+        if (self->length < self->capacity) ++self->length;
+        ++self->counted;
+    }
+
+    newest->buttons = buttons;
+    for (int i = 0; i < SFGP_AXIS_ELEM; ++i)
+        newest->axes[i] = state->axes[i].current;
+
+    _SFGP_CountPresses(self, new_presses, 1);
+
+    // Drop presses that left the window, oldest first.
+    while (self->counted > 0) {
+        const SFGP_HistoryEntry *oldest =
+            &self->entries[_SFGP_GetEntryIndex(self, self->counted - 1)];
+        if (now - oldest->timestamp < self->window) break;
+
+        _SFGP_CountPresses(self, oldest->just_pressed, -1);
+        --self->counted;
+    }
+
+    // Press timing.
+    self->double_tapped = 0x0;
+    for (uint32_t bits = pressed; bits != 0; bits &= bits - 1) {
+        const int index = _SFGP_GetMaskIndex(bits);
+        const uint32_t mask = SFGP_BUTTON_MASK(index);
+
+        if ((self->pressed_once & mask)
+                && now - self->press_time[index] <= self->double_tap)
+            self->double_tapped |= mask;
+
+        self->press_time[index] = now;
+    }
+    self->pressed_once |= pressed;
+
+    // Only buttons held without interruption can become long presses.
+    self->long_pressed_last = self->long_pressed;
+    self->long_pressed &= buttons & ~pressed;
+    for (uint32_t bits = buttons & ~self->long_pressed; bits != 0;
+            bits &= bits - 1) {
+        const int index = _SFGP_GetMaskIndex(bits);
+        if (now - self->press_time[index] >= self->long_press)
+            self->long_pressed |= SFGP_BUTTON_MASK(index);
+    }
+}
+
+
+size_t SFGP_GetHistoryLength(const SFGP_History *const history) {
+    assert(history != NULL);
+    return history->length;
+}
+
+const SFGP_HistoryEntry *SFGP_GetHistoryEntry(
+        const SFGP_History *const history, size_t age) {
+    assert(history != NULL);
+
+    if (age >= history->length) return NULL;
+    return &history->entries[_SFGP_GetEntryIndex(history, age)];
+}
+
+
+/**
+ * @brief Returns timestamp of the newest frame kept by \p history.
+ */
+static inline int64_t _SFGP_GetHistoryNow(const SFGP_History *const history) {
+    return history->entries[_SFGP_GetEntryIndex(history, 0)].timestamp;
+}
+
+int64_t SFGP_GetButtonHeldTime(const SFGP_History *const history,
+        SFGP_ButtonIndex button) {
+    assert(history != NULL);
+    assert(button < SFGP_BUTTON_ELEM);
+
+    if (history->length == 0) return 0;
+
+    const SFGP_HistoryEntry *newest = SFGP_GetHistoryEntry(history, 0);
+    if (!(newest->buttons & SFGP_BUTTON_MASK(button))) return 0;
+
+    return newest->timestamp - history->press_time[button];
+}
+
+int64_t SFGP_GetTimeSincePress(const SFGP_History *const history,
+        SFGP_ButtonIndex button) {
+    assert(history != NULL);
+    assert(button < SFGP_BUTTON_ELEM);
+
+    if (!(history->pressed_once & SFGP_BUTTON_MASK(button))) return -1;
+    return _SFGP_GetHistoryNow(history) - history->press_time[button];
+}
+
+uint32_t SFGP_GetPressCount(const SFGP_History *const history,
+        SFGP_ButtonIndex button) {
+    assert(history != NULL);
+    assert(button < SFGP_BUTTON_ELEM);
+    return history->presses[button];
+}
+
+int8_t SFGP_IsButtonDoubleTapped(const SFGP_History *const history,
+        SFGP_ButtonIndex button) {
+    assert(history != NULL);
+    assert(button < SFGP_BUTTON_ELEM);
+    return (history->double_tapped & SFGP_BUTTON_MASK(button)) != 0;
+}
+
+int8_t SFGP_IsButtonLongPressed(const SFGP_History *const history,
+        SFGP_ButtonIndex button) {
+    assert(history != NULL);
+    assert(button < SFGP_BUTTON_ELEM);
+    return (history->long_pressed & SFGP_BUTTON_MASK(button)) != 0;
+}
+
+int8_t SFGP_IsButtonJustLongPressed(const SFGP_History *const history,
+        SFGP_ButtonIndex button) {
+    assert(history != NULL);
+    assert(button < SFGP_BUTTON_ELEM);
+
+    const uint32_t mask = SFGP_BUTTON_MASK(button);
+    return (history->long_pressed & ~history->long_pressed_last & mask) != 0;
+}
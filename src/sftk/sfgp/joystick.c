@@ -6,110 +6,120 @@
 #include <assert.h>
 
 
-/**
- * @brief Data required to perform checks on an individual joystick.
- */
-struct SFGP_Joystick {
-    struct SFGP_Trigger x; /**< Trigger data representing joysticks x axis. */
-    struct SFGP_Trigger y; /**< Trigger data representing joysticks y axis. */
-};
-
-
-void _SFGP_SetJoystick(SFGP_Joystick *const self, float curr_x, float curr_y) {
+void _SFGP_SetJoystick(SFGP_Joystick *const self, float curr_x, float curr_y,
+        float dt) {
     assert(self != NULL);
     assert(curr_x <= 1.0f && curr_x >= -1.0f);
     assert(curr_y <= 1.0f && curr_y >= -1.0f);
 
-    _SFGP_SetTrigger(&self->x, curr_x);
-    _SFGP_SetTrigger(&self->y, curr_y);
+    _SFGP_SetTrigger(&self->x, curr_x, dt);
+    _SFGP_SetTrigger(&self->y, curr_y, dt);
 }
 
 
-// A lot of the following function calls could be replaced by referencing an
-// axis to a respective trigger, however I believe that would reduce
-// readability for the "improvement" from a single line of code to a single
-// line of code with a function call in it. 
+// Each axis is queried as the trigger it is stored as, with the same inline
+// queries sftk/sfgp_inline.h gives callers.
 
 // x-axis
 
 int8_t SFGP_IsXAtMax(const SFGP_Joystick *const self) {
     assert(self != NULL);
-    return self->x.current >= 1.0f;
+    return _SFGP_InlineIsTriggerPressed(&self->x);
 }
 
 int8_t SFGP_IsXJustAtMax(const SFGP_Joystick *const self) {
     assert(self != NULL);
-    return self->x.current >= 1.0f && self->x.last < 1.0f;
+    return _SFGP_InlineIsTriggerJustPressed(&self->x);
 }
 
 int8_t SFGP_IsXAtMin(const SFGP_Joystick *const self) {
     assert(self != NULL);
-    return self->x.current <= -1.0f;
+    return _SFGP_InlineIsTriggerAtMin(&self->x);
 }
 
 int8_t SFGP_IsXJustAtMin(const SFGP_Joystick *const self) {
     assert(self != NULL);
-    return self->x.current <= -1.0f && self->x.last > -1.0f;
+    return _SFGP_InlineIsTriggerJustAtMin(&self->x);
 }
 
 int8_t SFGP_IsXAtZero(const SFGP_Joystick *const self) {
     assert(self != NULL);
-    return self->x.current == 0.0f;
+    return _SFGP_InlineIsTriggerAtZero(&self->x);
 }
 
 int8_t SFGP_IsXJustAtZero(const SFGP_Joystick *const self) {
     assert(self != NULL);
-    return self->x.current == 0.0f && self->y.last != 0.0f;
+    return _SFGP_InlineIsTriggerJustAtZero(&self->x);
 }
 
 float SFGP_GetXValue(const SFGP_Joystick *const self) {
     assert(self != NULL);
-    return self->x.current;
+    return _SFGP_InlineGetTriggerValue(&self->x);
+}
+
+float SFGP_GetXRawValue(const SFGP_Joystick *const self) {
+    assert(self != NULL);
+    return _SFGP_InlineGetTriggerRawValue(&self->x);
 }
 
 float SFGP_GetXVelocity(const SFGP_Joystick *const self) {
     assert(self != NULL);
-    return self->x.current - self->y.last;
+    return _SFGP_InlineGetTriggerVelocity(&self->x);
+}
+
+float SFGP_GetXAcceleration(const SFGP_Joystick *const self) {
+    assert(self != NULL);
+    return _SFGP_InlineGetTriggerAcceleration(&self->x);
 }
 
 // y-axis
 
 int8_t SFGP_IsYAtMax(const SFGP_Joystick *const self) {
     assert(self != NULL);
-    return self->y.current >= 1.0f;
+    return _SFGP_InlineIsTriggerPressed(&self->y);
 }
 
 int8_t SFGP_IsYJustAtMax(const SFGP_Joystick *const self) {
     assert(self != NULL);
-    return self->y.current >= 1.0f && self->y.last < 1.0f;
+    return _SFGP_InlineIsTriggerJustPressed(&self->y);
 }
 
 int8_t SFGP_IsYAtMin(const SFGP_Joystick *const self) {
     assert(self != NULL);
-    return self->y.current <= -1.0f;
+    return _SFGP_InlineIsTriggerAtMin(&self->y);
 }
 
 int8_t SFGP_IsYJustAtMin(const SFGP_Joystick *const self) {
     assert(self != NULL);
-    return self->y.current <= -1.0f && self->y.last > -1.0f;
+    return _SFGP_InlineIsTriggerJustAtMin(&self->y);
 }
 
 int8_t SFGP_IsYAtZero(const SFGP_Joystick *const self) {
     assert(self != NULL);
-    return self->y.current == 0.0f;
+    return _SFGP_InlineIsTriggerAtZero(&self->y);
 }
 
 int8_t SFGP_IsYJustAtZero(const SFGP_Joystick *const self) {
     assert(self != NULL);
-    return self->y.current == 0.0f && self->y.last != 0.0f;
+    return _SFGP_InlineIsTriggerJustAtZero(&self->y);
 }
 
 float SFGP_GetYValue(const SFGP_Joystick *const self) {
     assert(self != NULL);
-    return self->y.current;
+    return _SFGP_InlineGetTriggerValue(&self->y);
+}
+
+float SFGP_GetYRawValue(const SFGP_Joystick *const self) {
+    assert(self != NULL);
+    return _SFGP_InlineGetTriggerRawValue(&self->y);
 }
 
 float SFGP_GetYVelocity(const SFGP_Joystick *const self) {
     assert(self != NULL);
-    return self->y.current - self->y.last;
+    return _SFGP_InlineGetTriggerVelocity(&self->y);
+}
+
+float SFGP_GetYAcceleration(const SFGP_Joystick *const self) {
+    assert(self != NULL);
+    return _SFGP_InlineGetTriggerAcceleration(&self->y);
 }
\ No newline at end of file
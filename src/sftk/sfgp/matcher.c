@@ -0,0 +1,505 @@
+/**
+ * @file matcher.c
+ * @brief Button chords and sequences compiled into a single automaton.
+ *
+ * Chords are kept in an open addressing table keyed by the exact mask of
+ * buttons held, so a frame needs a single lookup no matter how many chords
+ * exist. Sequences are compiled into an Aho-Corasick automaton whose alphabet
+ * is the set of distinct press masks used by any step. Failure links are
+ * folded into a dense transition table, so every press costs one symbol
+ * lookup and one table read. Per-sequence timing is only checked for the
+ * sequences the automaton reports as matched, against a ring of the latest
+ * step timestamps.
+ */
+
+
+#include <sftk/sfgp.h>
+#include "sfgp_internal.h"
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+
+#define _SFGP_NONE UINT32_MAX
+
+
+// ============================================================================
+//
+//      Helpers:
+//
+// ============================================================================
+
+
+/**
+ * @brief Returns slot count keeping a table of \p n masks at most half full.
+ */
+static uint32_t _SFGP_GetSlotCount(uint32_t n) {
+    uint32_t count = 2;
+    while (count < 2 * n) count <<= 1;
+    return count;
+}
+
+/**
+ * @brief Returns slot holding \p mask, or the empty slot it belongs in.
+ */
+static inline _SFGP_MaskSlot *_SFGP_FindSlot(_SFGP_MaskSlot *const slots,
+        uint32_t slot_count, uint32_t mask) {
+    uint32_t i = _SFGP_HashSlot(mask, slot_count);
+    while (slots[i].mask != 0 && slots[i].mask != mask)
+        i = (i + 1) & (slot_count - 1);
+    return &slots[i];
+}
+
+/**
+ * @brief Grows \p array to hold at least \p needed elements of \p size.
+ *
+ * @returns Grown array, or `NULL` with \p array and \p capacity untouched.
+ */
+static void *_SFGP_Grow(void *array, uint32_t *const capacity,
+        uint32_t needed, size_t size) {
+    if (needed <= *capacity) return array;
+
+    uint32_t grown = (*capacity > 0) ? *capacity : 16;
+    while (grown < needed) grown *= 2;
+
+    void *result = realloc(array, grown * size);
+    if (result != NULL) *capacity = grown;
+    return result;
+}
+
+static void _SFGP_FreeTables(_SFGP_MatcherTables *const tables) {
+    free(tables->chords);
+    free(tables->chord_patterns);
+    free(tables->symbols);
+    free(tables->next);
+    free(tables->output_start);
+    free(tables->outputs);
+    free(tables->symbol_times);
+    free(tables->fired);
+    memset(tables, 0, sizeof (*tables));
+}
+
+
+// ============================================================================
+//
+//      Registration:
+//
+// ============================================================================
+
+
+SFGP_Error SFGP_CreateMatcher(SFGP_Matcher **const matcher) {
+    assert(matcher != NULL);
+
+    SFGP_Matcher *self = calloc(1, sizeof (*self));
+    if (self == NULL) return _SFGP_SetError(SFGP_ERROR_FAILED_ALLOCATION);
+
+    *matcher = self;
+    return SFGP_ERROR_OK;
+}
+
+void SFGP_DestroyMatcher(SFGP_Matcher *const matcher) {
+    if (matcher == NULL) return;
+
+    _SFGP_FreeTables(&matcher->tables);
+    free(matcher->patterns);
+    free(matcher->steps);
+    free(matcher);
+}
+
+/**
+ * @brief Appends \p pattern to \p self.
+ */
+static SFGP_Error _SFGP_AddPattern(SFGP_Matcher *const self,
+        _SFGP_Pattern pattern) {
+    _SFGP_Pattern *patterns = _SFGP_Grow(self->patterns,
+            &self->pattern_capacity, self->pattern_count + 1,
+            sizeof (*patterns));
+    if (patterns == NULL) return _SFGP_SetError(SFGP_ERROR_FAILED_ALLOCATION);
+
+    self->patterns = patterns;
+    self->patterns[self->pattern_count++] = pattern;
+    return SFGP_ERROR_OK;
+}
+
+SFGP_Error SFGP_AddChord(SFGP_Matcher *const matcher, uint32_t id,
+        uint32_t mask, int64_t tolerance) {
+    assert(matcher != NULL);
+    assert(mask != 0 && (mask & ~_SFGP_BUTTON_MASK_ALL) == 0);
+    assert(tolerance >= 0);
+
+    return _SFGP_AddPattern(matcher, (_SFGP_Pattern) {
+        .tolerance = tolerance,
+        .id = id,
+        .mask = mask,
+        .length = 0,
+    });
+}
+
+SFGP_Error SFGP_AddSequence(SFGP_Matcher *const matcher, uint32_t id,
+        const uint32_t *const steps, size_t length, int64_t gap) {
+    assert(matcher != NULL);
+    assert(steps != NULL);
+    assert(length > 0 && length <= SFGP_SEQUENCE_MAX);
+    assert(gap >= 0);
+
+    uint32_t *pool = _SFGP_Grow(matcher->steps, &matcher->step_capacity,
+            matcher->step_count + (uint32_t) length, sizeof (*pool));
+    if (pool == NULL) return _SFGP_SetError(SFGP_ERROR_FAILED_ALLOCATION);
+    matcher->steps = pool;
+
+    const SFGP_Error error = _SFGP_AddPattern(matcher, (_SFGP_Pattern) {
+        .tolerance = gap,
+        .id = id,
+        .mask = matcher->step_count,
+        .length = (uint32_t) length,
+    });
+    if (error != SFGP_ERROR_OK) return error;
+
+    for (size_t i = 0; i < length; ++i) {
+        assert(steps[i] != 0 && (steps[i] & ~_SFGP_BUTTON_MASK_ALL) == 0);
+        matcher->steps[matcher->step_count++] = steps[i];
+    }
+
+    return SFGP_ERROR_OK;
+}
+
+
+// ============================================================================
+//
+//      Compilation:
+//
+// ============================================================================
+
+
+/**
+ * @brief Groups chords of \p self by exact mask into \p t.
+ */
+static void _SFGP_CompileChords(const SFGP_Matcher *const self,
+        _SFGP_MatcherTables *const t) {
+    // Count chords per mask, turn counts into group starts, then fill.
+    for (uint32_t i = 0; i < self->pattern_count; ++i) {
+        const _SFGP_Pattern *p = &self->patterns[i];
+        if (p->length != 0) continue;
+
+        _SFGP_MaskSlot *slot = _SFGP_FindSlot(t->chords, t->chord_slots, p->mask);
+        slot->mask = p->mask;
+        ++slot->count;
+    }
+
+    uint32_t start = 0;
+    for (uint32_t i = 0; i < t->chord_slots; ++i) {
+        t->chords[i].value = start;
+        start += t->chords[i].count;
+        t->chords[i].count = 0;
+    }
+
+    for (uint32_t i = 0; i < self->pattern_count; ++i) {
+        const _SFGP_Pattern *p = &self->patterns[i];
+        if (p->length != 0) continue;
+
+        _SFGP_MaskSlot *slot = _SFGP_FindSlot(t->chords, t->chord_slots, p->mask);
+        t->chord_patterns[slot->value + slot->count++] = i;
+    }
+}
+
+/**
+ * @brief Builds the sequence automaton of \p self into \p t.
+ *
+ * @param[in]   self: Matcher whose sequences to compile.
+ * @param[out]  t: Tables with .symbols, .next, .output_start, and .outputs
+ *              allocated for \p max_nodes nodes.
+ * @param[in]   max_nodes: One more than the total number of steps.
+ * @param[out]  max_outputs: Most sequences matched at a single node.
+ *
+ * @returns `SFGP_ERROR_OK`, or `SFGP_ERROR_FAILED_ALLOCATION`.
+ */
+static SFGP_Error _SFGP_CompileSequences(const SFGP_Matcher *const self,
+        _SFGP_MatcherTables *const t, uint32_t max_nodes,
+        uint32_t *const max_outputs) {
+    const uint32_t pattern_count = self->pattern_count;
+    uint32_t *fail = malloc(sizeof (*fail) * max_nodes);
+    uint32_t *order = malloc(sizeof (*order) * max_nodes);
+    uint32_t *own_head = malloc(sizeof (*own_head) * max_nodes);
+    uint32_t *out_count = malloc(sizeof (*out_count) * max_nodes);
+    uint32_t *own_next = malloc(sizeof (*own_next) * (pattern_count + 1));
+
+    SFGP_Error error = SFGP_ERROR_OK;
+    if (fail == NULL || order == NULL || own_head == NULL
+            || out_count == NULL || own_next == NULL) {
+        error = _SFGP_SetError(SFGP_ERROR_FAILED_ALLOCATION);
+        goto cleanup;
+    }
+
+    // Alphabet: every distinct step mask.
+    for (uint32_t i = 0; i < self->step_count; ++i) {
+        _SFGP_MaskSlot *slot = _SFGP_FindSlot(t->symbols, t->symbol_slots,
+                self->steps[i]);
+        if (slot->mask == 0) {
+            slot->mask = self->steps[i];
+            slot->value = t->symbol_count++;
+        }
+    }
+
+    const uint32_t s_count = t->symbol_count;
+    t->next = malloc(sizeof (*t->next) * max_nodes * (s_count ? s_count : 1));
+    if (t->next == NULL) {
+        error = _SFGP_SetError(SFGP_ERROR_FAILED_ALLOCATION);
+        goto cleanup;
+    }
+
+    for (size_t i = 0; i < (size_t) max_nodes * s_count; ++i)
+        t->next[i] = _SFGP_NONE;
+    for (uint32_t i = 0; i < max_nodes; ++i) own_head[i] = _SFGP_NONE;
+
+    // Trie of every sequence, each node listing sequences ending there.
+    t->node_count = 1;
+    for (uint32_t i = 0; i < pattern_count; ++i) {
+        const _SFGP_Pattern *p = &self->patterns[i];
+        if (p->length == 0) continue;
+
+        uint32_t node = 0;
+        for (uint32_t s = 0; s < p->length; ++s) {
+            const uint32_t symbol = _SFGP_FindSlot(t->symbols, t->symbol_slots,
+                    self->steps[p->mask + s])->value;
+            uint32_t *child = &t->next[(node * s_count) + symbol];
+            if (*child == _SFGP_NONE) *child = t->node_count++;
+            node = *child;
+        }
+
+        own_next[i] = own_head[node];
+        own_head[node] = i;
+    }
+
+    // Breadth first, so failure targets are always complete before they are
+    // copied from. Missing transitions become their failure's transition.
+    uint32_t head = 0, tail = 1;
+    order[0] = 0;
+    fail[0] = 0;
+    while (head < tail) {
+        const uint32_t node = order[head++];
+
+        for (uint32_t s = 0; s < s_count; ++s) {
+            uint32_t *child = &t->next[(node * s_count) + s];
+            const uint32_t fallback = (node == 0)
+                ? 0 : t->next[(fail[node] * s_count) + s];
+
+            if (*child == _SFGP_NONE) {
+                *child = fallback;
+            } else {
+                fail[*child] = fallback;
+                order[tail++] = *child;
+            }
+        }
+    }
+
+    // Every node outputs its own sequences and those of its failure node.
+    uint32_t total = 0;
+    *max_outputs = 0;
+    for (uint32_t i = 0; i < t->node_count; ++i) {
+        const uint32_t node = order[i];
+        uint32_t count = (node == 0) ? 0 : out_count[fail[node]];
+        for (uint32_t p = own_head[node]; p != _SFGP_NONE; p = own_next[p])
+            ++count;
+
+        out_count[node] = count;
+        total += count;
+        if (count > *max_outputs) *max_outputs = count;
+    }
+
+    t->outputs = malloc(sizeof (*t->outputs) * (total ? total : 1));
+    if (t->outputs == NULL) {
+        error = _SFGP_SetError(SFGP_ERROR_FAILED_ALLOCATION);
+        goto cleanup;
+    }
+
+    uint32_t start = 0;
+    for (uint32_t node = 0; node < t->node_count; ++node) {
+        t->output_start[node] = start;
+        start += out_count[node];
+    }
+    t->output_start[t->node_count] = start;
+
+    for (uint32_t i = 0; i < t->node_count; ++i) {
+        const uint32_t node = order[i];
+        uint32_t *out = &t->outputs[t->output_start[node]];
+
+        for (uint32_t p = own_head[node]; p != _SFGP_NONE; p = own_next[p])
+            *out++ = p;
+        if (node != 0) {
+            memcpy(out, &t->outputs[t->output_start[fail[node]]],
+                    sizeof (*out) * out_count[fail[node]]);
+        }
+    }
+
+cleanup:
+    free(fail);
+    free(order);
+    free(own_head);
+    free(out_count);
+    free(own_next);
+    return error;
+}
+
+SFGP_Error SFGP_CompileMatcher(SFGP_Matcher *const matcher) {
+    assert(matcher != NULL);
+
+    _SFGP_MatcherTables t = { 0 };
+    uint32_t chord_count = 0;
+
+    for (uint32_t i = 0; i < matcher->pattern_count; ++i) {
+        const _SFGP_Pattern *p = &matcher->patterns[i];
+        if (p->length == 0) {
+            ++chord_count;
+            continue;
+        }
+
+        if (p->length > t.max_length) t.max_length = p->length;
+        if (p->tolerance > t.max_gap) t.max_gap = p->tolerance;
+    }
+
+    const uint32_t max_nodes = 1 + matcher->step_count;
+    t.chord_slots = _SFGP_GetSlotCount(chord_count);
+    t.symbol_slots = _SFGP_GetSlotCount(matcher->step_count);
+
+    t.chords = calloc(t.chord_slots, sizeof (*t.chords));
+    t.chord_patterns = malloc(sizeof (*t.chord_patterns)
+            * (chord_count ? chord_count : 1));
+    t.symbols = calloc(t.symbol_slots, sizeof (*t.symbols));
+    t.output_start = malloc(sizeof (*t.output_start) * (max_nodes + 1));
+    t.symbol_times = calloc(t.max_length ? t.max_length : 1,
+            sizeof (*t.symbol_times));
+
+    if (t.chords == NULL || t.chord_patterns == NULL || t.symbols == NULL
+            || t.output_start == NULL || t.symbol_times == NULL) {
+        _SFGP_FreeTables(&t);
+        return _SFGP_SetError(SFGP_ERROR_FAILED_ALLOCATION);
+    }
+
+    _SFGP_CompileChords(matcher, &t);
+
+    uint32_t max_outputs = 0;
+    if (_SFGP_CompileSequences(matcher, &t, max_nodes, &max_outputs)
+            != SFGP_ERROR_OK) {
+        _SFGP_FreeTables(&t);
+        return SFGP_ERROR_FAILED_ALLOCATION;
+    }
+
+    uint32_t max_chords = 0;
+    for (uint32_t i = 0; i < t.chord_slots; ++i)
+        if (t.chords[i].count > max_chords) max_chords = t.chords[i].count;
+
+    t.fired = malloc(sizeof (*t.fired) * (max_chords + max_outputs + 1));
+    if (t.fired == NULL) {
+        _SFGP_FreeTables(&t);
+        return _SFGP_SetError(SFGP_ERROR_FAILED_ALLOCATION);
+    }
+
+    _SFGP_FreeTables(&matcher->tables);
+    matcher->tables = t;
+
+    matcher->node = 0;
+    matcher->symbol_head = 0;
+    matcher->last_symbol = 0;
+    matcher->fired_count = 0;
+    memset(matcher->press_time, 0, sizeof (matcher->press_time));
+
+    return SFGP_ERROR_OK;
+}
+
+
+// ============================================================================
+//
+//      Matching:
+//
+// ============================================================================
+
+
+void SFGP_AttachMatcher(SFGP_Gamepad *const pad, SFGP_Matcher *const matcher) {
+    assert(pad != NULL);
+    pad->matcher = matcher;
+}
+
+/**
+ * @brief Whether the latest \p length steps were each at most \p gap apart.
+ */
+static int _SFGP_IsWithinGap(const SFGP_Matcher *const self, uint32_t length,
+        int64_t gap) {
+    const _SFGP_MatcherTables *const t = &self->tables;
+
+    uint32_t i = (self->symbol_head + t->max_length - 1) % t->max_length;
+    for (uint32_t s = 1; s < length; ++s) {
+        const uint32_t before = (i + t->max_length - 1) % t->max_length;
+        if (t->symbol_times[i] - t->symbol_times[before] > gap) return 0;
+        i = before;
+    }
+
+    return 1;
+}
+
+void _SFGP_UpdateMatcher(SFGP_Matcher *const self,
+        const SFGP_GamepadState *const state) {
+    const _SFGP_MatcherTables *const t = &self->tables;
+    self->fired_count = 0;
+
+    const uint32_t held = state->buttons_current;
+    const uint32_t pressed = held & ~state->buttons_last;
+    if (pressed == 0 || t->fired == NULL) return;
+
+    const int64_t now = state->timestamp;
+    for (uint32_t bits = pressed; bits != 0; bits &= bits - 1)
+        self->press_time[_SFGP_GetMaskIndex(bits)] = now;
+
+    // Chords, by exact mask of everything held.
+    const _SFGP_MaskSlot *chord = _SFGP_FindSlot(t->chords, t->chord_slots, held);
+    if (chord->mask != 0) {
+        int64_t first = now;
+        for (uint32_t bits = held; bits != 0; bits &= bits - 1) {
+            const int64_t time = self->press_time[_SFGP_GetMaskIndex(bits)];
+            if (time < first) first = time;
+        }
+
+        for (uint32_t i = 0; i < chord->count; ++i) {
+            const _SFGP_Pattern *p =
+                &self->patterns[t->chord_patterns[chord->value + i]];
+            if (now - first <= p->tolerance) t->fired[self->fired_count++] = p->id;
+        }
+    }
+
+    if (t->node_count <= 1) return;
+
+    // Sequences, by exact mask of everything pressed on this frame. A press
+    // outside the alphabet, or a pause no sequence allows, starts over.
+    const _SFGP_MaskSlot *symbol =
+        _SFGP_FindSlot(t->symbols, t->symbol_slots, pressed);
+    if (symbol->mask == 0) {
+        self->node = 0;
+        return;
+    }
+
+    if (now - self->last_symbol > t->max_gap) self->node = 0;
+    self->last_symbol = now;
+
+    t->symbol_times[self->symbol_head] = now;
+    self->symbol_head = (self->symbol_head + 1) % t->max_length;
+
+    self->node = t->next[(self->node * t->symbol_count) + symbol->value];
+
+    for (uint32_t i = t->output_start[self->node];
+            i < t->output_start[self->node + 1]; ++i) {
+        const _SFGP_Pattern *p = &self->patterns[t->outputs[i]];
+        if (_SFGP_IsWithinGap(self, p->length, p->tolerance))
+            t->fired[self->fired_count++] = p->id;
+    }
+}
+
+const uint32_t *SFGP_GetMatches(const SFGP_Matcher *const matcher,
+        size_t *const count) {
+    assert(matcher != NULL);
+    assert(count != NULL);
+
+    *count = matcher->fired_count;
+    return matcher->tables.fired;
+}
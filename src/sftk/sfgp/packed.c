@@ -0,0 +1,223 @@
+/**
+ * @file packed.c
+ * @brief Compact fixed-point form of a gamepad's state.
+ */
+
+
+#include <sftk/sfgp.h>
+#include "sfgp_internal.h"
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <math.h>
+#include <assert.h>
+
+
+_Static_assert(sizeof (SFGP_PackedPad) == 64,
+        "SFGP_PackedPad must fill exactly one cache line");
+_Static_assert(SFGP_AXIS_ELEM * 4 <= 32,
+        "SFGP_PackedPad latches do not fit every axis");
+
+
+#define _SFGP_LATCH_BITS 4
+#define _SFGP_LATCH_MASK ((1u << _SFGP_LATCH_BITS) - 1)
+
+
+int16_t _SFGP_QuantizeAxis(float value) {
+    if (value >= 1.0f) return SFGP_PACKED_AXIS_MAX;
+    if (value <= -1.0f) return -SFGP_PACKED_AXIS_MAX;
+    if (value == 0.0f) return 0;
+
+    // Anything strictly inside (-1, 1) and non-zero must stay so.
+    long q = lrintf(value * SFGP_PACKED_AXIS_MAX);
+    if (q >= SFGP_PACKED_AXIS_MAX) q = SFGP_PACKED_AXIS_MAX - 1;
+    if (q <= -SFGP_PACKED_AXIS_MAX) q = -SFGP_PACKED_AXIS_MAX + 1;
+    if (q == 0) q = (value > 0.0f) ? 1 : -1;
+
+    return (int16_t) q;
+}
+
+static inline uint8_t _SFGP_GetLatches(const SFGP_PackedPad *const pad,
+        SFGP_AxisIndex axis) {
+    return (pad->latches >> (_SFGP_LATCH_BITS * axis)) & _SFGP_LATCH_MASK;
+}
+
+
+void SFGP_PackGamepad(SFGP_PackedPad *const dst,
+        const SFGP_Gamepad *const src) {
+    assert(dst != NULL);
+    assert(src != NULL);
+
+    const SFGP_GamepadState *const state = _SFGP_GetState(src);
+    memset(dst, 0, sizeof (*dst));
+
+    dst->timestamp = state->timestamp;
+    dst->id = state->id;
+    dst->buttons_current = state->buttons_current;
+    dst->buttons_last = state->buttons_last;
+
+    for (int i = 0; i < SFGP_AXIS_ELEM; ++i) {
+        dst->current[i] = _SFGP_QuantizeAxis(state->axes[i].current);
+        dst->last[i] = _SFGP_QuantizeAxis(state->axes[i].last);
+        dst->latches |= (uint32_t) (state->axes[i].flags & _SFGP_LATCH_MASK)
+            << (_SFGP_LATCH_BITS * i);
+    }
+}
+
+void SFGP_UnpackGamepad(SFGP_Gamepad *const dst,
+        const SFGP_PackedPad *const src) {
+    assert(dst != NULL && dst->storage != NULL);
+    assert(src != NULL);
+
+    SFGP_GamepadState *const state = _SFGP_GetState(dst);
+
+    state->timestamp = src->timestamp;
+    state->id = src->id;
+    state->buttons_current = src->buttons_current;
+    state->buttons_last = src->buttons_last;
+    state->buttons_raw = src->buttons_current;
+    ++state->generation;
+
+    for (int i = 0; i < SFGP_AXIS_ELEM; ++i) {
+        SFGP_Trigger *const axis = &state->axes[i];
+
+        axis->current = _SFGP_DequantizeAxis(src->current[i]);
+        axis->last = _SFGP_DequantizeAxis(src->last[i]);
+        axis->raw = axis->current;
+        axis->velocity = 0.0f;
+        axis->acceleration = 0.0f;
+        axis->has_rate = 0;
+        axis->flags = _SFGP_GetLatches(src, i);
+    }
+}
+
+/**
+ * @brief Whether \p frame is the very frame \p self was last updated from,
+ * as far as quantized axes tell.
+ */
+static int _SFGP_IsPackedFrameApplied(const SFGP_PackedPad *const self,
+        const _SFGP_Frame *const frame,
+        const int16_t axes[SFGP_AXIS_ELEM]) {
+    int same = (self->timestamp == frame->timestamp)
+        & (self->id == frame->id)
+        & (self->buttons_current == frame->buttons);
+
+    for (int i = 0; i < SFGP_AXIS_ELEM; ++i)
+        same &= self->current[i] == axes[i];
+
+    return same;
+}
+
+SFGP_Error SFGP_UpdatePackedPad(SFGP_PackedPad *const pad,
+        const uint8_t *const byte_array) {
+    assert(pad != NULL);
+    assert(byte_array != NULL);
+
+    // Checked before quantizing, which is undefined for NaNs.
+    _SFGP_Frame frame;
+    _SFGP_ReadFrame(&frame, byte_array, 1, 0);
+    if (!_SFGP_IsFrameValid(&frame))
+        return _SFGP_SetError(SFGP_ERROR_MALFORMED_FRAME);
+
+    int16_t axes[SFGP_AXIS_ELEM];
+    for (int i = 0; i < SFGP_AXIS_ELEM; ++i)
+        axes[i] = _SFGP_QuantizeAxis(frame.axes[i]);
+
+    // Repeated frames leave edges as they are, as on full gamepads.
+    if (_SFGP_IsPackedFrameApplied(pad, &frame, axes)) return SFGP_ERROR_OK;
+
+    pad->timestamp = frame.timestamp;
+    pad->id = frame.id;
+    pad->buttons_last = pad->buttons_current;
+    pad->buttons_current = frame.buttons;
+
+    uint32_t latches = 0x0;
+    for (int i = 0; i < SFGP_AXIS_ELEM; ++i) {
+        const int16_t value = axes[i];
+        pad->last[i] = pad->current[i];
+        pad->current[i] = value;
+
+        const uint8_t last = _SFGP_GetLatches(pad, i) & 0x3;
+        const uint8_t now = (value >= SFGP_PACKED_AXIS_MAX ? _SFGP_AXIS_AT_MAX : 0)
+            | (value <= -SFGP_PACKED_AXIS_MAX ? _SFGP_AXIS_AT_MIN : 0);
+
+        latches |= (uint32_t) ((last << _SFGP_AXIS_LAST_SHIFT) | now)
+            << (_SFGP_LATCH_BITS * i);
+    }
+    pad->latches = latches;
+
+    return SFGP_ERROR_OK;
+}
+
+
+float SFGP_GetPackedAxisValue(const SFGP_PackedPad *const pad,
+        SFGP_AxisIndex axis) {
+    assert(pad != NULL);
+    assert(axis < SFGP_AXIS_ELEM);
+    return _SFGP_DequantizeAxis(pad->current[axis]);
+}
+
+/**
+ * @brief Whether latch \p flag of \p axis is set, and if \p just, whether it
+ * was also just set.
+ */
+static int8_t _SFGP_IsPackedLatched(const SFGP_PackedPad *const pad,
+        SFGP_AxisIndex axis, uint8_t flag, int just) {
+    assert(pad != NULL);
+    assert(axis < SFGP_AXIS_ELEM);
+
+    const uint8_t latches = _SFGP_GetLatches(pad, axis);
+    const uint8_t last = just ? (latches >> _SFGP_AXIS_LAST_SHIFT) : 0;
+    return (latches & ~last & flag) != 0;
+}
+
+int8_t SFGP_IsPackedAxisAtMax(const SFGP_PackedPad *const pad,
+        SFGP_AxisIndex axis) {
+    return _SFGP_IsPackedLatched(pad, axis, _SFGP_AXIS_AT_MAX, 0);
+}
+
+int8_t SFGP_IsPackedAxisJustAtMax(const SFGP_PackedPad *const pad,
+        SFGP_AxisIndex axis) {
+    return _SFGP_IsPackedLatched(pad, axis, _SFGP_AXIS_AT_MAX, 1);
+}
+
+int8_t SFGP_IsPackedAxisAtMin(const SFGP_PackedPad *const pad,
+        SFGP_AxisIndex axis) {
+    return _SFGP_IsPackedLatched(pad, axis, _SFGP_AXIS_AT_MIN, 0);
+}
+
+int8_t SFGP_IsPackedAxisJustAtMin(const SFGP_PackedPad *const pad,
+        SFGP_AxisIndex axis) {
+    return _SFGP_IsPackedLatched(pad, axis, _SFGP_AXIS_AT_MIN, 1);
+}
+
+int8_t SFGP_IsPackedAxisAtZero(const SFGP_PackedPad *const pad,
+        SFGP_AxisIndex axis) {
+    assert(pad != NULL);
+    assert(axis < SFGP_AXIS_ELEM);
+    return pad->current[axis] == 0;
+}
+
+int8_t SFGP_IsPackedAxisJustAtZero(const SFGP_PackedPad *const pad,
+        SFGP_AxisIndex axis) {
+    assert(pad != NULL);
+    assert(axis < SFGP_AXIS_ELEM);
+    return pad->current[axis] == 0 && pad->last[axis] != 0;
+}
+
+
+uint32_t SFGP_GetPackedButtonsPressed(const SFGP_PackedPad *const pad) {
+    assert(pad != NULL);
+    return pad->buttons_current;
+}
+
+uint32_t SFGP_GetPackedButtonsJustPressed(const SFGP_PackedPad *const pad) {
+    assert(pad != NULL);
+    return pad->buttons_current & ~pad->buttons_last;
+}
+
+uint32_t SFGP_GetPackedButtonsJustReleased(const SFGP_PackedPad *const pad) {
+    assert(pad != NULL);
+    return ~pad->buttons_current & pad->buttons_last;
+}
@@ -0,0 +1,428 @@
+/**
+ * @file record.c
+ * @brief Capturing gamepad data arrays to disk and replaying them later.
+ *
+ * File layout, all integers in host byte order, with the headers in
+ * sfgp_internal.h:
+ *
+ *     header      _SFGP_RecordHeader
+ *     frames      per frame: uint32 length, uint32 reserved, length bytes of
+ *                 data, padded to a multiple of 8 bytes
+ *     index       uint64 offset of every frame, written on close
+ */
+
+
+#include <sftk/sfgp.h>
+#include "sfgp_internal.h"
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+
+#if !_WIN32
+    #include <errno.h>
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <sys/types.h>
+    #include <time.h>
+    #include <unistd.h>
+#endif // !_WIN32
+
+
+// ============================================================================
+//
+//      Recorder:
+//
+// ============================================================================
+
+
+/**
+ * @brief Seeks \p file to \p offset from its start, past 2 GiB even where
+ * `long` is 32 bits.
+ */
+static int _SFGP_Seek(FILE *const file, uint64_t offset) {
+#if _WIN32
+    return _fseeki64(file, (__int64) offset, SEEK_SET);
+#else
+    return fseeko(file, (off_t) offset, SEEK_SET);
+#endif // _WIN32
+}
+
+/**
+ * @brief Drops everything of \p file past \p offset, and continues writing
+ * from there.
+ *
+ * @returns 0 on success.
+ */
+static int _SFGP_Rewind(FILE *const file, uint64_t offset) {
+    if (_SFGP_Seek(file, offset) != 0) return -1;
+
+#if !_WIN32
+    // The file is then as if the partial write never happened, even for
+    // replays rebuilding its index.
+    if (fflush(file) != 0) return -1;
+    return ftruncate(fileno(file), (off_t) offset);
+#else
+    return 0;
+#endif // !_WIN32
+}
+
+
+SFGP_Error SFGP_OpenRecorder(SFGP_Recorder *const rec, const char *const path) {
+    assert(rec != NULL);
+    assert(path != NULL);
+
+    FILE *file = fopen(path, "w+b");
+    if (file == NULL) return _SFGP_SetError(SFGP_ERROR_IO);
+
+    _SFGP_RecordHeader header = {
+        .magic = _SFGP_RECORD_MAGIC,
+        .version = _SFGP_RECORD_VERSION,
+        .header_size = sizeof (header),
+    };
+
+    if (fwrite(&header, sizeof (header), 1, file) != 1) {
+        fclose(file);
+        return _SFGP_SetError(SFGP_ERROR_IO);
+    }
+
+    rec->file = file;
+    rec->count = 0;
+    rec->offset = sizeof (header);
+    rec->index = NULL;
+    rec->capacity = 0;
+
+    return SFGP_ERROR_OK;
+}
+
+SFGP_Error SFGP_RecordFrame(SFGP_Recorder *const rec,
+        const uint8_t *const byte_array, size_t length) {
+    assert(rec != NULL && rec->file != NULL);
+    assert(byte_array != NULL);
+    assert(length <= UINT32_MAX);
+
+    static const uint8_t padding[8] = { 0 };
+    const _SFGP_FrameHeader header = { .length = (uint32_t) length };
+    const size_t pad = (size_t) (_SFGP_Pad8(length) - length);
+
+    // Offsets are kept as they are written, so closing writes the index in
+    // one go rather than walking the file back.
+    if (rec->count == rec->capacity) {
+        const uint64_t capacity = (rec->capacity != 0)
+            ? rec->capacity * 2
+            : 1024;
+
+        uint64_t *index = realloc(rec->index, sizeof (*index) * capacity);
+        if (index == NULL)
+            return _SFGP_SetError(SFGP_ERROR_FAILED_ALLOCATION);
+
+        rec->index = index;
+        rec->capacity = capacity;
+    }
+
+    // A short write leaves nothing behind, so the index stays in step with
+    // the frames actually in the file.
+    if (fwrite(&header, sizeof (header), 1, rec->file) != 1
+            || fwrite(byte_array, 1, length, rec->file) != length
+            || fwrite(padding, 1, pad, rec->file) != pad) {
+        (void) _SFGP_Rewind(rec->file, rec->offset);
+        return _SFGP_SetError(SFGP_ERROR_IO);
+    }
+
+    rec->index[rec->count++] = rec->offset;
+    rec->offset += sizeof (header) + length + pad;
+
+    return SFGP_ERROR_OK;
+}
+
+SFGP_Error SFGP_CloseRecorder(SFGP_Recorder *const rec) {
+    assert(rec != NULL && rec->file != NULL);
+
+    FILE *file = rec->file;
+    uint64_t *index = rec->index;
+    rec->file = NULL;
+    rec->index = NULL;
+    rec->capacity = 0;
+
+    // Frames are only ever appended, so the index follows right after them.
+    const size_t count = (size_t) rec->count;
+    int8_t failed = (rec->count > SIZE_MAX / sizeof (*index))
+        || fwrite(index, sizeof (*index), count, file) != count;
+    free(index);
+
+    _SFGP_RecordHeader header = {
+        .magic = _SFGP_RECORD_MAGIC,
+        .version = _SFGP_RECORD_VERSION,
+        .header_size = sizeof (header),
+        .count = rec->count,
+        .index_offset = rec->offset,
+    };
+
+    // Left without an index on failure, which replays rebuild when opened.
+    failed = failed
+        || _SFGP_Seek(file, 0) != 0
+        || fwrite(&header, sizeof (header), 1, file) != 1;
+
+    failed |= (fclose(file) != 0);
+    return failed ? _SFGP_SetError(SFGP_ERROR_IO) : SFGP_ERROR_OK;
+}
+
+
+// ============================================================================
+//
+//      Replay:
+//
+// ============================================================================
+
+
+/**
+ * @brief Rebuilds index of a recording that was never closed.
+ */
+static SFGP_Error _SFGP_RebuildIndex(SFGP_Replay *const replay) {
+    uint64_t count = 0, offset = sizeof (_SFGP_RecordHeader);
+    uint64_t *index = NULL;
+
+    // First pass counts, second fills.
+    for (int pass = 0; pass < 2; ++pass) {
+        count = 0;
+        offset = sizeof (_SFGP_RecordHeader);
+
+        while (offset + sizeof (_SFGP_FrameHeader) <= replay->size) {
+            _SFGP_FrameHeader header;
+            memcpy(&header, &replay->data[offset], sizeof (header));
+
+            const uint64_t next = offset + sizeof (header)
+                + _SFGP_Pad8(header.length);
+            if (next > replay->size) break; // Torn final frame.
+
+            if (index != NULL) index[count] = offset;
+            ++count;
+            offset = next;
+        }
+
+        if (pass == 0) {
+            index = malloc(sizeof (*index) * (count ? count : 1));
+            if (index == NULL) return _SFGP_SetError(SFGP_ERROR_FAILED_ALLOCATION);
+        }
+    }
+
+    replay->index = index;
+    replay->count = count;
+    replay->owns_index = 1;
+
+    return SFGP_ERROR_OK;
+}
+
+/**
+ * @brief Checks every frame listed in the index lies within the mapping.
+ */
+static int8_t _SFGP_IsIndexValid(const SFGP_Replay *const replay) {
+    for (uint64_t i = 0; i < replay->count; ++i) {
+        const uint64_t offset = replay->index[i];
+        if (offset % 8 != 0
+                || offset + sizeof (_SFGP_FrameHeader) > replay->size)
+            return 0;
+
+        _SFGP_FrameHeader header;
+        memcpy(&header, &replay->data[offset], sizeof (header));
+        if (offset + sizeof (header) + header.length > replay->size)
+            return 0;
+    }
+
+    return 1;
+}
+
+
+SFGP_Error SFGP_OpenReplay(SFGP_Replay *const replay, const char *const path) {
+    assert(replay != NULL);
+    assert(path != NULL);
+
+    memset(replay, 0, sizeof (*replay));
+
+#if _WIN32
+    (void) path;
+    return _SFGP_SetError(SFGP_ERROR_UNSUPPORTED);
+#else
+    const int fd = open(path, O_RDONLY);
+    if (fd < 0) return _SFGP_SetError(SFGP_ERROR_IO);
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return _SFGP_SetError(SFGP_ERROR_IO);
+    }
+
+    if ((size_t) st.st_size < sizeof (_SFGP_RecordHeader)) {
+        close(fd);
+        return _SFGP_SetError(SFGP_ERROR_INVALID_FILE);
+    }
+
+    void *data = mmap(NULL, (size_t) st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) return _SFGP_SetError(SFGP_ERROR_IO);
+
+    replay->data = data;
+    replay->size = (size_t) st.st_size;
+
+    // Replays are read front to back.
+    madvise(data, replay->size, MADV_SEQUENTIAL);
+
+    _SFGP_RecordHeader header;
+    memcpy(&header, replay->data, sizeof (header));
+
+    if (memcmp(header.magic, _SFGP_RECORD_MAGIC, sizeof (_SFGP_RECORD_MAGIC)) != 0
+            || header.version != _SFGP_RECORD_VERSION
+            || header.header_size != sizeof (header)) {
+        SFGP_CloseReplay(replay);
+        return _SFGP_SetError(SFGP_ERROR_INVALID_FILE);
+    }
+
+    if (header.index_offset == 0) {
+        const SFGP_Error error = _SFGP_RebuildIndex(replay);
+        if (error != SFGP_ERROR_OK) SFGP_CloseReplay(replay);
+        return error;
+    }
+
+    if (header.index_offset % 8 != 0
+            || header.index_offset > replay->size
+            || header.count > (replay->size - header.index_offset)
+                / sizeof (uint64_t)) {
+        SFGP_CloseReplay(replay);
+        return _SFGP_SetError(SFGP_ERROR_INVALID_FILE);
+    }
+
+    replay->index = (const uint64_t *) &replay->data[header.index_offset];
+    replay->count = header.count;
+
+    if (!_SFGP_IsIndexValid(replay)) {
+        SFGP_CloseReplay(replay);
+        return _SFGP_SetError(SFGP_ERROR_INVALID_FILE);
+    }
+
+    return SFGP_ERROR_OK;
+#endif // _WIN32
+}
+
+void SFGP_CloseReplay(SFGP_Replay *const replay) {
+    assert(replay != NULL);
+
+    if (replay->owns_index) free((void *) replay->index);
+
+#if !_WIN32
+    if (replay->data != NULL) munmap((void *) replay->data, replay->size);
+#endif // !_WIN32
+
+    memset(replay, 0, sizeof (*replay));
+}
+
+
+const uint8_t *SFGP_GetReplayFrame(const SFGP_Replay *const replay,
+        uint64_t frame, size_t *const length) {
+    assert(replay != NULL);
+    assert(frame < replay->count);
+
+    const uint8_t *header = &replay->data[replay->index[frame]];
+
+    if (length != NULL) {
+        uint32_t frame_length;
+        memcpy(&frame_length, header, sizeof (frame_length));
+        *length = frame_length;
+    }
+
+    return header + sizeof (_SFGP_FrameHeader);
+}
+
+/**
+ * @brief Returns timestamp embedded in frame number \p frame.
+ */
+static int64_t _SFGP_GetReplayTimestamp(const SFGP_Replay *const replay,
+        uint64_t frame) {
+    size_t length;
+    const uint8_t *data = SFGP_GetReplayFrame(replay, frame, &length);
+
+    int64_t timestamp = 0;
+    if (length >= _SFGP_FRAME_TIMESTAMP_OFFSET + sizeof (timestamp)) {
+        memcpy(&timestamp, &data[_SFGP_FRAME_TIMESTAMP_OFFSET],
+                sizeof (timestamp));
+    }
+
+    return timestamp;
+}
+
+uint64_t SFGP_FindReplayFrame(const SFGP_Replay *const replay,
+        int64_t timestamp) {
+    assert(replay != NULL);
+
+    uint64_t lo = 0, hi = replay->count;
+    while (lo < hi) {
+        const uint64_t mid = lo + ((hi - lo) / 2);
+        if (_SFGP_GetReplayTimestamp(replay, mid) < timestamp) lo = mid + 1;
+        else hi = mid;
+    }
+
+    return lo;
+}
+
+
+SFGP_Error SFGP_RunReplay(const SFGP_Replay *const replay,
+        SFGP_Gamepad *const pad, SFGP_ReplayMode mode,
+        SFGP_ReplayCallback callback, void *user) {
+    assert(replay != NULL);
+    assert(pad != NULL);
+
+#if _WIN32
+    if (mode == SFGP_REPLAY_REAL_TIME)
+        return _SFGP_SetError(SFGP_ERROR_UNSUPPORTED);
+#else
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    const int64_t first = (replay->count > 0)
+        ? _SFGP_GetReplayTimestamp(replay, 0)
+        : 0;
+#endif // _WIN32
+
+    for (uint64_t i = 0; i < replay->count; ++i) {
+        size_t length;
+        const uint8_t *data = SFGP_GetReplayFrame(replay, i, &length);
+        if (length < SFGP_FRAME_SIZE)
+            return _SFGP_SetError(SFGP_ERROR_INVALID_FILE);
+
+        // Files are not trusted, so frames are checked the same way as SDK
+        // payloads instead of going through SFGP_UpdateGamepad().
+        _SFGP_Frame frame;
+        _SFGP_ReadFrame(&frame, data, 1, 0);
+        if (!_SFGP_IsFrameValid(&frame))
+            return _SFGP_SetError(SFGP_ERROR_INVALID_FILE);
+
+#if !_WIN32
+        if (mode == SFGP_REPLAY_REAL_TIME) {
+            const int64_t elapsed = _SFGP_GetReplayTimestamp(replay, i) - first;
+            const int64_t ns = (elapsed > 0)
+                ? (elapsed * (1000000000 / SFGP_TIMESTAMP_HZ))
+                : 0;
+
+            struct timespec deadline = {
+                .tv_sec = start.tv_sec + (time_t) (ns / 1000000000),
+                .tv_nsec = start.tv_nsec + (long) (ns % 1000000000),
+            };
+            if (deadline.tv_nsec >= 1000000000) {
+                deadline.tv_nsec -= 1000000000;
+                ++deadline.tv_sec;
+            }
+
+            while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline,
+                        NULL) == EINTR);
+        }
+#endif // !_WIN32
+
+        _SFGP_ApplyFrame(pad, &frame);
+
+        if (callback != NULL && callback(pad, i, user)) break;
+    }
+
+    return SFGP_ERROR_OK;
+}
@@ -0,0 +1,248 @@
+/**
+ * @file registry.c
+ * @brief Every gamepad seen, routed to by the ID embedded in its frames.
+ *
+ * Slots are handed out through a single permutation of slot indices, the
+ * first .count of them being taken and the rest free, so taking, releasing,
+ * and iterating over slots never searches. IDs map onto slots through a
+ * linear probing table at most half full, with backward shift deletion so
+ * that no tombstones build up as gamepads come and go.
+ */
+
+
+#include <sftk/sfgp.h>
+#include "sfgp_internal.h"
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <assert.h>
+
+
+#define _SFGP_SLOT_EMPTY UINT32_MAX
+
+
+struct SFGP_Registry {
+    void *block;                    /**< As returned by malloc(). */
+    SFGP_GamepadStorage *storage;   /**< Per slot. */
+    SFGP_Gamepad *pads;             /**< Per slot. */
+    int32_t *ids;                   /**< Per slot. */
+    uint32_t *order;                /**< Taken slots, then free ones. */
+    uint32_t *position;             /**< Per slot, its index in .order. */
+
+    uint32_t *table;                /**< Slot per hash, or empty. */
+    uint32_t mask;                  /**< Table size - 1. */
+
+    uint32_t capacity;
+    uint32_t count;
+};
+
+
+/**
+ * @brief Rounds \p offset up to a multiple of \p alignment.
+ */
+static inline size_t _SFGP_Align(size_t offset, size_t alignment) {
+    return (offset + alignment - 1) & ~(alignment - 1);
+}
+
+static inline uint32_t _SFGP_HashId(const SFGP_Registry *const self,
+        int32_t id) {
+    return _SFGP_HashSlot((uint32_t) id, self->mask + 1);
+}
+
+/**
+ * @brief Returns table index holding \p id, or the empty one it would go to.
+ */
+static uint32_t _SFGP_ProbeId(const SFGP_Registry *const self, int32_t id) {
+    uint32_t i = _SFGP_HashId(self, id);
+
+    while (self->table[i] != _SFGP_SLOT_EMPTY
+            && self->ids[self->table[i]] != id)
+        i = (i + 1) & self->mask;
+
+    return i;
+}
+
+
+SFGP_Error SFGP_CreateRegistry(SFGP_Registry **const registry,
+        size_t capacity) {
+    assert(registry != NULL);
+    assert(capacity > 0 && capacity <= (UINT32_MAX >> 2));
+
+    uint32_t table_size = 1;
+    while (table_size < 2 * capacity) table_size <<= 1;
+
+    // Storage goes first, on a cache line of its own.
+    size_t size = _SFGP_Align(sizeof (SFGP_Registry), 64);
+    const size_t storage_at = size;
+    size += sizeof (SFGP_GamepadStorage) * capacity;
+    const size_t pads_at = size = _SFGP_Align(size, _Alignof (SFGP_Gamepad));
+    size += sizeof (SFGP_Gamepad) * capacity;
+    const size_t ids_at = size = _SFGP_Align(size, _Alignof (uint32_t));
+    size += sizeof (int32_t) * capacity;
+    const size_t order_at = size;
+    size += sizeof (uint32_t) * capacity;
+    const size_t position_at = size;
+    size += sizeof (uint32_t) * capacity;
+    const size_t table_at = size;
+    size += sizeof (uint32_t) * table_size;
+
+    // aligned_alloc() is missing from older Android releases, so the block
+    // is aligned by hand.
+    void *const raw = malloc(size + 63);
+    if (raw == NULL) return _SFGP_SetError(SFGP_ERROR_FAILED_ALLOCATION);
+
+    uint8_t *const block = (uint8_t *) _SFGP_Align((uintptr_t) raw, 64);
+    SFGP_Registry *const self = (SFGP_Registry *) block;
+    self->block = raw;
+    self->storage = (SFGP_GamepadStorage *) &block[storage_at];
+    self->pads = (SFGP_Gamepad *) &block[pads_at];
+    self->ids = (int32_t *) &block[ids_at];
+    self->order = (uint32_t *) &block[order_at];
+    self->position = (uint32_t *) &block[position_at];
+    self->table = (uint32_t *) &block[table_at];
+    self->mask = table_size - 1;
+    self->capacity = (uint32_t) capacity;
+    self->count = 0;
+
+    for (uint32_t i = 0; i < self->capacity; ++i) {
+        self->order[i] = i;
+        self->position[i] = i;
+    }
+    for (uint32_t i = 0; i < table_size; ++i)
+        self->table[i] = _SFGP_SLOT_EMPTY;
+
+    *registry = self;
+    return SFGP_ERROR_OK;
+}
+
+void SFGP_DestroyRegistry(SFGP_Registry *const registry) {
+    if (registry != NULL) free(registry->block);
+}
+
+
+/**
+ * @brief Returns gamepad of \p id, taking a free slot for it if new.
+ *
+ * @param[out]  created: Set if a slot was taken.
+ * @returns NULL if \p id is new and no slot is free.
+ */
+static SFGP_Gamepad *_SFGP_AcquireGamepad(SFGP_Registry *const self,
+        int32_t id, int *const created) {
+    const uint32_t i = _SFGP_ProbeId(self, id);
+    *created = 0;
+
+    if (self->table[i] != _SFGP_SLOT_EMPTY) return &self->pads[self->table[i]];
+    if (self->count == self->capacity) return NULL;
+
+    const uint32_t slot = self->order[self->count++];
+    self->ids[slot] = id;
+    self->table[i] = slot;
+    SFGP_InitGamepadWithStorage(&self->pads[slot], &self->storage[slot]);
+
+    *created = 1;
+    return &self->pads[slot];
+}
+
+SFGP_Error SFGP_RouteFrame(SFGP_Registry *const registry,
+        const uint8_t *const byte_array, SFGP_Gamepad **const pad) {
+    assert(registry != NULL);
+    assert(byte_array != NULL);
+
+    const int32_t id = (int32_t)
+        _SFGP_Load32(&byte_array[_SFGP_FRAME_ID_OFFSET], 0);
+
+    int created;
+    SFGP_Gamepad *const target = _SFGP_AcquireGamepad(registry, id, &created);
+    if (pad != NULL) *pad = target;
+    if (target == NULL) return _SFGP_SetError(SFGP_ERROR_REGISTRY_FULL);
+
+    return SFGP_UpdateGamepad(target, byte_array);
+}
+
+SFGP_Error SFGP_RoutePayload(SFGP_Registry *const registry,
+        const uint8_t *const payload, size_t length,
+        SFGP_Gamepad **const pad) {
+    assert(registry != NULL);
+    assert(payload != NULL || length == 0);
+
+    if (pad != NULL) *pad = NULL;
+
+    // Every payload version starts with its version byte and then the ID,
+    // anything shorter is rejected as SFGP_DecodeGamepad() would.
+    if (length < 1 + sizeof (int32_t)) {
+        const int known = (length > 0 && payload[0] > 0
+                && payload[0] <= SFGP_PAYLOAD_VERSION_MAX);
+        return _SFGP_SetError((length > 0 && !known)
+                ? SFGP_ERROR_UNSUPPORTED_VERSION : SFGP_ERROR_MALFORMED_FRAME);
+    }
+
+    const int32_t id = (int32_t) _SFGP_Load32(&payload[1], 1);
+
+    int created;
+    SFGP_Gamepad *const target = _SFGP_AcquireGamepad(registry, id, &created);
+    if (target == NULL) return _SFGP_SetError(SFGP_ERROR_REGISTRY_FULL);
+
+    const SFGP_Error error = SFGP_DecodeGamepad(target, payload, length);
+    if (error != SFGP_ERROR_OK) {
+        if (created) SFGP_RemoveGamepad(registry, id);
+        return error;
+    }
+
+    if (pad != NULL) *pad = target;
+    return SFGP_ERROR_OK;
+}
+
+
+SFGP_Gamepad *SFGP_FindGamepad(const SFGP_Registry *const registry,
+        int32_t id) {
+    assert(registry != NULL);
+
+    const uint32_t slot = registry->table[_SFGP_ProbeId(registry, id)];
+    return (slot != _SFGP_SLOT_EMPTY) ? &registry->pads[slot] : NULL;
+}
+
+int8_t SFGP_RemoveGamepad(SFGP_Registry *const registry, int32_t id) {
+    assert(registry != NULL);
+    SFGP_Registry *const self = registry;
+
+    uint32_t hole = _SFGP_ProbeId(self, id);
+    const uint32_t slot = self->table[hole];
+    if (slot == _SFGP_SLOT_EMPTY) return 0;
+
+    // Shift back every following entry of the run that could sit in the
+    // hole, i.e. whose home is not cyclically within (hole, i].
+    for (uint32_t i = (hole + 1) & self->mask;
+            self->table[i] != _SFGP_SLOT_EMPTY; i = (i + 1) & self->mask) {
+        const uint32_t home = _SFGP_HashId(self, self->ids[self->table[i]]);
+        if (((i - home) & self->mask) < ((i - hole) & self->mask)) continue;
+
+        self->table[hole] = self->table[i];
+        hole = i;
+    }
+    self->table[hole] = _SFGP_SLOT_EMPTY;
+
+    // Swap the slot with the last taken one, freeing it.
+    const uint32_t at = self->position[slot];
+    const uint32_t last = self->order[--self->count];
+
+    self->order[at] = last;
+    self->position[last] = at;
+    self->order[self->count] = slot;
+    self->position[slot] = self->count;
+
+    return 1;
+}
+
+
+size_t SFGP_GetRegistryCount(const SFGP_Registry *const registry) {
+    assert(registry != NULL);
+    return registry->count;
+}
+
+SFGP_Gamepad *SFGP_GetRegistryGamepad(const SFGP_Registry *const registry,
+        size_t index) {
+    assert(registry != NULL);
+    assert(index < registry->count);
+    return &registry->pads[registry->order[index]];
+}
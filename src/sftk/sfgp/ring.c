@@ -0,0 +1,356 @@
+/**
+ * @file ring.c
+ * @brief Frames handed over between processes through shared memory.
+ *
+ * Classic single producer, single consumer ring over free running 32 bit
+ * positions, one written by each side and each on a cache line of its own.
+ * A sleeping consumer waits on the producer's position as a futex, and
+ * announces so through a flag the producer checks after publishing, so the
+ * producer only ever makes a system call when someone is actually asleep.
+ */
+
+
+#include <sftk/sfgp.h>
+#include "sfgp_internal.h"
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <assert.h>
+
+#if !_WIN32
+    #include <errno.h>
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <time.h>
+    #include <unistd.h>
+#endif // !_WIN32
+
+#if defined(__linux__)
+    #include <linux/futex.h>
+    #include <sys/syscall.h>
+#endif // __linux__
+
+
+#define _SFGP_RING_MAGIC "SFGPRING"
+#define _SFGP_RING_VERSION 1
+#define _SFGP_RING_SLOT_SIZE 64
+
+_Static_assert(SFGP_FRAME_SIZE <= _SFGP_RING_SLOT_SIZE,
+        "gamepad data arrays must fit within a ring slot");
+
+
+/**
+ * @brief Start of every ring file, followed by .capacity slots.
+ */
+typedef struct _SFGP_RingHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t header_size;
+    uint32_t slot_size;
+    uint32_t capacity;
+
+    _Alignas(64) uint32_t head;     /**< Frames written, by producer. */
+
+    _Alignas(64) uint32_t tail;     /**< Frames read, by consumer. */
+    uint32_t sleeping;              /**< Set while consumer sleeps on head. */
+} _SFGP_RingHeader;
+
+_Static_assert(sizeof (_SFGP_RingHeader) % _SFGP_RING_SLOT_SIZE == 0,
+        "ring slots must start on a cache line");
+
+
+static inline _SFGP_RingHeader *_SFGP_GetRingHeader(
+        const SFGP_FrameRing *const ring) {
+    return (_SFGP_RingHeader *) ring->data;
+}
+
+static inline uint8_t *_SFGP_GetRingSlot(const SFGP_FrameRing *const ring,
+        uint32_t position) {
+    const _SFGP_RingHeader *const header = _SFGP_GetRingHeader(ring);
+    const uint32_t index = position & (header->capacity - 1);
+
+    return (uint8_t *) ring->data + sizeof (*header)
+        + ((size_t) index * _SFGP_RING_SLOT_SIZE);
+}
+
+
+#if !_WIN32
+
+/**
+ * @brief Maps \p size bytes of \p fd into \p ring, closing \p fd.
+ */
+static SFGP_Error _SFGP_MapRing(SFGP_FrameRing *const ring, int fd,
+        size_t size) {
+    void *data = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) return _SFGP_SetError(SFGP_ERROR_IO);
+
+    ring->data = data;
+    ring->size = size;
+    return SFGP_ERROR_OK;
+}
+
+#endif // !_WIN32
+
+
+SFGP_Error SFGP_CreateFrameRing(SFGP_FrameRing *const ring,
+        const char *const path, size_t capacity) {
+    assert(ring != NULL);
+    assert(path != NULL);
+    assert(capacity > 0 && capacity <= UINT32_C(1) << 24);
+    assert((capacity & (capacity - 1)) == 0);
+
+    memset(ring, 0, sizeof (*ring));
+
+#if _WIN32
+    (void) path;
+    (void) capacity;
+    return _SFGP_SetError(SFGP_ERROR_UNSUPPORTED);
+#else
+    const size_t size = sizeof (_SFGP_RingHeader)
+        + (capacity * _SFGP_RING_SLOT_SIZE);
+
+    const int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0660);
+    if (fd < 0) return _SFGP_SetError(SFGP_ERROR_IO);
+
+    if (ftruncate(fd, (off_t) size) != 0) {
+        close(fd);
+        return _SFGP_SetError(SFGP_ERROR_IO);
+    }
+
+    const SFGP_Error error = _SFGP_MapRing(ring, fd, size);
+    if (error != SFGP_ERROR_OK) return error;
+
+    // The file starts out zeroed, the magic goes in last so that a ring is
+    // never opened half initialized.
+    _SFGP_RingHeader *const header = _SFGP_GetRingHeader(ring);
+    header->version = _SFGP_RING_VERSION;
+    header->header_size = sizeof (*header);
+    header->slot_size = _SFGP_RING_SLOT_SIZE;
+    header->capacity = (uint32_t) capacity;
+
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    memcpy(header->magic, _SFGP_RING_MAGIC, sizeof (header->magic));
+
+    return SFGP_ERROR_OK;
+#endif // _WIN32
+}
+
+SFGP_Error SFGP_OpenFrameRing(SFGP_FrameRing *const ring,
+        const char *const path) {
+    assert(ring != NULL);
+    assert(path != NULL);
+
+    memset(ring, 0, sizeof (*ring));
+
+#if _WIN32
+    (void) path;
+    return _SFGP_SetError(SFGP_ERROR_UNSUPPORTED);
+#else
+    const int fd = open(path, O_RDWR);
+    if (fd < 0) return _SFGP_SetError(SFGP_ERROR_IO);
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return _SFGP_SetError(SFGP_ERROR_IO);
+    }
+
+    if ((size_t) st.st_size < sizeof (_SFGP_RingHeader)) {
+        close(fd);
+        return _SFGP_SetError(SFGP_ERROR_INVALID_FILE);
+    }
+
+    const SFGP_Error error = _SFGP_MapRing(ring, fd, (size_t) st.st_size);
+    if (error != SFGP_ERROR_OK) return error;
+
+    const _SFGP_RingHeader *const header = _SFGP_GetRingHeader(ring);
+    const uint32_t capacity = header->capacity;
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+    if (memcmp(header->magic, _SFGP_RING_MAGIC, sizeof (header->magic)) != 0
+            || header->version != _SFGP_RING_VERSION
+            || header->header_size != sizeof (*header)
+            || header->slot_size != _SFGP_RING_SLOT_SIZE
+            || capacity == 0 || (capacity & (capacity - 1)) != 0
+            || ring->size != sizeof (*header)
+                + ((size_t) capacity * _SFGP_RING_SLOT_SIZE)) {
+        SFGP_CloseFrameRing(ring);
+        return _SFGP_SetError(SFGP_ERROR_INVALID_FILE);
+    }
+
+    return SFGP_ERROR_OK;
+#endif // _WIN32
+}
+
+void SFGP_CloseFrameRing(SFGP_FrameRing *const ring) {
+    assert(ring != NULL);
+
+#if !_WIN32
+    if (ring->data != NULL) munmap(ring->data, ring->size);
+#endif // !_WIN32
+
+    memset(ring, 0, sizeof (*ring));
+}
+
+
+// ============================================================================
+//
+//      Handoff:
+//
+// ============================================================================
+
+
+#if defined(__linux__)
+
+static void _SFGP_WakeRing(uint32_t *const word) {
+    syscall(SYS_futex, word, FUTEX_WAKE, 1, NULL, NULL, 0);
+}
+
+/**
+ * @brief Sleeps while \p word holds \p value, for at most \p timeout ns when
+ * not negative. May return early.
+ */
+static void _SFGP_SleepRing(uint32_t *const word, uint32_t value,
+        int64_t timeout) {
+    struct timespec span = {
+        .tv_sec = (time_t) (timeout / 1000000000),
+        .tv_nsec = (long) (timeout % 1000000000),
+    };
+    syscall(SYS_futex, word, FUTEX_WAIT, value,
+            (timeout >= 0) ? &span : NULL, NULL, 0);
+}
+
+#endif // __linux__
+
+
+/**
+ * @brief Eases off the core between polls of a spinning consumer.
+ */
+static inline void _SFGP_RelaxRing(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    __asm__ volatile ("yield");
+#endif // arch
+}
+
+#if !_WIN32
+
+static int64_t _SFGP_GetRingTime(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((int64_t) now.tv_sec * 1000000000) + now.tv_nsec;
+}
+
+#endif // !_WIN32
+
+
+SFGP_Error SFGP_WriteFrameRing(SFGP_FrameRing *const ring,
+        const uint8_t *const byte_array) {
+    assert(ring != NULL && ring->data != NULL);
+    assert(byte_array != NULL);
+
+    _SFGP_RingHeader *const header = _SFGP_GetRingHeader(ring);
+    const uint32_t head = __atomic_load_n(&header->head, __ATOMIC_RELAXED);
+    const uint32_t tail = __atomic_load_n(&header->tail, __ATOMIC_ACQUIRE);
+
+    if (head - tail >= header->capacity)
+        return _SFGP_SetError(SFGP_ERROR_RING_FULL);
+
+    memcpy(_SFGP_GetRingSlot(ring, head), byte_array, SFGP_FRAME_SIZE);
+
+    // Sequentially consistent against the consumer setting .sleeping and
+    // then checking .head, so one of the two always sees the other.
+    __atomic_store_n(&header->head, head + 1, __ATOMIC_SEQ_CST);
+
+#if defined(__linux__)
+    if (__atomic_load_n(&header->sleeping, __ATOMIC_SEQ_CST))
+        _SFGP_WakeRing(&header->head);
+#endif // __linux__
+
+    return SFGP_ERROR_OK;
+}
+
+/**
+ * @brief Waits for .head of \p header to move past \p tail.
+ *
+ * @returns Whether it did before \p timeout ran out.
+ */
+static int _SFGP_WaitRing(_SFGP_RingHeader *const header, uint32_t tail,
+        SFGP_RingWait wait, int64_t timeout) {
+#if _WIN32
+    (void) header;
+    (void) tail;
+    (void) wait;
+    (void) timeout;
+    return 0;
+#else
+    const int64_t deadline = _SFGP_GetRingTime() + timeout;
+
+    for (uint32_t polls = 1; ; ++polls) {
+        if (wait == SFGP_RING_SPIN) {
+            _SFGP_RelaxRing();
+            if (__atomic_load_n(&header->head, __ATOMIC_ACQUIRE) != tail)
+                return 1;
+
+            // Reading the clock costs more than a poll.
+            if (timeout < 0 || polls % 256 != 0) continue;
+        }
+
+#if defined(__linux__)
+        if (wait == SFGP_RING_SLEEP) {
+            __atomic_store_n(&header->sleeping, 1, __ATOMIC_SEQ_CST);
+
+            const int64_t left = (timeout >= 0)
+                ? deadline - _SFGP_GetRingTime() : -1;
+            if (__atomic_load_n(&header->head, __ATOMIC_SEQ_CST) == tail
+                    && (timeout < 0 || left > 0))
+                _SFGP_SleepRing(&header->head, tail, left);
+
+            __atomic_store_n(&header->sleeping, 0, __ATOMIC_RELAXED);
+            if (__atomic_load_n(&header->head, __ATOMIC_ACQUIRE) != tail)
+                return 1;
+        }
+#endif // __linux__
+
+        if (timeout >= 0 && _SFGP_GetRingTime() >= deadline) return 0;
+    }
+#endif // _WIN32
+}
+
+SFGP_Error SFGP_ReadFrameRing(SFGP_FrameRing *const ring,
+        SFGP_Gamepad *const pad, SFGP_RingWait wait, int64_t timeout,
+        int8_t *const read) {
+    assert(ring != NULL && ring->data != NULL);
+    assert(pad != NULL);
+    assert(read != NULL);
+
+    *read = 0;
+
+#if !defined(__linux__)
+    if (wait == SFGP_RING_SLEEP) return _SFGP_SetError(SFGP_ERROR_UNSUPPORTED);
+#endif // !__linux__
+
+    _SFGP_RingHeader *const header = _SFGP_GetRingHeader(ring);
+    const uint32_t tail = __atomic_load_n(&header->tail, __ATOMIC_RELAXED);
+
+    if (__atomic_load_n(&header->head, __ATOMIC_ACQUIRE) == tail
+            && (wait == SFGP_RING_NO_WAIT
+                || !_SFGP_WaitRing(header, tail, wait, timeout)))
+        return SFGP_ERROR_OK;
+
+    // Copied out first, so the slot goes back to the producer right away.
+    _SFGP_Frame frame;
+    _SFGP_ReadFrame(&frame, _SFGP_GetRingSlot(ring, tail), 1, 0);
+    __atomic_store_n(&header->tail, tail + 1, __ATOMIC_RELEASE);
+
+    *read = 1;
+    if (!_SFGP_IsFrameValid(&frame))
+        return _SFGP_SetError(SFGP_ERROR_MALFORMED_FRAME);
+
+    _SFGP_ApplyFrame(pad, &frame);
+    return SFGP_ERROR_OK;
+}
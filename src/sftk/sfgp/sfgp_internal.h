@@ -4,6 +4,14 @@
 #define __SFTK_SFGP_INTERNAL_HEADER__
 
 
+// The library defines the out of line queries itself, so it only takes the
+// layout and inline queries, not the macros redirecting to them.
+#define SFGP_INLINE_NO_REDIRECT
+#include <sftk/sfgp_inline.h>
+
+#include <string.h>
+
+
 // ============================================================================
 //
 //      Error:
@@ -22,66 +30,462 @@ extern SFGP_Error _SFGP_SetError(SFGP_Error code);
 
 // ============================================================================
 //
-//      Button:
+//      Trigger:
 //      Procedures handling extra button functionality for single buttons.
 //      
 // ============================================================================
 
 
 /**
- * @brief Update button values.
+ * @brief Update trigger values.
  * 
- * updates button members according to \p value supplied to function. .last
- * will be set to .current, and .current will be set to \p value.
+ * updates trigger members according to \p value supplied to function. .last
+ * will be set to .current, and .current will be set to \p value. Velocity and
+ * acceleration are derived from the change over \p dt, and held as they are
+ * when \p dt is not positive (first or repeated frame). Acceleration stays 0
+ * until two rates in a row were taken.
  * 
- * @param[in]   self: The button whos values to set.
- * @param[in]   value: Value to set current button state to.
+ * @param[in]   self: The trigger whos values to set.
+ * @param[in]   value: Value to set current trigger state to.
+ * @param[in]   dt: Seconds between the frames of .current and \p value.
+ */
+extern void _SFGP_SetTrigger(SFGP_Trigger *const self, float value, float dt);
+
+/**
+ * @brief Updates max and min latches of trigger \p self out of .current.
+ *
+ * A latch is set once the value reaches \p press in magnitude and only
+ * cleared once it falls below \p release, so a value resting near the
+ * threshold does not flicker. With both at 1 this is a plain `>= 1.0f`.
+ *
+ * @param[in]   self: Trigger or joystick axis to update.
+ * @param[in]   press: Magnitude setting a latch, in (0, 1].
+ * @param[in]   release: Magnitude below which a latch clears, <= \p press.
  */
-extern void _SFGP_SetButton(SFGP_Button *const self, int8_t value);
+extern void _SFGP_LatchTrigger(SFGP_Trigger *const self, float press,
+        float release);
 
 
 // ============================================================================
 //
-//      Trigger:
-//      Procedures handling extra button functionality for single buttons.
+//      Joystick:
+//      Procedures handling extra Joystick functionality.
+//      
+// ============================================================================
+
+
+extern void _SFGP_SetJoystick(SFGP_Joystick *const self, 
+        float curr_x, float curr_y, float dt);
+
+
+// ============================================================================
+//
+//      Frame:
+//      Layout of the gamepad data array.
 //      
 // ============================================================================
 
 
+#define _SFGP_FRAME_ID_OFFSET           0   /**< int32 gamepad ID.       */
+#define _SFGP_FRAME_TIMESTAMP_OFFSET    4   /**< int64 timestamp.        */
+#define _SFGP_FRAME_AXES_OFFSET         12  /**< float per SFGP_AxisIndex. */
+#define _SFGP_FRAME_BUTTONS_OFFSET      36  /**< uint32 button bits.     */
+
+_Static_assert(_SFGP_FRAME_BUTTONS_OFFSET + sizeof (uint32_t) == SFGP_FRAME_SIZE,
+        "SFGP_FRAME_SIZE does not match frame layout");
+
+
 /**
- * @brief Data required to perform checks on an individual trigger.
- * 
- * @note Placed in sfgp_internal.h as joystick objects reference trigger 
- * members.
+ * @brief Every field a gamepad data array can carry, decoded.
+ *
+ * Fields missing from older payload versions are left zeroed.
+ */
+typedef struct _SFGP_Frame {
+    int64_t timestamp;
+    int32_t id;
+    float axes[SFGP_AXIS_ELEM];
+    uint32_t buttons;
+
+    float touchpad[SFGP_FINGER_ELEM][2];  /**< x, y per finger */
+    uint8_t user;                                   /**< version 2 */
+    uint8_t legacy_type;                            /**< version 3 */
+    uint8_t type;                                   /**< version 4 */
+    uint8_t version;
+} _SFGP_Frame;
+
+
+static inline uint32_t _SFGP_Load32(const uint8_t *const src,
+        const int big_endian) {
+    if (big_endian) {
+        return ((uint32_t) src[0] << 24) | ((uint32_t) src[1] << 16)
+            | ((uint32_t) src[2] << 8) | (uint32_t) src[3];
+    }
+
+    uint32_t value;
+    memcpy(&value, src, sizeof (value));
+    return value;
+}
+
+static inline uint64_t _SFGP_Load64(const uint8_t *const src,
+        const int big_endian) {
+    if (big_endian) {
+        return ((uint64_t) _SFGP_Load32(src, 1) << 32)
+            | (uint64_t) _SFGP_Load32(src + 4, 1);
+    }
+
+    uint64_t value;
+    memcpy(&value, src, sizeof (value));
+    return value;
+}
+
+static inline float _SFGP_LoadFloat(const uint8_t *const src,
+        const int big_endian) {
+    const uint32_t bits = _SFGP_Load32(src, big_endian);
+    float value;
+    memcpy(&value, &bits, sizeof (value));
+    return value;
+}
+
+
+/**
+ * @brief Reads gamepad data array \p body into \p frame.
+ *
+ * Meant to be called with constant \p version and \p big_endian so that
+ * every check on them folds away, leaving one straight line decoder per
+ * payload version.
+ *
+ * @param[out]  frame: Decoded frame.
+ * @param[in]   body: Gamepad data array, starting at the gamepad ID. Must hold
+ *              every field of \p version.
+ * @param[in]   version: SDK payload version of \p body.
+ * @param[in]   big_endian: Whether \p body was written by a Java
+ *              `ByteBuffer` rather than in host byte order.
+ */
+static inline void _SFGP_ReadFrame(_SFGP_Frame *const frame,
+        const uint8_t *const body, const int version, const int big_endian) {
+    memset(frame, 0, sizeof (*frame));
+    frame->version = (uint8_t) version;
+
+    frame->id = (int32_t) _SFGP_Load32(&body[_SFGP_FRAME_ID_OFFSET], big_endian);
+    frame->timestamp = (int64_t)
+        _SFGP_Load64(&body[_SFGP_FRAME_TIMESTAMP_OFFSET], big_endian);
+
+    for (int i = 0; i < SFGP_AXIS_ELEM; ++i) {
+        frame->axes[i] = _SFGP_LoadFloat(
+                &body[_SFGP_FRAME_AXES_OFFSET + (sizeof (float) * i)],
+                big_endian);
+    }
+
+    frame->buttons = _SFGP_Load32(&body[_SFGP_FRAME_BUTTONS_OFFSET], big_endian)
+        & _SFGP_BUTTON_MASK_ALL;
+
+    size_t offset = SFGP_FRAME_SIZE;
+    if (version >= 2) frame->user = body[offset++];
+    if (version >= 3) frame->legacy_type = body[offset++];
+    if (version >= 4) frame->type = body[offset++];
+
+    if (version >= 5) {
+        for (int i = 0; i < SFGP_FINGER_ELEM; ++i) {
+            frame->touchpad[i][0] = _SFGP_LoadFloat(&body[offset], big_endian);
+            frame->touchpad[i][1] = _SFGP_LoadFloat(&body[offset + 4], big_endian);
+            offset += 8;
+        }
+    }
+}
+
+
+// ============================================================================
+//
+//      Gamepad:
+//      Structure containing all necessary buttons for driver input.
+//      
+// ============================================================================
+
+
+_Static_assert(sizeof (SFGP_GamepadState) <= sizeof (SFGP_GamepadStorage),
+        "SFGP_GAMEPAD_STORAGE_SIZE too small for SFGP_GamepadState");
+_Static_assert(offsetof(SFGP_GamepadState, triggers)
+        == offsetof(SFGP_GamepadState, axes[SFGP_AXIS_LEFT_TRIGGER]),
+        "SFGP_GamepadState axes do not line up with joysticks and triggers");
+_Static_assert(offsetof(SFGP_GamepadState, buttons) + SFGP_BUTTON_ELEM
+        <= 3 * 64,
+        "SFGP_GamepadState query fields spill past three cache lines");
+
+
+/**
+ * @brief Update button masks.
+ *
+ * .buttons_last will be set to .buttons_current, and .buttons_current will be
+ * set to \p mask.
+ *
+ * @param[in]   self: The state whos buttons to set.
+ * @param[in]   mask: Button bits exactly as found in the gamepad byte array.
+ */
+static inline void _SFGP_SetButtons(SFGP_GamepadState *const self,
+        uint32_t mask) {
+    self->buttons_last = self->buttons_current;
+    self->buttons_current = mask & _SFGP_BUTTON_MASK_ALL;
+}
+
+/**
+ * @brief Returns @ref SFGP_ButtonIndex of the lowest bit set in \p bits,
+ * which must not be 0.
+ */
+static inline int _SFGP_GetMaskIndex(uint32_t bits) {
+    return SFGP_BUTTON_ELEM - 1 - __builtin_ctz(bits);
+}
+
+/**
+ * @brief Returns home slot of \p key within a table of \p slot_count slots,
+ * a power of two of at least 2.
+ *
+ * Multiplying carries every key bit upward, so the slot is taken from the
+ * top bits. The bottom ones only depend on as many low bits of \p key, which
+ * would leave single button masks all sharing slot 0.
+ */
+static inline uint32_t _SFGP_HashSlot(uint32_t key, uint32_t slot_count) {
+    return (key * UINT32_C(0x9E3779B1)) >> (32 - __builtin_ctz(slot_count));
+}
+
+
+/**
+ * @brief Whether every axis of \p frame is within range, NaN included.
+ *
+ * Evaluated without branching on any single axis.
+ */
+extern int _SFGP_IsFrameValid(const _SFGP_Frame *const frame);
+
+/**
+ * @brief Moves \p frame into \p pad, shifting current values to last.
+ *
+ * Does nothing if \p frame is the one \p pad was last updated from, and
+ * bumps the generation of \p pad otherwise.
  */
-struct SFGP_Trigger {
-    float last;     /**< Last known value of trigger. */
-    float current;  /**< Latest known value of trigger. */
+extern void _SFGP_ApplyFrame(SFGP_Gamepad *const pad,
+        const _SFGP_Frame *const frame);
+
+
+// ============================================================================
+//
+//      Event:
+//      
+// ============================================================================
+
+
+/**
+ * @brief Appends every edge of the frame just applied to \p state to \p self.
+ */
+extern void _SFGP_EmitEvents(SFGP_EventBuffer *const self,
+        const SFGP_GamepadState *const state);
+
+
+// ============================================================================
+//
+//      Record:
+//      
+// ============================================================================
+
+
+#define _SFGP_RECORD_MAGIC      "SFGPREC"
+#define _SFGP_RECORD_VERSION    1
+
+
+/**
+ * @brief Header found at the start of every recording file.
+ */
+typedef struct _SFGP_RecordHeader {
+    char magic[8];          /**< _SFGP_RECORD_MAGIC, null terminated. */
+    uint32_t version;       /**< _SFGP_RECORD_VERSION */
+    uint32_t header_size;   /**< sizeof (_SFGP_RecordHeader) */
+    uint64_t count;         /**< Number of frames, 0 until closed. */
+    uint64_t index_offset;  /**< Offset of index, 0 until closed. */
+} _SFGP_RecordHeader;
+
+/**
+ * @brief Header preceding every frame.
+ */
+typedef struct _SFGP_FrameHeader {
+    uint32_t length;        /**< Length of frame data in bytes. */
+    uint32_t reserved;
+} _SFGP_FrameHeader;
+
+
+/**
+ * @brief Returns \p length rounded up to the next multiple of 8.
+ */
+static inline uint64_t _SFGP_Pad8(uint64_t length) {
+    return (length + 7u) & ~(uint64_t) 7u;
+}
+
+
+// ============================================================================
+//
+//      History:
+//      
+// ============================================================================
+
+
+/**
+ * @brief Appends the frame just applied to \p state to \p self.
+ */
+extern void _SFGP_UpdateHistory(SFGP_History *const self,
+        const SFGP_GamepadState *const state);
+
+
+// ============================================================================
+//
+//      Matcher:
+//      
+// ============================================================================
+
+
+/**
+ * @brief Pattern as registered, before compilation.
+ */
+typedef struct _SFGP_Pattern {
+    int64_t tolerance;  /**< Chord tolerance or max gap between steps. */
+    uint32_t id;
+    uint32_t mask;      /**< Chord mask, or index of first step. */
+    uint32_t length;    /**< Number of steps, 0 for chords. */
+} _SFGP_Pattern;
+
+/**
+ * @brief Open addressing slot mapping an exact button mask to a value.
+ *
+ * Mask 0 marks an empty slot, it is never a valid pattern mask.
+ */
+typedef struct _SFGP_MaskSlot {
+    uint32_t mask;
+    uint32_t value;     /**< Chord group start, or sequence symbol. */
+    uint32_t count;     /**< Chords in group. */
+} _SFGP_MaskSlot;
+
+/**
+ * @brief Tables built by @ref SFGP_CompileMatcher(), swapped in as a whole.
+ */
+typedef struct _SFGP_MatcherTables {
+    _SFGP_MaskSlot *chords;         /**< Exact held mask to chord group. */
+    uint32_t *chord_patterns;       /**< Chord pattern indices by mask. */
+    uint32_t chord_slots;           /**< Power of 2. */
+
+    _SFGP_MaskSlot *symbols;        /**< Exact press mask to symbol. */
+    uint32_t symbol_slots;          /**< Power of 2. */
+    uint32_t symbol_count;
+
+    uint32_t *next;                 /**< Node * symbol_count + symbol. */
+    uint32_t *output_start;         /**< Per node, into outputs. */
+    uint32_t *outputs;              /**< Sequence pattern indices. */
+    uint32_t node_count;
+
+    int64_t max_gap;                /**< Largest gap of any sequence. */
+    int64_t *symbol_times;          /**< Ring of latest step timestamps. */
+    uint32_t max_length;            /**< Longest sequence, ring size. */
+
+    uint32_t *fired;                /**< IDs fired by newest frame. */
+} _SFGP_MatcherTables;
+
+struct SFGP_Matcher {
+    _SFGP_Pattern *patterns;
+    uint32_t pattern_count, pattern_capacity;
+    uint32_t *steps;
+    uint32_t step_count, step_capacity;
+
+    _SFGP_MatcherTables tables;
+
+    uint32_t node;                  /**< Current automaton node. */
+    uint32_t symbol_head;           /**< Next entry of .symbol_times. */
+    int64_t last_symbol;            /**< Timestamp of latest step. */
+    int64_t press_time[SFGP_BUTTON_ELEM];
+
+    size_t fired_count;
 };
 
 
 /**
- * @brief Update trigger values.
- * 
- * updates trigger members according to \p value supplied to function. .last
- * will be set to .current, and .current will be set to \p value.
- * 
- * @param[in]   self: The trigger whos values to set.
- * @param[in]   value: Value to set current trigger state to.
+ * @brief Advances \p self by the frame just applied to \p state.
  */
-extern void _SFGP_SetTrigger(SFGP_Trigger *const self, float value);
+extern void _SFGP_UpdateMatcher(SFGP_Matcher *const self,
+        const SFGP_GamepadState *const state);
 
 
 // ============================================================================
 //
-//      Joystick:
-//      Procedures handling extra Joystick functionality.
+//      Shaper:
 //      
 // ============================================================================
 
 
-extern void _SFGP_SetJoystick(SFGP_Joystick *const self, 
-        float curr_x, float curr_y);
+/**
+ * @brief Shapes every axis of \p raw into \p shaped.
+ *
+ * @param[in]   self: Shapes to apply.
+ * @param[in]   raw: Axis values by @ref SFGP_AxisIndex, in range.
+ * @param[out]  shaped: Shaped values by @ref SFGP_AxisIndex.
+ */
+extern void _SFGP_ShapeAxes(const SFGP_Shaper *const self,
+        const float raw[SFGP_AXIS_ELEM], float shaped[SFGP_AXIS_ELEM]);
+
+
+// ============================================================================
+//
+//      Filter:
+//      
+// ============================================================================
+
+
+/**
+ * @brief Filters \p axes and \p buttons of a frame stamped \p timestamp in
+ * place.
+ */
+extern void _SFGP_FilterFrame(SFGP_FilterBank *const self, int64_t timestamp,
+        float axes[SFGP_AXIS_ELEM], uint32_t *const buttons);
+
+
+// ============================================================================
+//
+//      Packed:
+//      
+// ============================================================================
+
+
+/**
+ * @brief Quantizes axis \p value to a multiple of 1 / SFGP_PACKED_AXIS_MAX,
+ * keeping 0 and +-1 thresholds exact.
+ */
+extern int16_t _SFGP_QuantizeAxis(float value);
+
+static inline float _SFGP_DequantizeAxis(int16_t value) {
+    return (float) value / SFGP_PACKED_AXIS_MAX;
+}
+
+
+// ============================================================================
+//
+//      Stats:
+//      
+// ============================================================================
+
+
+/**
+ * @brief Bucket of a @ref SFGP_Histogram counting \p value.
+ */
+extern size_t _SFGP_GetHistogramBucket(int64_t value);
+
+
+#ifdef SFGP_STATS
+
+/**
+ * @brief Nanoseconds on the monotonic clock.
+ */
+extern int64_t _SFGP_GetStatsTime(void);
+
+/**
+ * @brief Records \p frame into \p self, its decode having begun at \p start.
+ */
+extern void _SFGP_RecordStats(SFGP_Stats *const self,
+        const _SFGP_Frame *const frame, int64_t start);
+
+#endif // SFGP_STATS
 
 
 #endif // __SFTK_SFGP_INTERNAL_HEADER__
@@ -0,0 +1,98 @@
+/**
+ * @file shaper.c
+ * @brief Deadzones and response curves applied to analog axes during updates.
+ *
+ * Shapes are kept as one array per parameter, indexed by @ref SFGP_AxisIndex,
+ * so all six axes go through the same branch free arithmetic and the loops
+ * below vectorize.
+ */
+
+
+#include <sftk/sfgp.h>
+#include "sfgp_internal.h"
+
+#include <stdint.h>
+#include <stddef.h>
+#include <float.h>
+#include <math.h>
+#include <assert.h>
+
+
+void SFGP_InitShaper(SFGP_Shaper *const shaper) {
+    assert(shaper != NULL);
+
+    for (int i = 0; i < SFGP_AXIS_ELEM; ++i) {
+        shaper->deadzone[i] = 0.0f;
+        shaper->scale[i] = 1.0f;
+        shaper->expo[i] = 0.0f;
+        shaper->radial[i] = 0;
+    }
+}
+
+/**
+ * @brief Sets shape of axis \p index.
+ */
+static void _SFGP_SetAxisShape(SFGP_Shaper *const self, int index,
+        const SFGP_Shape *const shape, uint8_t radial) {
+    assert(shape != NULL);
+    assert(shape->deadzone >= 0.0f && shape->deadzone < shape->saturation);
+    assert(shape->saturation <= 1.0f);
+    assert(shape->expo >= 0.0f && shape->expo <= 1.0f);
+
+    self->deadzone[index] = shape->deadzone;
+    self->scale[index] = 1.0f / (shape->saturation - shape->deadzone);
+    self->expo[index] = shape->expo;
+    self->radial[index] = radial;
+}
+
+void SFGP_SetJoystickShape(SFGP_Shaper *const shaper,
+        SFGP_JoystickIndex stick, const SFGP_Shape *const shape) {
+    assert(shaper != NULL);
+    assert(stick < SFGP_JOYSTICK_ELEM);
+
+    const uint8_t radial = shape->radial != 0;
+    _SFGP_SetAxisShape(shaper, SFGP_AXIS_LEFT_X + (2 * stick), shape, radial);
+    _SFGP_SetAxisShape(shaper, SFGP_AXIS_LEFT_Y + (2 * stick), shape, radial);
+}
+
+void SFGP_SetTriggerShape(SFGP_Shaper *const shaper,
+        SFGP_TriggerIndex trigger, const SFGP_Shape *const shape) {
+    assert(shaper != NULL);
+    assert(trigger < SFGP_TRIGGER_ELEM);
+
+    _SFGP_SetAxisShape(shaper, SFGP_AXIS_LEFT_TRIGGER + trigger, shape, 0);
+}
+
+void SFGP_AttachShaper(SFGP_Gamepad *const pad,
+        const SFGP_Shaper *const shaper) {
+    assert(pad != NULL);
+    pad->shaper = shaper;
+}
+
+
+void _SFGP_ShapeAxes(const SFGP_Shaper *const self,
+        const float raw[SFGP_AXIS_ELEM], float shaped[SFGP_AXIS_ELEM]) {
+    // Magnitude fed to the curve: the axis itself, or its whole stick.
+    float input[SFGP_AXIS_ELEM];
+    for (int i = 0; i < SFGP_AXIS_ELEM; ++i) {
+        const int x = i & ~1, y = i | 1;
+        const float magnitude = sqrtf((raw[x] * raw[x]) + (raw[y] * raw[y]));
+
+        input[i] = (i < SFGP_AXIS_LEFT_TRIGGER && self->radial[i])
+            ? magnitude : fabsf(raw[i]);
+    }
+
+    for (int i = 0; i < SFGP_AXIS_ELEM; ++i) {
+        const float t = fminf(fmaxf(
+                (input[i] - self->deadzone[i]) * self->scale[i], 0.0f), 1.0f);
+        const float curve = t + (self->expo[i] * ((t * t * t) - t));
+
+        // Axial shapes keep the sign, so 0 and +-1 come out exact. Radial
+        // shapes scale the axis by the stick's response, which is exact at
+        // the ends as sqrtf(x * x) == fabsf(x).
+        const float axial = copysignf(curve, raw[i]);
+        const float radial = (raw[i] * curve) / fmaxf(input[i], FLT_MIN);
+
+        shaped[i] = self->radial[i] ? radial : axial;
+    }
+}
@@ -0,0 +1,77 @@
+/**
+ * @file shared.c
+ * @brief Handing gamepad state from one thread over to others without locks.
+ *
+ * Classic sequence lock: the sequence is odd while the producer is copying a
+ * new state in, and readers retry whenever it was odd or changed during their
+ * own copy. The state block is copied a word at a time with relaxed atomics
+ * so racing copies are merely discarded rather than undefined.
+ */
+
+
+#include <sftk/sfgp.h>
+#include "sfgp_internal.h"
+
+#include <stdint.h>
+#include <stddef.h>
+#include <assert.h>
+
+
+#define _SFGP_STORAGE_WORDS \
+    (sizeof (SFGP_GamepadStorage) / sizeof (uint64_t))
+
+
+void SFGP_InitSharedGamepad(SFGP_SharedGamepad *const shared) {
+    assert(shared != NULL);
+
+    SFGP_InitGamepadWithStorage(&shared->producer, &shared->producer_storage);
+    shared->published = shared->producer_storage;
+    shared->sequence = 0;
+}
+
+
+SFGP_Error SFGP_UpdateSharedGamepad(SFGP_SharedGamepad *const shared,
+        const uint8_t *const byte_array) {
+    assert(shared != NULL);
+
+    const uint32_t generation = SFGP_GetGamepadGeneration(&shared->producer);
+    const SFGP_Error error = SFGP_UpdateGamepad(&shared->producer, byte_array);
+
+    // Readers already hold this state.
+    if (SFGP_GetGamepadGeneration(&shared->producer) == generation)
+        return error;
+
+    const uint32_t sequence =
+        __atomic_load_n(&shared->sequence, __ATOMIC_RELAXED);
+    __atomic_store_n(&shared->sequence, sequence + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    for (size_t i = 0; i < _SFGP_STORAGE_WORDS; ++i) {
+        __atomic_store_n(&shared->published.words[i],
+                shared->producer_storage.words[i], __ATOMIC_RELAXED);
+    }
+
+    __atomic_store_n(&shared->sequence, sequence + 2, __ATOMIC_RELEASE);
+
+    return error;
+}
+
+
+void SFGP_ReadSharedGamepad(const SFGP_SharedGamepad *const shared,
+        SFGP_Gamepad *const dst) {
+    assert(shared != NULL);
+    assert(dst != NULL && dst->storage != NULL);
+
+    uint32_t before, after;
+    do {
+        before = __atomic_load_n(&shared->sequence, __ATOMIC_ACQUIRE);
+
+        for (size_t i = 0; i < _SFGP_STORAGE_WORDS; ++i) {
+            dst->storage->words[i] =
+                __atomic_load_n(&shared->published.words[i], __ATOMIC_RELAXED);
+        }
+
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        after = __atomic_load_n(&shared->sequence, __ATOMIC_RELAXED);
+    } while ((before & 1u) || before != after);
+}
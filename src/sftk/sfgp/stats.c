@@ -0,0 +1,170 @@
+/**
+ * @file stats.c
+ * @brief Counters and latency histograms of gamepad updates.
+ *
+ * Only the thread updating a gamepad writes its stats, so counters are bumped
+ * with plain arithmetic and stored with relaxed atomics. That is enough for
+ * other threads to read whole members without tearing, at no extra cost to
+ * the writer on any platform SFGP targets.
+ */
+
+
+#include <sftk/sfgp.h>
+#include "sfgp_internal.h"
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <time.h>
+#include <assert.h>
+
+
+_Static_assert(sizeof (SFGP_Stats) % sizeof (uint64_t) == 0,
+        "SFGP_Stats must consist of 64 bit members only");
+
+
+#define _SFGP_SUB_COUNT (1 << SFGP_HISTOGRAM_SUB_BITS)
+
+
+void SFGP_InitStats(SFGP_Stats *const stats) {
+    assert(stats != NULL);
+    memset(stats, 0, sizeof (*stats));
+}
+
+void SFGP_SetStatsInterval(SFGP_Stats *const stats, int64_t interval) {
+    assert(stats != NULL);
+    assert(interval >= 0);
+    stats->interval = interval;
+}
+
+SFGP_Error SFGP_AttachStats(SFGP_Gamepad *const pad,
+        SFGP_Stats *const stats) {
+    assert(pad != NULL);
+
+#ifdef SFGP_STATS
+    pad->stats = stats;
+    return SFGP_ERROR_OK;
+#else
+    (void) stats;
+    return _SFGP_SetError(SFGP_ERROR_UNSUPPORTED);
+#endif // SFGP_STATS
+}
+
+void SFGP_ReadStats(const SFGP_Stats *const stats,
+        SFGP_Stats *const snapshot) {
+    assert(stats != NULL);
+    assert(snapshot != NULL);
+
+    const uint64_t *const src = (const uint64_t *) stats;
+    uint64_t *const dst = (uint64_t *) snapshot;
+
+    for (size_t i = 0; i < sizeof (*stats) / sizeof (uint64_t); ++i)
+        dst[i] = __atomic_load_n(&src[i], __ATOMIC_RELAXED);
+}
+
+
+// ============================================================================
+//
+//      Histogram:
+//
+// ============================================================================
+
+
+int64_t SFGP_GetHistogramBucketValue(size_t bucket) {
+    assert(bucket < SFGP_HISTOGRAM_BUCKETS);
+
+    if (bucket < _SFGP_SUB_COUNT) return (int64_t) bucket;
+
+    const int shift = (int) (bucket >> SFGP_HISTOGRAM_SUB_BITS) - 1;
+    const int64_t sub = (int64_t) (bucket & (_SFGP_SUB_COUNT - 1));
+    return (_SFGP_SUB_COUNT + sub) << shift;
+}
+
+size_t _SFGP_GetHistogramBucket(int64_t value) {
+    if (value < _SFGP_SUB_COUNT) return (value > 0) ? (size_t) value : 0;
+
+    const int major = 63 - __builtin_clzll((uint64_t) value);
+    const int shift = major - SFGP_HISTOGRAM_SUB_BITS;
+    const size_t bucket = ((size_t) (shift + 1) << SFGP_HISTOGRAM_SUB_BITS)
+        + (size_t) ((value >> shift) & (_SFGP_SUB_COUNT - 1));
+
+    return (bucket < SFGP_HISTOGRAM_BUCKETS)
+        ? bucket : SFGP_HISTOGRAM_BUCKETS - 1;
+}
+
+int64_t SFGP_GetHistogramPercentile(const SFGP_Histogram *const histogram,
+        double percentile) {
+    assert(histogram != NULL);
+    assert(percentile >= 0.0 && percentile <= 100.0);
+
+    if (histogram->total == 0) return 0;
+
+    // Rank of the value sought, counting from 1.
+    uint64_t rank = (uint64_t) ((percentile / 100.0) * histogram->total);
+    if (rank == 0) rank = 1;
+
+    uint64_t seen = 0;
+    for (size_t i = 0; i < SFGP_HISTOGRAM_BUCKETS - 1; ++i) {
+        seen += histogram->counts[i];
+        if (seen < rank) continue;
+
+        const int64_t top = SFGP_GetHistogramBucketValue(i + 1) - 1;
+        return (top < histogram->max) ? top : histogram->max;
+    }
+
+    return histogram->max;
+}
+
+
+// ============================================================================
+//
+//      Recording:
+//
+// ============================================================================
+
+
+#ifdef SFGP_STATS
+
+/**
+ * @brief Adds \p delta to \p counter, which only the calling thread writes.
+ */
+static inline void _SFGP_Bump(uint64_t *const counter, uint64_t delta) {
+    __atomic_store_n(counter, *counter + delta, __ATOMIC_RELAXED);
+}
+
+static void _SFGP_RecordValue(SFGP_Histogram *const self, int64_t value) {
+    _SFGP_Bump(&self->counts[_SFGP_GetHistogramBucket(value)], 1);
+    _SFGP_Bump(&self->total, 1);
+
+    if (value > self->max)
+        __atomic_store_n(&self->max, value, __ATOMIC_RELAXED);
+}
+
+
+int64_t _SFGP_GetStatsTime(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((int64_t) now.tv_sec * 1000000000) + now.tv_nsec;
+}
+
+void _SFGP_RecordStats(SFGP_Stats *const self,
+        const _SFGP_Frame *const frame, int64_t start) {
+    const int64_t end = _SFGP_GetStatsTime();
+    const int64_t gap = frame->timestamp - self->timestamp;
+
+    if (self->frames > 0 && gap == 0) _SFGP_Bump(&self->duplicates, 1);
+
+    if (self->frames > 0 && self->interval > 0 && gap > 0) {
+        const int64_t intervals = (gap + (self->interval / 2)) / self->interval;
+        if (intervals > 1) _SFGP_Bump(&self->dropped, (uint64_t) intervals - 1);
+    }
+
+    __atomic_store_n(&self->timestamp, frame->timestamp, __ATOMIC_RELAXED);
+    _SFGP_Bump(&self->frames, 1);
+
+    const int64_t stamped = frame->timestamp * (1000000 / SFGP_TIMESTAMP_HZ);
+    _SFGP_RecordValue(&self->age, (end / 1000) - stamped);
+    _SFGP_RecordValue(&self->decode, end - start);
+}
+
+#endif // SFGP_STATS
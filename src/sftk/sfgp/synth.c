@@ -0,0 +1,186 @@
+/**
+ * @file synth.c
+ * @brief Scripted and seeded generation of gamepad data arrays.
+ *
+ * Randomness comes from xorshift64*, and random floats from its top 24 bits,
+ * so that output is exactly reproducible and costs a few instructions per
+ * value.
+ */
+
+
+#include <sftk/sfgp.h>
+#include "sfgp_internal.h"
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <math.h>
+#include <assert.h>
+
+
+/**
+ * @brief Script played when none is given, one endless random step.
+ */
+static const SFGP_SynthStep _SFGP_SYNTH_RANDOM_SCRIPT = {
+    .kind = SFGP_SYNTH_RANDOM,
+    .frames = UINT32_MAX,
+    .buttons = _SFGP_BUTTON_MASK_ALL,
+};
+
+
+void SFGP_InitSynth(SFGP_Synth *const synth,
+        const SFGP_SynthStep *const steps, size_t count, uint64_t seed) {
+    assert(synth != NULL);
+    assert(steps != NULL || count == 0);
+
+    memset(synth, 0, sizeof (*synth));
+    synth->steps = (count > 0) ? steps : &_SFGP_SYNTH_RANDOM_SCRIPT;
+    synth->count = (count > 0) ? count : 1;
+    synth->interval = 1;
+
+    // splitmix64 of the seed, as xorshift cannot start from 0.
+    uint64_t z = seed + UINT64_C(0x9E3779B97F4A7C15);
+    z = (z ^ (z >> 30)) * UINT64_C(0xBF58476D1CE4E5B9);
+    z = (z ^ (z >> 27)) * UINT64_C(0x94D049BB133111EB);
+    z ^= z >> 31;
+    synth->rng = (z != 0) ? z : 1;
+
+    for (size_t i = 0; i < count; ++i) {
+        const SFGP_SynthStep *step = &steps[i];
+        const float min = (step->axis >= SFGP_AXIS_LEFT_TRIGGER) ? 0.0f : -1.0f;
+
+        assert(step->kind <= SFGP_SYNTH_RANDOM);
+        assert(step->kind != SFGP_SYNTH_RAMP || (step->axis < SFGP_AXIS_ELEM
+                && step->from >= min && step->from <= 1.0f
+                && step->to >= min && step->to <= 1.0f));
+        assert(step->kind != SFGP_SYNTH_SWEEP
+                || step->axis < SFGP_JOYSTICK_ELEM);
+        (void) step;
+        (void) min;
+    }
+}
+
+void SFGP_SetSynthClock(SFGP_Synth *const synth, int64_t timestamp,
+        int64_t interval) {
+    assert(synth != NULL);
+    assert(interval > 0);
+
+    synth->timestamp = timestamp;
+    synth->interval = interval;
+}
+
+void SFGP_SetSynthId(SFGP_Synth *const synth, int32_t id) {
+    assert(synth != NULL);
+    synth->id = id;
+}
+
+
+static inline uint64_t _SFGP_NextRandom(SFGP_Synth *const self) {
+    uint64_t x = self->rng;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    self->rng = x;
+    return x * UINT64_C(0x2545F4914F6CDD1D);
+}
+
+/**
+ * @brief Returns random float in [0, 1].
+ */
+static inline float _SFGP_NextUnit(SFGP_Synth *const self) {
+    return (float) (_SFGP_NextRandom(self) >> 40) / (float) 0xFFFFFF;
+}
+
+/**
+ * @brief Returns how far along \p step frame \p frame is, 1 on its last.
+ */
+static inline float _SFGP_GetStepProgress(const SFGP_SynthStep *const step,
+        uint32_t frame) {
+    return (step->frames > 1) ? (float) frame / (float) (step->frames - 1)
+        : 1.0f;
+}
+
+/**
+ * @brief Applies frame \p frame of \p step to axes and buttons of \p self.
+ */
+static void _SFGP_PlayStep(SFGP_Synth *const self,
+        const SFGP_SynthStep *const step, uint32_t frame) {
+    const float t = _SFGP_GetStepProgress(step, frame);
+
+    switch (step->kind) {
+    case SFGP_SYNTH_HOLD:
+        self->buttons = step->buttons;
+        break;
+
+    case SFGP_SYNTH_RAMP:
+        // Written so that both ends come out exact.
+        self->axes[step->axis] = (t < 1.0f)
+            ? step->from + ((step->to - step->from) * t)
+            : step->to;
+        break;
+
+    case SFGP_SYNTH_SWEEP: {
+        const float turns = step->from + ((step->to - step->from) * t);
+        const float angle = turns * 6.28318530718f;
+        const int x = SFGP_AXIS_LEFT_X + (2 * step->axis);
+
+        self->axes[x] = fminf(fmaxf(cosf(angle), -1.0f), 1.0f);
+        self->axes[x + 1] = fminf(fmaxf(sinf(angle), -1.0f), 1.0f);
+        break;
+    }
+
+    case SFGP_SYNTH_MASH:
+        self->buttons = (uint32_t) (_SFGP_NextRandom(self) >> 32)
+            & step->buttons;
+        break;
+
+    case SFGP_SYNTH_RANDOM:
+        for (int i = 0; i < SFGP_AXIS_ELEM; ++i) {
+            const float unit = _SFGP_NextUnit(self);
+            self->axes[i] = (i < SFGP_AXIS_LEFT_TRIGGER)
+                ? (2.0f * unit) - 1.0f : unit;
+        }
+        self->buttons = (uint32_t) (_SFGP_NextRandom(self) >> 32)
+            & step->buttons;
+        break;
+    }
+}
+
+/**
+ * @brief Writes latest state of \p self as a frame into \p dst.
+ */
+static inline void _SFGP_WriteFrame(const SFGP_Synth *const self,
+        uint8_t *const dst) {
+    memcpy(&dst[_SFGP_FRAME_ID_OFFSET], &self->id, sizeof (self->id));
+    memcpy(&dst[_SFGP_FRAME_TIMESTAMP_OFFSET], &self->timestamp,
+            sizeof (self->timestamp));
+    memcpy(&dst[_SFGP_FRAME_AXES_OFFSET], self->axes, sizeof (self->axes));
+    memcpy(&dst[_SFGP_FRAME_BUTTONS_OFFSET], &self->buttons,
+            sizeof (self->buttons));
+}
+
+size_t SFGP_SynthesizeFrames(SFGP_Synth *const synth, uint8_t *const frames,
+        size_t stride, size_t count) {
+    assert(synth != NULL);
+    assert(frames != NULL || count == 0);
+    assert(stride >= SFGP_FRAME_SIZE);
+
+    size_t written = 0;
+    while (written < count && synth->step < synth->count) {
+        const SFGP_SynthStep *const step = &synth->steps[synth->step];
+
+        if (synth->frame >= step->frames) {
+            if (step != &_SFGP_SYNTH_RANDOM_SCRIPT) ++synth->step;
+            synth->frame = 0;
+            continue;
+        }
+
+        _SFGP_PlayStep(synth, step, synth->frame++);
+        _SFGP_WriteFrame(synth, &frames[written * stride]);
+
+        synth->timestamp += synth->interval;
+        ++written;
+    }
+
+    return written;
+}
@@ -6,42 +6,75 @@
 #include <assert.h>
 
 
-void _SFGP_SetTrigger(SFGP_Trigger *const self, float value) {
+void _SFGP_SetTrigger(SFGP_Trigger *const self, float value, float dt) {
     assert(self != NULL);
     assert(value <= 1.0f);  // No check for >= 0.0f as this function is accessed
                             // when setting joystick members.
 
     self->last = self->current;
     self->current = value;
+
+    // Acceleration needs two rates in a row, a frame without a positive dt
+    // breaks the chain and the next rate only starts a new one.
+    if (dt > 0.0f) {
+        const float velocity = (self->current - self->last) / dt;
+        self->acceleration = self->has_rate
+            ? (velocity - self->velocity) / dt
+            : 0.0f;
+        self->velocity = velocity;
+        self->has_rate = 1;
+    } else {
+        self->has_rate = 0;
+    }
 }
 
 
-int8_t SFGP_IsTriggerPressed(const SFGP_Trigger *const self) {
+void _SFGP_LatchTrigger(SFGP_Trigger *const self, float press,
+        float release) {
     assert(self != NULL);
-    return self->current >= 1.0f;
+
+    const uint8_t last = self->flags;
+    const float value = self->current;
+
+    const uint8_t at_max = (value >= press)
+        || ((last & _SFGP_AXIS_AT_MAX) && value >= release);
+    const uint8_t at_min = (value <= -press)
+        || ((last & _SFGP_AXIS_AT_MIN) && value <= -release);
+
+    self->flags = (uint8_t) (((last & 0x3) << _SFGP_AXIS_LAST_SHIFT)
+            | (at_max ? _SFGP_AXIS_AT_MAX : 0)
+            | (at_min ? _SFGP_AXIS_AT_MIN : 0));
+}
+
+
+int8_t SFGP_IsTriggerPressed(const SFGP_Trigger *const self) {
+    return _SFGP_InlineIsTriggerPressed(self);
 }
 
 int8_t SFGP_IsTriggerJustPressed(const SFGP_Trigger *const self) {
-    assert(self != NULL);
-    return self->current >= 1.0f && self->last < 1.0f;
+    return _SFGP_InlineIsTriggerJustPressed(self);
 }
 
 int8_t SFGP_IsTriggerReleased(const SFGP_Trigger *const self) {
-    assert(self != NULL);
-    return self->current <= 0.0f;
+    return _SFGP_InlineIsTriggerReleased(self);
 }
 
 int8_t SFGP_IsTriggerJustReleased(const SFGP_Trigger *const self) {
-    assert(self != NULL);
-    return self->current <= 0.0f && self->last > 0.0f;
+    return _SFGP_InlineIsTriggerJustReleased(self);
 }
 
 float SFGP_GetTriggerValue(const SFGP_Trigger *const self) {
-    assert(self != NULL);
-    return self->current;
+    return _SFGP_InlineGetTriggerValue(self);
+}
+
+float SFGP_GetTriggerRawValue(const SFGP_Trigger *const self) {
+    return _SFGP_InlineGetTriggerRawValue(self);
 }
 
 float SFGP_GetTriggerVelocity(const SFGP_Trigger *const self) {
-    assert(self != NULL);
-    return self->current - self->last;
-}
\ No newline at end of file
+    return _SFGP_InlineGetTriggerVelocity(self);
+}
+
+float SFGP_GetTriggerAcceleration(const SFGP_Trigger *const self) {
+    return _SFGP_InlineGetTriggerAcceleration(self);
+}
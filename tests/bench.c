@@ -0,0 +1,412 @@
+/**
+ * @file bench.c
+ * @brief Benchmarks for SFGP decode and query hot paths.
+ *
+ * Every benchmark runs against synthetic gamepad data arrays and prints a
+ * single line of JSON to stdout:
+ *
+ *     {"bench": "update_sustained", "iterations": 4194304,
+ *      "ns_per_op": 3.12, "ops_per_sec": 320512820.5}
+ *
+ * Usage: `bench [name-prefix] [iteration-scale]`. Without arguments every
+ * benchmark runs once at scale 1.
+ *
+ * Built with `SFGP_BENCH_INLINE` defined, queries go through
+ * sftk/sfgp_inline.h instead of the exported functions, and their results
+ * are reported with an `_inline` suffix.
+ */
+
+
+#include <sftk/sfgp.h>
+
+#ifdef SFGP_BENCH_INLINE
+    #include <sftk/sfgp_inline.h>
+    #define QUERY_SUFFIX "_inline"
+#else
+    #define QUERY_SUFFIX ""
+#endif // SFGP_BENCH_INLINE
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+
+/**
+ * @brief Keeps results of benchmarked queries alive.
+ */
+static volatile uint32_t sink;
+
+/**
+ * @brief Makes the compiler assume memory behind \p ptr changed, so inlined
+ * queries are redone every round rather than hoisted out of the loop.
+ */
+#define CLOBBER(ptr) __asm__ volatile ("" : : "r" (ptr) : "memory")
+
+
+// ============================================================================
+//
+//      Helpers:
+//
+// ============================================================================
+
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t) ts.tv_sec * 1000000000u) + (uint64_t) ts.tv_nsec;
+}
+
+static uint64_t xorshift64(uint64_t *state) {
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return *state = x;
+}
+
+/**
+ * @brief Returns uniformly distributed float in [lo, hi].
+ */
+static float random_axis(uint64_t *state, float lo, float hi) {
+    const float unit = (float) (xorshift64(state) >> 40) / (float) (1u << 24);
+    float value = lo + ((hi - lo) * unit);
+    // Make the thresholds actually get hit every now and then.
+    if ((xorshift64(state) & 7) == 0) value = (xorshift64(state) & 1) ? hi : lo;
+    return value;
+}
+
+/**
+ * @brief Fills \p frames with \p count synthetic gamepad data arrays.
+ *
+ * Timestamps increase by 5ms per frame, roughly the rate the SDK delivers
+ * gamepad updates at.
+ */
+static void generate_frames(uint8_t *frames, size_t count, uint64_t seed) {
+    uint64_t state = seed | 1;
+    int64_t timestamp = 1000;
+
+    for (size_t i = 0; i < count; ++i) {
+        uint8_t *frame = frames + (SFGP_FRAME_SIZE * i);
+        const int32_t id = 1;
+
+        memcpy(&frame[0], &id, sizeof (id));
+        memcpy(&frame[4], &timestamp, sizeof (timestamp));
+        timestamp += 5;
+
+        for (int a = 0; a < SFGP_AXIS_ELEM; ++a) {
+            const float lo = (a < SFGP_AXIS_LEFT_TRIGGER) ? -1.0f : 0.0f;
+            const float value = random_axis(&state, lo, 1.0f);
+            memcpy(&frame[12 + (sizeof (float) * a)], &value, sizeof (value));
+        }
+
+        const uint32_t buttons = (uint32_t) xorshift64(&state)
+            & ((UINT32_C(1) << SFGP_BUTTON_ELEM) - 1);
+        memcpy(&frame[36], &buttons, sizeof (buttons));
+    }
+}
+
+static void report(const char *name, uint64_t iterations, uint64_t elapsed) {
+    const double ns = (double) elapsed / (double) iterations;
+    printf("{\"bench\": \"%s\", \"iterations\": %llu, \"ns_per_op\": %.3f, "
+            "\"ops_per_sec\": %.1f}\n", name, (unsigned long long) iterations,
+            ns, (ns > 0.0) ? 1e9 / ns : 0.0);
+    fflush(stdout);
+}
+
+static int compare_u64(const void *a, const void *b) {
+    const uint64_t x = *(const uint64_t *) a, y = *(const uint64_t *) b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief Reports median and 99th percentile latency out of per-operation
+ * samples, with \p overhead of the clock itself removed.
+ */
+static void report_latency(const char *name, uint64_t *samples, size_t count,
+        uint64_t overhead) {
+    qsort(samples, count, sizeof (*samples), compare_u64);
+
+    const double p50 = (double) samples[count / 2] - (double) overhead;
+    const double p99 = (double) samples[(count * 99) / 100] - (double) overhead;
+    printf("{\"bench\": \"%s\", \"iterations\": %zu, \"ns_per_op\": %.1f, "
+            "\"p99_ns\": %.1f, \"ops_per_sec\": %.1f}\n", name, count,
+            (p50 > 0.0) ? p50 : 0.0, (p99 > 0.0) ? p99 : 0.0,
+            (p50 > 0.0) ? 1e9 / p50 : 0.0);
+    fflush(stdout);
+}
+
+
+// ============================================================================
+//
+//      Benchmarks:
+//
+// ============================================================================
+
+
+#define FRAME_COUNT 4096
+
+
+static uint8_t frames[FRAME_COUNT * SFGP_FRAME_SIZE];
+
+
+static void bench_init(uint64_t scale) {
+    const uint64_t n = 1000000 * scale;
+    SFGP_Gamepad pad;
+
+    uint64_t start = now_ns();
+    for (uint64_t i = 0; i < n; ++i) {
+        SFGP_InitGamepad(&pad);
+        sink += SFGP_GetButtonsPressed(&pad);
+        SFGP_DeinitGamepad(&pad);
+    }
+    report("init_deinit", n, now_ns() - start);
+
+    static SFGP_GamepadStorage storage;
+    start = now_ns();
+    for (uint64_t i = 0; i < n; ++i) {
+        SFGP_InitGamepadWithStorage(&pad, &storage);
+        sink += SFGP_GetButtonsPressed(&pad);
+        SFGP_DeinitGamepad(&pad);
+    }
+    report("init_with_storage", n, now_ns() - start);
+}
+
+static void bench_update(uint64_t scale) {
+    SFGP_Gamepad pad;
+    SFGP_InitGamepad(&pad);
+
+    // Single frame latency, each update timed on its own.
+    const size_t samples_n = 100000;
+    uint64_t *samples = malloc(sizeof (*samples) * samples_n);
+    if (samples == NULL) return;
+
+    uint64_t overhead = UINT64_MAX;
+    for (int i = 0; i < 1000; ++i) {
+        const uint64_t a = now_ns(), b = now_ns();
+        if (b - a < overhead) overhead = b - a;
+    }
+
+    for (size_t i = 0; i < samples_n; ++i) {
+        const uint8_t *frame = &frames[(i % FRAME_COUNT) * SFGP_FRAME_SIZE];
+        const uint64_t start = now_ns();
+        SFGP_UpdateGamepad(&pad, frame);
+        samples[i] = now_ns() - start;
+    }
+    report_latency("update_latency", samples, samples_n, overhead);
+    free(samples);
+
+    // Sustained throughput over a stream of frames.
+    const uint64_t n = (uint64_t) FRAME_COUNT * 1024 * scale;
+    const uint64_t start = now_ns();
+    for (uint64_t i = 0; i < n; ++i)
+        SFGP_UpdateGamepad(&pad, &frames[(i % FRAME_COUNT) * SFGP_FRAME_SIZE]);
+    sink += SFGP_GetButtonsPressed(&pad);
+    report("update_sustained", n, now_ns() - start);
+
+    // The same frame handed over every loop, as the SDK mostly does.
+    const uint64_t repeat_start = now_ns();
+    for (uint64_t i = 0; i < n; ++i) SFGP_UpdateGamepad(&pad, frames);
+    sink += SFGP_GetGamepadGeneration(&pad);
+    report("update_duplicate", n, now_ns() - repeat_start);
+
+    SFGP_DeinitGamepad(&pad);
+}
+
+static void bench_batch(uint64_t scale) {
+    static const struct {
+        SFGP_BatchKernel kernel;
+        const char *name;
+    } kernels[] = {
+        { SFGP_BATCH_KERNEL_SCALAR, "batch_scalar" },
+        { SFGP_BATCH_KERNEL_SSE2, "batch_sse2" },
+        { SFGP_BATCH_KERNEL_AVX2, "batch_avx2" },
+    };
+
+    static float axes[SFGP_AXIS_ELEM][FRAME_COUNT];
+    static int64_t timestamps[FRAME_COUNT];
+    static uint32_t buttons[FRAME_COUNT], pressed[FRAME_COUNT],
+                    released[FRAME_COUNT];
+
+    SFGP_FrameBatch batch = {
+        .timestamps = timestamps,
+        .buttons = buttons,
+        .just_pressed = pressed,
+        .just_released = released,
+    };
+    for (int a = 0; a < SFGP_AXIS_ELEM; ++a) batch.axes[a] = axes[a];
+
+    const uint64_t rounds = 1024 * scale;
+    for (size_t k = 0; k < sizeof (kernels) / sizeof (*kernels); ++k) {
+        // Skip kernels the CPU falls back from, they were already measured.
+        if (SFGP_SetBatchKernel(kernels[k].kernel) != kernels[k].kernel)
+            continue;
+
+        const uint64_t start = now_ns();
+        for (uint64_t r = 0; r < rounds; ++r)
+            SFGP_DecodeFrames(frames, SFGP_FRAME_SIZE, FRAME_COUNT, 0x0, &batch);
+        sink += buttons[FRAME_COUNT - 1];
+        report(kernels[k].name, rounds * FRAME_COUNT, now_ns() - start);
+    }
+
+    SFGP_SetBatchKernel(SFGP_BATCH_KERNEL_AUTO);
+}
+
+static void bench_query(uint64_t scale) {
+    SFGP_Gamepad pad;
+    SFGP_InitGamepad(&pad);
+
+    const uint64_t n = 1000000 * scale;
+    uint64_t start, elapsed;
+    uint32_t acc = 0;
+
+    // Every query is repeated over each control of its kind, 1024 rounds
+    // per frame to amortize the clock. Frames are updated outside of the
+    // timed region, and the pad clobbered each round so both builds load it.
+#define TIMED_QUERIES(name, per_frame, body)                                   \
+    elapsed = 0;                                                               \
+    for (uint64_t i = 0; i < n; i += 1024 * (per_frame)) {                     \
+        SFGP_UpdateGamepad(&pad,                                               \
+                &frames[((i / 1024) % FRAME_COUNT) * SFGP_FRAME_SIZE]);        \
+        start = now_ns();                                                      \
+        for (int r = 0; r < 1024; ++r) { CLOBBER(&pad); body }                 \
+        elapsed += now_ns() - start;                                           \
+    }                                                                          \
+    sink += acc;                                                               \
+    report(name QUERY_SUFFIX, n, elapsed);
+
+    TIMED_QUERIES("query_button", SFGP_BUTTON_ELEM,
+        for (int b = 0; b < SFGP_BUTTON_ELEM; ++b)
+            acc += SFGP_IsButtonJustPressed(pad.buttons[b]);
+    )
+
+    TIMED_QUERIES("query_button_mask", 1,
+        acc += SFGP_GetButtonsJustPressed(&pad);
+    )
+
+    TIMED_QUERIES("query_trigger", SFGP_TRIGGER_ELEM * 2,
+        for (int t = 0; t < SFGP_TRIGGER_ELEM; ++t) {
+            acc += SFGP_IsTriggerJustPressed(pad.triggers[t]);
+            acc += (uint32_t) SFGP_GetTriggerValue(pad.triggers[t]);
+        }
+    )
+
+    TIMED_QUERIES("query_joystick", SFGP_JOYSTICK_ELEM * 4,
+        for (int j = 0; j < SFGP_JOYSTICK_ELEM; ++j) {
+            acc += SFGP_IsXJustAtMax(pad.joysticks[j]);
+            acc += SFGP_IsYJustAtMin(pad.joysticks[j]);
+            acc += (uint32_t) SFGP_GetXValue(pad.joysticks[j]);
+            acc += (uint32_t) SFGP_GetYValue(pad.joysticks[j]);
+        }
+    )
+
+#undef TIMED_QUERIES
+
+    SFGP_DeinitGamepad(&pad);
+}
+
+
+static void bench_synth(uint64_t scale) {
+    static uint8_t out[FRAME_COUNT * SFGP_FRAME_SIZE];
+
+    SFGP_Synth synth;
+    SFGP_InitSynth(&synth, NULL, 0, 0x5F69u);
+
+    const uint64_t rounds = 256 * scale;
+    const uint64_t start = now_ns();
+    for (uint64_t r = 0; r < rounds; ++r)
+        SFGP_SynthesizeFrames(&synth, out, SFGP_FRAME_SIZE, FRAME_COUNT);
+    sink += out[SFGP_FRAME_SIZE - 1];
+    report("synth_random", rounds * FRAME_COUNT, now_ns() - start);
+}
+
+static void bench_analytics(uint64_t scale) {
+    enum { FILES = 16, ROUNDS = 64 };
+    char paths[FILES][32];
+    const char *path_list[FILES];
+
+    // Recordings of the benchmark frames, written to the working directory.
+    for (int f = 0; f < FILES; ++f) {
+        snprintf(paths[f], sizeof (paths[f]), "bench_analytics_%d.rec", f);
+        path_list[f] = paths[f];
+
+        SFGP_Recorder rec;
+        if (SFGP_OpenRecorder(&rec, paths[f]) != SFGP_ERROR_OK) {
+            fprintf(stderr, "bench: cannot write %s\n", paths[f]);
+            return;
+        }
+
+        for (int r = 0; r < ROUNDS; ++r) {
+            for (size_t i = 0; i < FRAME_COUNT; ++i) {
+                SFGP_RecordFrame(&rec, &frames[i * SFGP_FRAME_SIZE],
+                        SFGP_FRAME_SIZE);
+            }
+        }
+
+        SFGP_CloseRecorder(&rec);
+    }
+
+    SFGP_AnalyticsConfig config;
+    SFGP_InitAnalyticsConfig(&config);
+
+    static const uint32_t threads[] = { 1, 0 };
+    for (size_t t = 0; t < sizeof (threads) / sizeof (*threads); ++t) {
+        config.threads = threads[t];
+
+        SFGP_Analytics analytics;
+        SFGP_InitAnalytics(&analytics);
+
+        const uint64_t start = now_ns();
+        for (uint64_t r = 0; r < scale; ++r)
+            SFGP_AnalyzeFiles(&analytics, path_list, FILES, &config);
+        sink += (uint32_t) analytics.frames;
+
+        report(threads[t] == 1 ? "analytics_serial" : "analytics_parallel",
+                analytics.frames, now_ns() - start);
+    }
+
+    for (int f = 0; f < FILES; ++f) remove(paths[f]);
+}
+
+
+// ============================================================================
+//
+//      Main:
+//
+// ============================================================================
+
+
+static const struct {
+    const char *name;
+    void (*run)(uint64_t scale);
+} benchmarks[] = {
+    { "init", bench_init },
+    { "update", bench_update },
+    { "batch", bench_batch },
+    { "query", bench_query },
+    { "synth", bench_synth },
+    { "analytics", bench_analytics },
+};
+
+
+int main(int argc, char **argv) {
+    const char *filter = (argc > 1) ? argv[1] : "";
+    const uint64_t scale = (argc > 2) ? strtoull(argv[2], NULL, 10) : 1;
+
+    generate_frames(frames, FRAME_COUNT, 0x5F69u);
+
+    int ran = 0;
+    for (size_t i = 0; i < sizeof (benchmarks) / sizeof (*benchmarks); ++i) {
+        if (strncmp(benchmarks[i].name, filter, strlen(filter)) != 0) continue;
+        benchmarks[i].run(scale > 0 ? scale : 1);
+        ran = 1;
+    }
+
+    if (!ran) {
+        fprintf(stderr, "bench: no benchmark matching '%s'\n", filter);
+        return 1;
+    }
+
+    return 0;
+}
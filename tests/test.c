@@ -0,0 +1,2372 @@
+/**
+ * @file test.c
+ * @brief Checks of guarantees the SFGP API documents.
+ *
+ * Usage: `sfgp_test [name-prefix]`. Without arguments every test runs. Each
+ * test prints a line per failed check to stderr, and the exit status is
+ * non-zero if any check failed.
+ */
+
+
+#include <sftk/sfgp.h>
+#include "sfgp_internal.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+
+static int failures;
+
+#define CHECK(cond, ...)                                                       \
+    do {                                                                       \
+        if (!(cond)) {                                                         \
+            fprintf(stderr, "%s:%d: ", __FILE__, __LINE__);                    \
+            fprintf(stderr, __VA_ARGS__);                                      \
+            fputc('\n', stderr);                                               \
+            ++failures;                                                        \
+        }                                                                      \
+    } while (0)
+
+
+
+// ============================================================================
+//
+//      Helpers:
+//
+// ============================================================================
+
+
+static uint64_t xorshift64(uint64_t *state) {
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return *state = x;
+}
+
+/**
+ * @brief Fills in a gamepad data array of @ref SFGP_FRAME_SIZE bytes.
+ */
+static void write_frame(uint8_t *frame, int32_t id, int64_t timestamp,
+        const float *axes, uint32_t buttons) {
+    memcpy(&frame[0], &id, sizeof (id));
+    memcpy(&frame[4], &timestamp, sizeof (timestamp));
+    memcpy(&frame[12], axes, sizeof (float) * SFGP_AXIS_ELEM);
+    memcpy(&frame[36], &buttons, sizeof (buttons));
+}
+
+
+// ============================================================================
+//
+//      Mask:
+//
+// ============================================================================
+
+
+/**
+ * @brief Updates \p pad from an otherwise zeroed frame holding \p buttons.
+ *
+ * Every frame gets a new timestamp, as frames from the SDK do.
+ */
+static void update_buttons(SFGP_Gamepad *pad, uint32_t buttons) {
+    static int64_t timestamp;
+    ++timestamp;
+
+    // The button word is the last field of the 40 byte data array.
+    uint8_t frame[40] = { 0 };
+    memcpy(&frame[4], &timestamp, sizeof (timestamp));
+    memcpy(&frame[36], &buttons, sizeof (buttons));
+    SFGP_UpdateGamepad(pad, frame);
+}
+
+static void test_mask(void) {
+    const uint32_t all = (UINT32_C(1) << SFGP_BUTTON_ELEM) - 1;
+
+    // The first button takes the highest bit, as in the data array.
+    CHECK(SFGP_BUTTON_MASK(SFGP_TOUCHPAD_FINGER_1)
+            == UINT32_C(1) << (SFGP_BUTTON_ELEM - 1),
+            "mask: first button is 0x%x", SFGP_BUTTON_MASK(0));
+    CHECK(SFGP_BUTTON_MASK(SFGP_BUTTON_BUMPER_RIGHT) == 1,
+            "mask: last button is 0x%x",
+            SFGP_BUTTON_MASK(SFGP_BUTTON_BUMPER_RIGHT));
+
+    SFGP_Gamepad pad;
+    if (SFGP_InitGamepad(&pad) != SFGP_ERROR_OK) {
+        CHECK(0, "mask: cannot allocate gamepad");
+        return;
+    }
+
+    CHECK(SFGP_GetButtonsPressed(&pad) == 0
+            && SFGP_GetButtonsJustPressed(&pad) == 0
+            && SFGP_GetButtonsJustReleased(&pad) == 0,
+            "mask: fresh gamepad has buttons held");
+
+    // Every single button, checked against its handle.
+    for (int i = 0; i < SFGP_BUTTON_ELEM; ++i) {
+        const uint32_t mask = SFGP_BUTTON_MASK(i);
+        update_buttons(&pad, mask);
+
+        CHECK(SFGP_GetButtonsPressed(&pad) == mask,
+                "mask: button %d pressed 0x%x", i,
+                SFGP_GetButtonsPressed(&pad));
+        CHECK(SFGP_GetButtonsJustPressed(&pad) == mask,
+                "mask: button %d just pressed 0x%x", i,
+                SFGP_GetButtonsJustPressed(&pad));
+        CHECK(SFGP_GetButtonsJustReleased(&pad)
+                == ((i > 0) ? SFGP_BUTTON_MASK(i - 1) : 0),
+                "mask: button %d just released 0x%x", i,
+                SFGP_GetButtonsJustReleased(&pad));
+
+        for (int j = 0; j < SFGP_BUTTON_ELEM; ++j) {
+            CHECK(SFGP_IsButtonPressed(pad.buttons[j]) == (i == j)
+                    && SFGP_IsButtonJustPressed(pad.buttons[j]) == (i == j),
+                    "mask: button %d handle disagrees with mask 0x%x", j,
+                    mask);
+        }
+    }
+
+    // Bits past the last button are dropped.
+    update_buttons(&pad, UINT32_MAX);
+    CHECK(SFGP_GetButtonsPressed(&pad) == all,
+            "mask: all held 0x%x", SFGP_GetButtonsPressed(&pad));
+    CHECK(SFGP_GetButtonsJustPressed(&pad) == (all & ~SFGP_BUTTON_MASK(
+                    SFGP_BUTTON_ELEM - 1)),
+            "mask: all just pressed 0x%x", SFGP_GetButtonsJustPressed(&pad));
+
+    // Holding on is no edge, letting go is one for every button.
+    update_buttons(&pad, all);
+    CHECK(SFGP_GetButtonsJustPressed(&pad) == 0
+            && SFGP_GetButtonsJustReleased(&pad) == 0,
+            "mask: held buttons reported an edge");
+
+    update_buttons(&pad, 0);
+    CHECK(SFGP_GetButtonsPressed(&pad) == 0
+            && SFGP_GetButtonsJustReleased(&pad) == all,
+            "mask: all released 0x%x", SFGP_GetButtonsJustReleased(&pad));
+    for (int j = 0; j < SFGP_BUTTON_ELEM; ++j) {
+        CHECK(SFGP_IsButtonReleased(pad.buttons[j])
+                && SFGP_IsButtonJustReleased(pad.buttons[j]),
+                "mask: button %d handle not released", j);
+    }
+
+    SFGP_DeinitGamepad(&pad);
+    printf("mask: %d buttons checked\n", SFGP_BUTTON_ELEM);
+}
+
+
+// ============================================================================
+//
+//      Batch:
+//
+// ============================================================================
+
+
+#define BATCH_MAX 1031
+
+/**
+ * @brief Fills a frame with random bits, so axes cover NaNs, infinities and
+ * subnormals alongside regular values.
+ */
+static void random_frame(uint8_t *frame, size_t stride, uint64_t *state) {
+    for (size_t i = 0; i < stride; ++i)
+        frame[i] = (uint8_t) xorshift64(state);
+
+    // Every so often a valid axis value instead, and exact edges.
+    for (int a = 0; a < SFGP_AXIS_ELEM; ++a) {
+        const uint64_t r = xorshift64(state);
+        if ((r & 3) == 0) continue;
+
+        float value = (float) (r >> 40) / (float) (1u << 23) - 1.0f;
+        if ((r & 12) == 0) value = (r & 16) ? 1.0f : -1.0f;
+        memcpy(&frame[12 + (sizeof (float) * a)], &value, sizeof (value));
+    }
+}
+
+typedef struct BatchOut {
+    float axes[SFGP_AXIS_ELEM][BATCH_MAX];
+    int64_t timestamps[BATCH_MAX];
+    uint32_t buttons[BATCH_MAX];
+    uint32_t just_pressed[BATCH_MAX];
+    uint32_t just_released[BATCH_MAX];
+} BatchOut;
+
+static SFGP_FrameBatch batch_of(BatchOut *out) {
+    SFGP_FrameBatch batch = {
+        .timestamps = out->timestamps,
+        .buttons = out->buttons,
+        .just_pressed = out->just_pressed,
+        .just_released = out->just_released,
+    };
+    for (int a = 0; a < SFGP_AXIS_ELEM; ++a) batch.axes[a] = out->axes[a];
+    return batch;
+}
+
+/**
+ * @brief Decodes with \p kernel, both per gamepad and as a single stream.
+ */
+static void decode_with(SFGP_BatchKernel kernel, const uint8_t *frames,
+        size_t stride, size_t count, uint32_t previous,
+        const uint32_t *buttons, BatchOut *stream, BatchOut *gamepads) {
+    SFGP_SetBatchKernel(kernel);
+
+    memset(stream, 0xA5, sizeof (*stream));
+    const SFGP_FrameBatch stream_batch = batch_of(stream);
+    SFGP_DecodeFrames(frames, stride, count, previous, &stream_batch);
+
+    memset(gamepads, 0xA5, sizeof (*gamepads));
+    memcpy(gamepads->buttons, buttons, sizeof (gamepads->buttons));
+    const SFGP_FrameBatch gamepad_batch = batch_of(gamepads);
+    SFGP_DecodeGamepadFrames(frames, stride, count, &gamepad_batch);
+}
+
+static void test_batch(void) {
+    static const size_t strides[] = { 40, 44, 48, 64 };
+    static const size_t counts[] = { 0, 1, 3, 4, 5, 7, 8, 9, 15, 17, 33,
+                                     BATCH_MAX };
+    static const SFGP_BatchKernel kernels[] = { SFGP_BATCH_KERNEL_SSE2,
+                                                SFGP_BATCH_KERNEL_AVX2 };
+    static const char *const names[] = { "sse2", "avx2" };
+
+    static uint8_t frames[BATCH_MAX * 64];
+    static uint32_t buttons[BATCH_MAX];
+    static BatchOut expected_stream, expected_gamepads, stream, gamepads;
+
+    uint64_t state = 0x5F69u;
+    int tested = 0;
+
+    for (size_t k = 0; k < sizeof (kernels) / sizeof (*kernels); ++k) {
+        if (SFGP_SetBatchKernel(kernels[k]) != kernels[k]) {
+            printf("batch: %s not supported, skipped\n", names[k]);
+            continue;
+        }
+        ++tested;
+
+        for (size_t s = 0; s < sizeof (strides) / sizeof (*strides); ++s) {
+            for (size_t c = 0; c < sizeof (counts) / sizeof (*counts); ++c) {
+                const size_t stride = strides[s], count = counts[c];
+
+                for (size_t i = 0; i < count; ++i) {
+                    random_frame(&frames[stride * i], stride, &state);
+                    buttons[i] = (uint32_t) xorshift64(&state);
+                }
+                const uint32_t previous = (uint32_t) xorshift64(&state);
+
+                decode_with(SFGP_BATCH_KERNEL_SCALAR, frames, stride, count,
+                        previous, buttons, &expected_stream,
+                        &expected_gamepads);
+                decode_with(kernels[k], frames, stride, count, previous,
+                        buttons, &stream, &gamepads);
+
+                // Bitwise, so NaNs have to match too.
+                CHECK(memcmp(&stream, &expected_stream, sizeof (stream)) == 0,
+                        "batch: %s frames differ from scalar, stride %zu, "
+                        "count %zu", names[k], stride, count);
+                CHECK(memcmp(&gamepads, &expected_gamepads,
+                            sizeof (gamepads)) == 0,
+                        "batch: %s gamepad frames differ from scalar, "
+                        "stride %zu, count %zu", names[k], stride, count);
+            }
+        }
+    }
+
+    SFGP_SetBatchKernel(SFGP_BATCH_KERNEL_AUTO);
+    printf("batch: %d kernels checked against scalar\n", tested);
+}
+
+
+// ============================================================================
+//
+//      Events:
+//
+// ============================================================================
+
+
+static void test_events(void) {
+    const uint32_t ab = SFGP_BUTTON_MASK(SFGP_BUTTON_A)
+            | SFGP_BUTTON_MASK(SFGP_BUTTON_B);
+    const float pushed[SFGP_AXIS_ELEM] = { [SFGP_AXIS_LEFT_X] = 1.0f,
+                                           [SFGP_AXIS_RIGHT_TRIGGER] = 0.5f };
+    const float centered[SFGP_AXIS_ELEM] = { 0 };
+
+    uint8_t press[SFGP_FRAME_SIZE], release[SFGP_FRAME_SIZE];
+    write_frame(press, 1, 10, pushed, ab);
+    write_frame(release, 1, 20, centered, 0);
+
+    SFGP_Gamepad pad;
+    if (SFGP_InitGamepad(&pad) != SFGP_ERROR_OK) {
+        CHECK(0, "events: cannot allocate gamepad");
+        return;
+    }
+
+    // Buttons come first, in index order, then axes.
+    SFGP_Event events[SFGP_MAX_EVENTS];
+    size_t count = 0;
+    CHECK(SFGP_UpdateGamepadEvents(&pad, press, events, SFGP_MAX_EVENTS,
+                &count) == SFGP_ERROR_OK, "events: press failed");
+    CHECK(count == 3, "events: press gave %zu events", count);
+    if (count == 3) {
+        CHECK(events[0].edge == SFGP_EVENT_BUTTON_PRESSED
+                && events[0].control == SFGP_BUTTON_A
+                && events[0].value == 1.0f && events[0].timestamp == 10,
+                "events: first event is %d of control %d", events[0].edge,
+                events[0].control);
+        CHECK(events[1].edge == SFGP_EVENT_BUTTON_PRESSED
+                && events[1].control == SFGP_BUTTON_B,
+                "events: second event is %d of control %d", events[1].edge,
+                events[1].control);
+        CHECK(events[2].edge == SFGP_EVENT_AXIS_AT_MAX
+                && events[2].control == SFGP_AXIS_LEFT_X
+                && events[2].value == 1.0f,
+                "events: third event is %d of control %d", events[2].edge,
+                events[2].control);
+    }
+
+    // The same frame again has nothing left to report.
+    CHECK(SFGP_UpdateGamepadEvents(&pad, press, events, SFGP_MAX_EVENTS,
+                &count) == SFGP_ERROR_OK && count == 0,
+            "events: repeated frame gave %zu events", count);
+
+    // Four events into room for two keeps the first two.
+    CHECK(SFGP_UpdateGamepadEvents(&pad, release, events, 2, &count)
+            == SFGP_ERROR_EVENTS_TRUNCATED,
+            "events: overflow not reported");
+    CHECK(count == 2 && events[0].edge == SFGP_EVENT_BUTTON_RELEASED
+            && events[0].control == SFGP_BUTTON_A
+            && events[1].control == SFGP_BUTTON_B,
+            "events: truncated to %zu events", count);
+    CHECK(SFGP_GetButtonsPressed(&pad) == 0,
+            "events: truncation dropped the update");
+
+    // An attached buffer fills from the plain update and gathers across
+    // updates until cleared.
+    SFGP_Gamepad attached;
+    if (SFGP_InitGamepad(&attached) != SFGP_ERROR_OK) {
+        CHECK(0, "events: cannot allocate gamepad");
+        SFGP_DeinitGamepad(&pad);
+        return;
+    }
+
+    SFGP_EventBuffer buffer;
+    SFGP_InitEventBuffer(&buffer, events, SFGP_MAX_EVENTS);
+    SFGP_AttachEventBuffer(&attached, &buffer);
+
+    SFGP_UpdateGamepad(&attached, press);
+    CHECK(buffer.count == 3 && !buffer.truncated,
+            "events: attached buffer holds %zu events", buffer.count);
+    SFGP_UpdateGamepad(&attached, press);
+    CHECK(buffer.count == 3,
+            "events: repeated frame added to attached buffer");
+    SFGP_UpdateGamepad(&attached, release);
+    CHECK(buffer.count == 7 && events[3].edge == SFGP_EVENT_BUTTON_RELEASED,
+            "events: attached buffer holds %zu events", buffer.count);
+
+    SFGP_InitEventBuffer(&buffer, events, 1);
+    SFGP_UpdateGamepad(&attached, press);
+    CHECK(buffer.count == 1 && buffer.truncated,
+            "events: small attached buffer not flagged");
+    SFGP_ClearEventBuffer(&buffer);
+    CHECK(buffer.count == 0 && !buffer.truncated,
+            "events: clear left %zu events", buffer.count);
+
+    // Detached again, updates leave the buffer alone.
+    SFGP_AttachEventBuffer(&attached, NULL);
+    SFGP_UpdateGamepad(&attached, release);
+    CHECK(buffer.count == 0, "events: detached buffer still filled");
+
+    SFGP_DeinitGamepad(&attached);
+    SFGP_DeinitGamepad(&pad);
+    printf("events: order, truncation and attached buffer checked\n");
+}
+
+
+// ============================================================================
+//
+//      Shared:
+//
+// ============================================================================
+
+
+#define SHARED_FRAMES 200000
+
+/**
+ * @brief Buttons that go with \p timestamp, so a torn copy shows.
+ */
+static uint32_t shared_buttons(int64_t timestamp) {
+    return ((uint32_t) timestamp * UINT32_C(2654435761))
+        & ((UINT32_C(1) << SFGP_BUTTON_ELEM) - 1);
+}
+
+static void *shared_producer(void *arg) {
+    SFGP_SharedGamepad *shared = arg;
+    const float axes[SFGP_AXIS_ELEM] = { 0 };
+
+    uint8_t frame[SFGP_FRAME_SIZE];
+    for (int64_t i = 1; i <= SHARED_FRAMES; ++i) {
+        write_frame(frame, 1, i, axes, shared_buttons(i));
+        SFGP_UpdateSharedGamepad(shared, frame);
+    }
+
+    // Errors stay with the thread that raised them.
+    SFGP_Event event;
+    size_t count;
+    write_frame(frame, 1, SHARED_FRAMES + 1, axes, 0);
+    SFGP_UpdateGamepadEvents(&shared->producer, frame, &event, 0, &count);
+
+    return NULL;
+}
+
+static void test_shared(void) {
+    static SFGP_SharedGamepad shared;
+    SFGP_InitSharedGamepad(&shared);
+
+    // Starts from a clean error state, whatever ran before.
+    (void) SFGP_GetError();
+
+    SFGP_Gamepad pad;
+    if (SFGP_InitGamepad(&pad) != SFGP_ERROR_OK) {
+        CHECK(0, "shared: cannot allocate gamepad");
+        return;
+    }
+
+    pthread_t producer;
+    if (pthread_create(&producer, NULL, shared_producer, &shared) != 0) {
+        CHECK(0, "shared: cannot start producer");
+        SFGP_DeinitGamepad(&pad);
+        return;
+    }
+
+    // Every copy has to be a state the producer published, in order.
+    int64_t last = 0;
+    uint64_t reads = 0, torn = 0;
+    while (last < SHARED_FRAMES) {
+        SFGP_ReadSharedGamepad(&shared, &pad);
+        ++reads;
+
+        const int64_t timestamp = SFGP_GetGamepadTimestamp(&pad);
+        if (SFGP_GetButtonsPressed(&pad) != shared_buttons(timestamp))
+            ++torn;
+        CHECK(timestamp >= last, "shared: timestamp went back from %lld "
+                "to %lld", (long long) last, (long long) timestamp);
+        last = timestamp;
+    }
+
+    pthread_join(producer, NULL);
+
+    CHECK(torn == 0, "shared: %llu of %llu copies torn",
+            (unsigned long long) torn, (unsigned long long) reads);
+    CHECK(SFGP_GetError() == SFGP_ERROR_OK,
+            "shared: producer error leaked into reader thread");
+
+    SFGP_DeinitGamepad(&pad);
+    printf("shared: %llu copies checked\n", (unsigned long long) reads);
+}
+
+
+// ============================================================================
+//
+//      Record:
+//
+// ============================================================================
+
+
+#define RECORD_FRAMES 100
+#define RECORD_PATH "sfgp_test_record.bin"
+#define RECORD_COPY_PATH "sfgp_test_record_copy.bin"
+
+/**
+ * @brief Reads all of \p path into a new allocation, NULL on failure.
+ */
+static uint8_t *read_file(const char *path, size_t *size) {
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) return NULL;
+
+    uint8_t *data = NULL;
+    if (fseek(file, 0, SEEK_END) == 0) {
+        const long end = ftell(file);
+        if (end > 0 && fseek(file, 0, SEEK_SET) == 0) {
+            data = malloc((size_t) end);
+            if (data != NULL
+                    && fread(data, 1, (size_t) end, file) != (size_t) end) {
+                free(data);
+                data = NULL;
+            }
+            *size = (size_t) end;
+        }
+    }
+
+    fclose(file);
+    return data;
+}
+
+/**
+ * @brief Writes \p size bytes of \p data to \p path, replacing it.
+ */
+static int write_file(const char *path, const uint8_t *data, size_t size) {
+    FILE *file = fopen(path, "wb");
+    if (file == NULL) return 0;
+
+    const int written = fwrite(data, 1, size, file) == size;
+    return (fclose(file) == 0) && written;
+}
+
+/**
+ * @brief Opens \p size bytes of \p data as a replay, returning the error.
+ */
+static SFGP_Error open_copy(const uint8_t *data, size_t size,
+        SFGP_Replay *replay) {
+    if (!write_file(RECORD_COPY_PATH, data, size)) return SFGP_ERROR_IO;
+    return SFGP_OpenReplay(replay, RECORD_COPY_PATH);
+}
+
+static int record_callback(SFGP_Gamepad *pad, uint64_t frame, void *user) {
+    uint64_t *calls = user;
+    CHECK(SFGP_GetGamepadTimestamp(pad) == (int64_t) frame * 10,
+            "record: replayed frame %llu has timestamp %lld",
+            (unsigned long long) frame,
+            (long long) SFGP_GetGamepadTimestamp(pad));
+    CHECK(SFGP_GetButtonsPressed(pad) == (uint32_t) frame,
+            "record: replayed frame %llu has buttons 0x%x",
+            (unsigned long long) frame, SFGP_GetButtonsPressed(pad));
+
+    return ++*calls == RECORD_FRAMES / 2;
+}
+
+static void test_record(void) {
+    static uint8_t frames[RECORD_FRAMES][SFGP_FRAME_SIZE];
+    const float axes[SFGP_AXIS_ELEM] = { [SFGP_AXIS_LEFT_Y] = -0.5f };
+
+    SFGP_Recorder rec;
+    if (SFGP_OpenRecorder(&rec, RECORD_PATH) != SFGP_ERROR_OK) {
+        CHECK(0, "record: cannot open " RECORD_PATH);
+        return;
+    }
+    for (int i = 0; i < RECORD_FRAMES; ++i) {
+        write_frame(frames[i], 1, (int64_t) i * 10, axes, (uint32_t) i);
+        CHECK(SFGP_RecordFrame(&rec, frames[i], SFGP_FRAME_SIZE)
+                == SFGP_ERROR_OK, "record: cannot record frame %d", i);
+    }
+    CHECK(SFGP_CloseRecorder(&rec) == SFGP_ERROR_OK,
+            "record: cannot close recorder");
+
+    SFGP_Replay replay;
+    const SFGP_Error opened = SFGP_OpenReplay(&replay, RECORD_PATH);
+    if (opened == SFGP_ERROR_UNSUPPORTED) {
+        printf("record: replay not supported, skipped\n");
+        remove(RECORD_PATH);
+        return;
+    }
+    CHECK(opened == SFGP_ERROR_OK, "record: cannot open replay, %d", opened);
+    if (opened != SFGP_ERROR_OK) return;
+
+    // Every frame comes back as written.
+    CHECK(replay.count == RECORD_FRAMES, "record: replay has %llu frames",
+            (unsigned long long) replay.count);
+    for (uint64_t i = 0; i < replay.count && i < RECORD_FRAMES; ++i) {
+        size_t length = 0;
+        const uint8_t *frame = SFGP_GetReplayFrame(&replay, i, &length);
+        CHECK(length == SFGP_FRAME_SIZE
+                && memcmp(frame, frames[i], SFGP_FRAME_SIZE) == 0,
+                "record: frame %llu differs", (unsigned long long) i);
+    }
+
+    CHECK(SFGP_FindReplayFrame(&replay, -1) == 0
+            && SFGP_FindReplayFrame(&replay, 55) == 6
+            && SFGP_FindReplayFrame(&replay, 60) == 6
+            && SFGP_FindReplayFrame(&replay, 10 * RECORD_FRAMES)
+                == RECORD_FRAMES, "record: timestamp search is off");
+
+    SFGP_Gamepad pad;
+    if (SFGP_InitGamepad(&pad) != SFGP_ERROR_OK) {
+        CHECK(0, "record: cannot allocate gamepad");
+        SFGP_CloseReplay(&replay);
+        return;
+    }
+
+    // The callback stops the replay half way.
+    uint64_t calls = 0;
+    CHECK(SFGP_RunReplay(&replay, &pad, SFGP_REPLAY_UNTHROTTLED,
+                record_callback, &calls) == SFGP_ERROR_OK,
+            "record: replay failed");
+    CHECK(calls == RECORD_FRAMES / 2, "record: callback ran %llu times",
+            (unsigned long long) calls);
+    SFGP_CloseReplay(&replay);
+
+    size_t size = 0;
+    uint8_t *data = read_file(RECORD_PATH, &size);
+    if (data == NULL) {
+        CHECK(0, "record: cannot read " RECORD_PATH);
+        SFGP_DeinitGamepad(&pad);
+        return;
+    }
+
+    // Cut short anywhere, a closed recording no longer holds the index its
+    // header points at.
+    const size_t cuts[] = { 0, 8, 24, size / 2, size - 8, size - 1 };
+    for (size_t i = 0; i < sizeof (cuts) / sizeof (*cuts); ++i) {
+        const SFGP_Error error = open_copy(data, cuts[i], &replay);
+        CHECK(error == SFGP_ERROR_INVALID_FILE,
+                "record: truncated to %zu bytes opened with %d", cuts[i],
+                error);
+        if (error == SFGP_ERROR_OK) SFGP_CloseReplay(&replay);
+    }
+
+    uint8_t magic = data[0];
+    data[0] ^= 0xFF;
+    CHECK(open_copy(data, size, &replay) == SFGP_ERROR_INVALID_FILE,
+            "record: bad magic accepted");
+    data[0] = magic;
+
+    // Left unclosed, with its last frame torn, the index is rebuilt from
+    // the frames that made it to disk.
+    uint8_t header[32];
+    memcpy(header, data, sizeof (header));
+    memset(&data[16], 0, 16);
+    const size_t torn = size - (sizeof (uint64_t) * RECORD_FRAMES) - 4;
+    CHECK(open_copy(data, torn, &replay) == SFGP_ERROR_OK
+            && replay.count == RECORD_FRAMES - 1,
+            "record: unclosed recording has %llu frames",
+            (unsigned long long) replay.count);
+    SFGP_CloseReplay(&replay);
+    memcpy(data, header, sizeof (header));
+
+    // Files are not trusted, out of range axes end the replay.
+    const float bad = 2.0f;
+    size_t second = 0;
+    for (size_t i = sizeof (header); i + SFGP_FRAME_SIZE <= size; ++i) {
+        if (memcmp(&data[i], frames[1], SFGP_FRAME_SIZE) == 0) {
+            second = i;
+            break;
+        }
+    }
+    CHECK(second != 0, "record: second frame not found in file");
+    if (second != 0) {
+        memcpy(&data[second + 12], &bad, sizeof (bad));
+        CHECK(open_copy(data, size, &replay) == SFGP_ERROR_OK,
+                "record: cannot open altered copy");
+        CHECK(SFGP_RunReplay(&replay, &pad, SFGP_REPLAY_UNTHROTTLED, NULL,
+                    NULL) == SFGP_ERROR_INVALID_FILE,
+                "record: out of range axis replayed");
+        SFGP_CloseReplay(&replay);
+    }
+
+    free(data);
+    SFGP_DeinitGamepad(&pad);
+    remove(RECORD_PATH);
+    remove(RECORD_COPY_PATH);
+    printf("record: %d frames round tripped, %zu truncations rejected\n",
+            RECORD_FRAMES, sizeof (cuts) / sizeof (*cuts));
+}
+
+
+// ============================================================================
+//
+//      Payload:
+//
+// ============================================================================
+
+
+static void store_be(uint8_t *dst, uint64_t value, int bytes) {
+    for (int i = bytes - 1; i >= 0; --i) {
+        dst[i] = (uint8_t) value;
+        value >>= 8;
+    }
+}
+
+static void store_be_float(uint8_t *dst, float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof (bits));
+    store_be(dst, bits, 4);
+}
+
+/**
+ * @brief Fills in an SDK payload of \p version, returning its size.
+ */
+static size_t write_payload(uint8_t *payload, uint8_t version,
+        int64_t timestamp, const float *axes, uint32_t buttons) {
+    static const size_t sizes[] = { 0, 41, 42, 43, 44, 60 };
+
+    memset(payload, 0, SFGP_PAYLOAD_SIZE_MAX);
+    payload[0] = version;
+    store_be(&payload[1], 42, 4);
+    store_be(&payload[5], (uint64_t) timestamp, 8);
+    for (int a = 0; a < SFGP_AXIS_ELEM; ++a)
+        store_be_float(&payload[13 + (4 * a)], axes[a]);
+    store_be(&payload[37], buttons, 4);
+
+    payload[41] = 3;    // User.
+    payload[42] = 1;    // Legacy type.
+    payload[43] = 2;    // Type.
+    for (int i = 0; i < 4; ++i)
+        store_be_float(&payload[44 + (4 * i)], 0.125f * (float) (i + 1));
+
+    return (version < sizeof (sizes) / sizeof (*sizes)) ? sizes[version] : 0;
+}
+
+static void test_payload(void) {
+    const float axes[SFGP_AXIS_ELEM] = { 0.25f, -0.5f, 1.0f, -1.0f, 0.75f,
+                                         0.0f };
+    const uint32_t buttons = SFGP_BUTTON_MASK(SFGP_BUTTON_X)
+        | SFGP_BUTTON_MASK(SFGP_BUTTON_GUIDE);
+
+    SFGP_Gamepad pad;
+    if (SFGP_InitGamepad(&pad) != SFGP_ERROR_OK) {
+        CHECK(0, "payload: cannot allocate gamepad");
+        return;
+    }
+
+    SFGP_Event events[SFGP_MAX_EVENTS];
+    SFGP_EventBuffer buffer;
+    SFGP_InitEventBuffer(&buffer, events, SFGP_MAX_EVENTS);
+    SFGP_AttachEventBuffer(&pad, &buffer);
+
+    uint8_t payload[SFGP_PAYLOAD_SIZE_MAX + 4];
+    int64_t timestamp = 100, applied = 0;
+
+    for (uint8_t version = 1; version <= SFGP_PAYLOAD_VERSION_MAX; ++version) {
+        const size_t size = write_payload(payload, version, timestamp, axes,
+                buttons);
+
+        // Anything short of the full size leaves the pad alone.
+        for (size_t length = 0; length < size; ++length) {
+            const SFGP_Error error = SFGP_DecodeGamepad(&pad, payload, length);
+            CHECK(error == SFGP_ERROR_MALFORMED_FRAME,
+                    "payload: v%d of %zu bytes gave %d", version, length,
+                    error);
+        }
+        CHECK(SFGP_GetGamepadTimestamp(&pad) == applied,
+                "payload: short v%d payload was applied", version);
+
+        SFGP_ClearEventBuffer(&buffer);
+        CHECK(SFGP_DecodeGamepad(&pad, payload, size) == SFGP_ERROR_OK,
+                "payload: v%d of %zu bytes rejected", version, size);
+
+        CHECK(SFGP_GetGamepadVersion(&pad) == version
+                && SFGP_GetGamepadId(&pad) == 42
+                && SFGP_GetGamepadTimestamp(&pad) == timestamp,
+                "payload: v%d header read as v%d, id %d", version,
+                SFGP_GetGamepadVersion(&pad), SFGP_GetGamepadId(&pad));
+        CHECK(SFGP_GetButtonsPressed(&pad) == buttons,
+                "payload: v%d buttons 0x%x", version,
+                SFGP_GetButtonsPressed(&pad));
+        CHECK(SFGP_GetXValue(pad.left_stick) == 0.25f
+                && SFGP_GetYValue(pad.left_stick) == -0.5f
+                && SFGP_GetXValue(pad.right_stick) == 1.0f
+                && SFGP_GetYValue(pad.right_stick) == -1.0f
+                && SFGP_GetTriggerValue(pad.left_trigger) == 0.75f
+                && SFGP_GetTriggerValue(pad.right_trigger) == 0.0f,
+                "payload: v%d axes read wrong", version);
+
+        CHECK(SFGP_GetGamepadUser(&pad) == ((version >= 2) ? 3 : 0),
+                "payload: v%d user %d", version, SFGP_GetGamepadUser(&pad));
+        if (version >= 4) {
+            CHECK(SFGP_GetGamepadType(&pad) == 2,
+                    "payload: v%d type %d", version,
+                    SFGP_GetGamepadType(&pad));
+        }
+        CHECK(SFGP_GetTouchpadX(&pad, SFGP_FINGER_1)
+                    == ((version >= 5) ? 0.125f : 0.0f)
+                && SFGP_GetTouchpadY(&pad, SFGP_FINGER_2)
+                    == ((version >= 5) ? 0.5f : 0.0f),
+                "payload: v%d touchpad read wrong", version);
+
+        // Decoding is one more way in, and events come out of it too.
+        CHECK(buffer.count > 0, "payload: v%d decode emitted no events",
+                version);
+
+        // Trailing bytes belong to later versions and are ignored.
+        CHECK(SFGP_DecodeGamepad(&pad, payload, size + 4) == SFGP_ERROR_OK,
+                "payload: v%d with trailing bytes rejected", version);
+
+        // Back to rest, so the next version has edges to report.
+        const float rest[SFGP_AXIS_ELEM] = { 0 };
+        write_payload(payload, version, timestamp + 50, rest, 0);
+        SFGP_DecodeGamepad(&pad, payload, size);
+        applied = timestamp + 50;
+        timestamp += 100;
+    }
+
+    const int64_t before = SFGP_GetGamepadTimestamp(&pad);
+
+    // Unknown versions, at any length.
+    const uint8_t unknown[] = { 0, SFGP_PAYLOAD_VERSION_MAX + 1, 0xFF };
+    for (size_t i = 0; i < sizeof (unknown) / sizeof (*unknown); ++i) {
+        write_payload(payload, 1, timestamp, axes, buttons);
+        payload[0] = unknown[i];
+        CHECK(SFGP_DecodeGamepad(&pad, payload, SFGP_PAYLOAD_SIZE_MAX)
+                == SFGP_ERROR_UNSUPPORTED_VERSION
+                && SFGP_DecodeGamepad(&pad, payload, 1)
+                    == SFGP_ERROR_UNSUPPORTED_VERSION,
+                "payload: version %d accepted", unknown[i]);
+    }
+
+    // NaN and out of range axes, each on its own.
+    const float bad[] = { NAN, INFINITY, -INFINITY, 1.0001f, -1.0001f };
+    for (int a = 0; a < SFGP_AXIS_ELEM; ++a) {
+        for (size_t i = 0; i < sizeof (bad) / sizeof (*bad); ++i) {
+            float malformed[SFGP_AXIS_ELEM];
+            memcpy(malformed, axes, sizeof (malformed));
+            malformed[a] = bad[i];
+
+            const size_t size = write_payload(payload, 5, timestamp,
+                    malformed, buttons);
+            CHECK(SFGP_DecodeGamepad(&pad, payload, size)
+                    == SFGP_ERROR_MALFORMED_FRAME,
+                    "payload: axis %d of %g accepted", a, (double) bad[i]);
+        }
+
+        // Triggers do not go below zero.
+        if (a >= SFGP_AXIS_LEFT_TRIGGER) {
+            float malformed[SFGP_AXIS_ELEM];
+            memcpy(malformed, axes, sizeof (malformed));
+            malformed[a] = -0.5f;
+
+            const size_t size = write_payload(payload, 5, timestamp,
+                    malformed, buttons);
+            CHECK(SFGP_DecodeGamepad(&pad, payload, size)
+                    == SFGP_ERROR_MALFORMED_FRAME,
+                    "payload: negative trigger %d accepted", a);
+        }
+    }
+
+    CHECK(SFGP_GetGamepadTimestamp(&pad) == before
+            && SFGP_GetButtonsPressed(&pad) == 0,
+            "payload: rejected payload was applied");
+    const SFGP_Error error = SFGP_GetError();
+    CHECK(error == SFGP_ERROR_MALFORMED_FRAME, "payload: last error %d",
+            error);
+
+    SFGP_DeinitGamepad(&pad);
+    printf("payload: %d versions checked\n", SFGP_PAYLOAD_VERSION_MAX);
+}
+
+
+// ============================================================================
+//
+//      Rates:
+//
+// ============================================================================
+
+
+static int near(float value, float expected) {
+    const float scale = (fabsf(expected) > 1.0f) ? fabsf(expected) : 1.0f;
+    return fabsf(value - expected) <= 1e-3f * scale;
+}
+
+static void test_rates(void) {
+    // Left trigger and left stick x, by timestamp in ms. The fourth frame
+    // repeats the third timestamp, as when polled faster than frames arrive.
+    static const struct {
+        int64_t timestamp;
+        float trigger, x;
+        uint32_t buttons;
+        float velocity, acceleration;
+    } steps[] = {
+        { 0,   0.0f,  0.0f,  0, 0.0f, 0.0f },    // No previous frame.
+        { 100, 0.25f, 0.5f,  0, 2.5f, 0.0f },    // Only one rate so far.
+        { 200, 0.75f, 0.5f,  0, 5.0f, 25.0f },
+        { 200, 0.75f, 0.5f,  1, 5.0f, 25.0f },   // Rates kept.
+        { 300, 0.75f, 0.5f,  0, 0.0f, 0.0f },    // Chain starts over.
+        { 400, 1.0f,  0.5f,  0, 2.5f, 25.0f },
+        { 600, 0.5f,  0.5f,  0, -2.5f, -25.0f },
+    };
+
+    SFGP_Gamepad pad;
+    if (SFGP_InitGamepad(&pad) != SFGP_ERROR_OK) {
+        CHECK(0, "rates: cannot allocate gamepad");
+        return;
+    }
+
+    uint8_t frame[SFGP_FRAME_SIZE];
+    for (size_t i = 0; i < sizeof (steps) / sizeof (*steps); ++i) {
+        const float axes[SFGP_AXIS_ELEM] = {
+            [SFGP_AXIS_LEFT_X] = steps[i].x,
+            [SFGP_AXIS_LEFT_TRIGGER] = steps[i].trigger,
+        };
+        write_frame(frame, 1, steps[i].timestamp, axes, steps[i].buttons);
+        SFGP_UpdateGamepad(&pad, frame);
+
+        const float velocity = SFGP_GetTriggerVelocity(pad.left_trigger);
+        const float acceleration =
+            SFGP_GetTriggerAcceleration(pad.left_trigger);
+        CHECK(near(velocity, steps[i].velocity)
+                && near(acceleration, steps[i].acceleration),
+                "rates: step %zu trigger at %g/s and %g/s^2, expected %g/s "
+                "and %g/s^2", i, (double) velocity, (double) acceleration,
+                (double) steps[i].velocity, (double) steps[i].acceleration);
+    }
+
+    // Each stick axis only moves by its own value.
+    CHECK(near(SFGP_GetXVelocity(pad.left_stick), 0.0f)
+            && near(SFGP_GetYVelocity(pad.left_stick), 0.0f),
+            "rates: still stick moving at %g/s, %g/s",
+            (double) SFGP_GetXVelocity(pad.left_stick),
+            (double) SFGP_GetYVelocity(pad.left_stick));
+
+    const float axes[SFGP_AXIS_ELEM] = { [SFGP_AXIS_LEFT_X] = 0.5f,
+                                         [SFGP_AXIS_LEFT_Y] = -0.5f };
+    write_frame(frame, 1, 650, axes, 0);
+    SFGP_UpdateGamepad(&pad, frame);
+    CHECK(near(SFGP_GetXVelocity(pad.left_stick), 0.0f)
+            && near(SFGP_GetYVelocity(pad.left_stick), -10.0f)
+            && near(SFGP_GetYAcceleration(pad.left_stick), -200.0f),
+            "rates: stick at %g/s, %g/s and %g/s^2",
+            (double) SFGP_GetXVelocity(pad.left_stick),
+            (double) SFGP_GetYVelocity(pad.left_stick),
+            (double) SFGP_GetYAcceleration(pad.left_stick));
+
+    SFGP_DeinitGamepad(&pad);
+    printf("rates: %zu steps checked\n", sizeof (steps) / sizeof (*steps));
+}
+
+
+// ============================================================================
+//
+//      History:
+//
+// ============================================================================
+
+
+static void test_history(void) {
+    // Button A by timestamp, with the left trigger following along.
+    static const struct {
+        int64_t timestamp;
+        int8_t held;
+    } steps[] = {
+        { 0, 1 }, { 100, 0 }, { 200, 1 }, { 700, 1 }, { 800, 1 }, { 900, 0 },
+        { 1300, 1 }, { 1300, 1 }, { 1400, 1 }, { 1500, 0 }, { 1600, 0 },
+    };
+    const uint32_t a = SFGP_BUTTON_MASK(SFGP_BUTTON_A);
+
+    SFGP_Gamepad pad;
+    if (SFGP_InitGamepad(&pad) != SFGP_ERROR_OK) {
+        CHECK(0, "history: cannot allocate gamepad");
+        return;
+    }
+
+    SFGP_HistoryEntry entries[8];
+    SFGP_History history;
+    SFGP_InitHistory(&history, entries, sizeof (entries) / sizeof (*entries));
+    SFGP_AttachHistory(&pad, &history);
+
+    uint8_t frame[SFGP_FRAME_SIZE];
+    for (size_t i = 0; i < sizeof (steps) / sizeof (*steps); ++i) {
+        const float axes[SFGP_AXIS_ELEM] = {
+            [SFGP_AXIS_LEFT_TRIGGER] = (float) steps[i].timestamp / 2048.0f,
+        };
+        write_frame(frame, 1, steps[i].timestamp, axes, steps[i].held ? a : 0);
+        SFGP_UpdateGamepad(&pad, frame);
+
+        const int64_t now = steps[i].timestamp;
+        const int64_t held = SFGP_GetButtonHeldTime(&history, SFGP_BUTTON_A);
+        const uint32_t presses = SFGP_GetPressCount(&history, SFGP_BUTTON_A);
+
+        switch (now) {
+        case 0:
+            CHECK(held == 0 && presses == 1
+                    && SFGP_GetTimeSincePress(&history, SFGP_BUTTON_A) == 0
+                    && !SFGP_IsButtonDoubleTapped(&history, SFGP_BUTTON_A),
+                    "history: first press held %lld, %u presses",
+                    (long long) held, presses);
+            break;
+        case 200:
+            CHECK(presses == 2
+                    && SFGP_IsButtonDoubleTapped(&history, SFGP_BUTTON_A),
+                    "history: second press within 200 not a double tap");
+            break;
+        case 700:
+            CHECK(held == 500
+                    && SFGP_IsButtonLongPressed(&history, SFGP_BUTTON_A)
+                    && SFGP_IsButtonJustLongPressed(&history, SFGP_BUTTON_A)
+                    && !SFGP_IsButtonDoubleTapped(&history, SFGP_BUTTON_A),
+                    "history: held %lld without a long press",
+                    (long long) held);
+            break;
+        case 800:
+            CHECK(SFGP_IsButtonLongPressed(&history, SFGP_BUTTON_A)
+                    && !SFGP_IsButtonJustLongPressed(&history, SFGP_BUTTON_A)
+                    && SFGP_GetTimeSincePress(&history, SFGP_BUTTON_A) == 600,
+                    "history: long press reported twice");
+            break;
+        case 900:
+            CHECK(held == 0
+                    && !SFGP_IsButtonLongPressed(&history, SFGP_BUTTON_A),
+                    "history: released button held %lld", (long long) held);
+            break;
+        case 1300:
+            // The presses at 0 and 200 have left the window, repeating the
+            // frame counts nothing twice.
+            CHECK(presses == 1
+                    && !SFGP_IsButtonDoubleTapped(&history, SFGP_BUTTON_A),
+                    "history: %u presses within window at 1300", presses);
+            CHECK(SFGP_GetHistoryLength(&history) == 7,
+                    "history: %zu frames kept at 1300",
+                    SFGP_GetHistoryLength(&history));
+            break;
+        }
+    }
+
+    // Eleven updates of which ten had a new timestamp, into room for eight.
+    CHECK(SFGP_GetHistoryLength(&history) == 8,
+            "history: %zu frames kept", SFGP_GetHistoryLength(&history));
+    const SFGP_HistoryEntry *newest = SFGP_GetHistoryEntry(&history, 0);
+    const SFGP_HistoryEntry *oldest = SFGP_GetHistoryEntry(&history, 7);
+    CHECK(newest != NULL && newest->timestamp == 1600 && newest->buttons == 0
+            && newest->axes[SFGP_AXIS_LEFT_TRIGGER] == 1600.0f / 2048.0f,
+            "history: newest frame is off");
+    CHECK(oldest != NULL && oldest->timestamp == 200
+            && oldest->buttons == a && oldest->just_pressed == a,
+            "history: oldest frame is off");
+    CHECK(SFGP_GetHistoryEntry(&history, 8) == NULL,
+            "history: frame past capacity returned");
+
+    CHECK(SFGP_GetTimeSincePress(&history, SFGP_BUTTON_B) == -1
+            && SFGP_GetPressCount(&history, SFGP_BUTTON_B) == 0,
+            "history: button never pressed has presses");
+
+    SFGP_DeinitGamepad(&pad);
+    printf("history: %zu updates checked\n", sizeof (steps) / sizeof (*steps));
+}
+
+
+// ============================================================================
+//
+//      Matcher:
+//
+// ============================================================================
+
+
+#define MATCHER_PROBES_MAX 3
+
+enum {
+    MATCHER_CHORD_AB = 100,
+    MATCHER_UP_UP_DOWN = 200,
+    MATCHER_UP_DOWN = 201,
+};
+
+/**
+ * @brief Applies a frame holding \p buttons at \p timestamp.
+ */
+static void hold_buttons(SFGP_Gamepad *pad, int64_t timestamp,
+        uint32_t buttons) {
+    const float axes[SFGP_AXIS_ELEM] = { 0 };
+    uint8_t frame[SFGP_FRAME_SIZE];
+    write_frame(frame, 1, timestamp, axes, buttons);
+    SFGP_UpdateGamepad(pad, frame);
+}
+
+/**
+ * @brief Whether \p id is among the patterns fired by the newest frame.
+ */
+static int has_fired(const SFGP_Matcher *matcher, uint32_t id) {
+    size_t count = 0;
+    const uint32_t *matches = SFGP_GetMatches(matcher, &count);
+    for (size_t i = 0; i < count; ++i)
+        if (matches[i] == id) return 1;
+    return 0;
+}
+
+static void test_matcher(void) {
+    const uint32_t a = SFGP_BUTTON_MASK(SFGP_BUTTON_A);
+    const uint32_t b = SFGP_BUTTON_MASK(SFGP_BUTTON_B);
+    const uint32_t up = SFGP_BUTTON_MASK(SFGP_BUTTON_DPAD_UP);
+    const uint32_t down = SFGP_BUTTON_MASK(SFGP_BUTTON_DPAD_DOWN);
+    const uint32_t x = SFGP_BUTTON_MASK(SFGP_BUTTON_X);
+
+    SFGP_Matcher *matcher;
+    SFGP_Gamepad pad;
+    if (SFGP_CreateMatcher(&matcher) != SFGP_ERROR_OK) {
+        CHECK(0, "matcher: cannot allocate matcher");
+        return;
+    }
+    if (SFGP_InitGamepad(&pad) != SFGP_ERROR_OK) {
+        CHECK(0, "matcher: cannot allocate gamepad");
+        SFGP_DestroyMatcher(matcher);
+        return;
+    }
+
+    // A chord for every single button, the masks differing in one low bit.
+    for (uint32_t i = 0; i < SFGP_BUTTON_ELEM; ++i)
+        SFGP_AddChord(matcher, i, SFGP_BUTTON_MASK(i), 0);
+    SFGP_AddChord(matcher, MATCHER_CHORD_AB, a | b, 50);
+
+    const uint32_t up_up_down[] = { up, up, down };
+    SFGP_AddSequence(matcher, MATCHER_UP_UP_DOWN, up_up_down, 3, 100);
+    SFGP_AddSequence(matcher, MATCHER_UP_DOWN, &up_up_down[1], 2, 500);
+
+    CHECK(SFGP_CompileMatcher(matcher) == SFGP_ERROR_OK,
+            "matcher: cannot compile");
+    SFGP_AttachMatcher(&pad, matcher);
+
+    // Every chord is found within a few slots of its home.
+    const _SFGP_MatcherTables *tables = &matcher->tables;
+    uint32_t probes_max = 0;
+    for (uint32_t i = 0; i < SFGP_BUTTON_ELEM; ++i) {
+        const uint32_t mask = SFGP_BUTTON_MASK(i);
+        uint32_t slot = _SFGP_HashSlot(mask, tables->chord_slots);
+        uint32_t probes = 1;
+        while (tables->chords[slot].mask != mask
+                && probes <= tables->chord_slots) {
+            slot = (slot + 1) & (tables->chord_slots - 1);
+            ++probes;
+        }
+
+        CHECK(probes <= MATCHER_PROBES_MAX,
+                "matcher: button %u chord found after %u probes", i, probes);
+        if (probes > probes_max) probes_max = probes;
+    }
+
+    // And each one fires on its own press.
+    int64_t now = 0;
+    for (uint32_t i = 0; i < SFGP_BUTTON_ELEM; ++i) {
+        hold_buttons(&pad, now += 10, SFGP_BUTTON_MASK(i));
+        CHECK(has_fired(matcher, i), "matcher: button %u chord not fired", i);
+        hold_buttons(&pad, now += 10, 0);
+    }
+
+    // Chords fire on the press completing them, within their tolerance.
+    hold_buttons(&pad, now += 100, a);
+    hold_buttons(&pad, now += 30, a | b);
+    CHECK(has_fired(matcher, MATCHER_CHORD_AB)
+            && !has_fired(matcher, SFGP_BUTTON_B),
+            "matcher: chord within tolerance not fired");
+    hold_buttons(&pad, now += 10, a | b);
+    CHECK(!has_fired(matcher, MATCHER_CHORD_AB),
+            "matcher: held chord fired again");
+    hold_buttons(&pad, now += 10, 0);
+
+    hold_buttons(&pad, now += 100, a);
+    hold_buttons(&pad, now += 51, a | b);
+    CHECK(!has_fired(matcher, MATCHER_CHORD_AB),
+            "matcher: chord past tolerance fired");
+    hold_buttons(&pad, now += 10, 0);
+
+    // Overlapping sequences both end on the same press.
+    const int64_t steps[][3] = {
+        { 0, 50, 50 },      // Both fire.
+        { 0, 50, 250 },     // Too slow for up, up, down.
+        { 0, 150, 50 },     // Likewise, only up, down fires.
+    };
+    for (size_t i = 0; i < sizeof (steps) / sizeof (*steps); ++i) {
+        now += 1000;
+        hold_buttons(&pad, now += steps[i][0], up);
+        hold_buttons(&pad, now += 1, 0);
+        hold_buttons(&pad, now += steps[i][1], up);
+        hold_buttons(&pad, now += 1, 0);
+        hold_buttons(&pad, now += steps[i][2], down);
+
+        CHECK(has_fired(matcher, MATCHER_UP_UP_DOWN) == (i == 0)
+                && has_fired(matcher, MATCHER_UP_DOWN),
+                "matcher: sequences at %zu fired %d and %d", i,
+                has_fired(matcher, MATCHER_UP_UP_DOWN),
+                has_fired(matcher, MATCHER_UP_DOWN));
+        hold_buttons(&pad, now += 1, 0);
+    }
+
+    // A press outside every sequence starts over.
+    hold_buttons(&pad, now += 1000, up);
+    hold_buttons(&pad, now += 10, 0);
+    hold_buttons(&pad, now += 10, x);
+    hold_buttons(&pad, now += 10, 0);
+    hold_buttons(&pad, now += 10, down);
+    CHECK(!has_fired(matcher, MATCHER_UP_DOWN),
+            "matcher: interrupted sequence fired");
+
+    SFGP_AttachMatcher(&pad, NULL);
+    SFGP_DestroyMatcher(matcher);
+    SFGP_DeinitGamepad(&pad);
+    printf("matcher: %d chords within %u probes\n", SFGP_BUTTON_ELEM,
+            probes_max);
+}
+
+
+// ============================================================================
+//
+//      Shaper:
+//
+// ============================================================================
+
+
+static void test_shaper(void) {
+    // Left stick axial with a scaled deadzone, right stick radial, right
+    // trigger cubic.
+    static const struct {
+        float raw[SFGP_AXIS_ELEM];
+        float shaped[SFGP_AXIS_ELEM];
+    } steps[] = {
+        { { 0.1f, -0.2f, 0.1f, 0.1f, 0.5f, 0.5f },
+          { 0.0f, 0.0f, 0.0f, 0.0f, 0.5f, 0.125f } },
+        { { 0.5f, -0.5f, 0.3f, 0.4f, 0.0f, 1.0f },
+          { 0.5f, -0.5f, 0.225f, 0.3f, 0.0f, 1.0f } },
+        { { 0.85f, -0.9f, -0.6f, -0.8f, 1.0f, 0.0f },
+          { 1.0f, -1.0f, -0.6f, -0.8f, 1.0f, 0.0f } },
+        { { -1.0f, 1.0f, 0.0f, -1.0f, 0.25f, 0.25f },
+          { -1.0f, 1.0f, 0.0f, -1.0f, 0.25f, 0.25f * 0.25f * 0.25f } },
+    };
+
+    SFGP_Shaper shaper;
+    SFGP_InitShaper(&shaper);
+    SFGP_SetJoystickShape(&shaper, SFGP_JOYSTICK_LEFT, &(SFGP_Shape) {
+        .deadzone = 0.2f, .saturation = 0.8f, .expo = 0.0f });
+    SFGP_SetJoystickShape(&shaper, SFGP_JOYSTICK_RIGHT, &(SFGP_Shape) {
+        .deadzone = 0.2f, .saturation = 1.0f, .expo = 0.0f, .radial = 1 });
+    SFGP_SetTriggerShape(&shaper, SFGP_TRIGGER_RIGHT, &(SFGP_Shape) {
+        .deadzone = 0.0f, .saturation = 1.0f, .expo = 1.0f });
+
+    SFGP_Gamepad pad;
+    if (SFGP_InitGamepad(&pad) != SFGP_ERROR_OK) {
+        CHECK(0, "shaper: cannot allocate gamepad");
+        return;
+    }
+    SFGP_AttachShaper(&pad, &shaper);
+
+    uint8_t frame[SFGP_FRAME_SIZE];
+    for (size_t i = 0; i < sizeof (steps) / sizeof (*steps); ++i) {
+        write_frame(frame, 1, (int64_t) i * 10, steps[i].raw, 0);
+        SFGP_UpdateGamepad(&pad, frame);
+
+        const float shaped[SFGP_AXIS_ELEM] = {
+            SFGP_GetXValue(pad.left_stick), SFGP_GetYValue(pad.left_stick),
+            SFGP_GetXValue(pad.right_stick), SFGP_GetYValue(pad.right_stick),
+            SFGP_GetTriggerValue(pad.left_trigger),
+            SFGP_GetTriggerValue(pad.right_trigger),
+        };
+        const float raw[SFGP_AXIS_ELEM] = {
+            SFGP_GetXRawValue(pad.left_stick),
+            SFGP_GetYRawValue(pad.left_stick),
+            SFGP_GetXRawValue(pad.right_stick),
+            SFGP_GetYRawValue(pad.right_stick),
+            SFGP_GetTriggerRawValue(pad.left_trigger),
+            SFGP_GetTriggerRawValue(pad.right_trigger),
+        };
+
+        for (int a = 0; a < SFGP_AXIS_ELEM; ++a) {
+            // Zero and the ends are exact, so thresholds follow the shape.
+            const float want = steps[i].shaped[a];
+            const int exact = (want == 0.0f) || (fabsf(want) == 1.0f);
+            CHECK(exact ? (shaped[a] == want) : near(shaped[a], want),
+                    "shaper: step %zu axis %d shaped to %.9g, expected %.9g",
+                    i, a, (double) shaped[a], (double) want);
+            CHECK(raw[a] == steps[i].raw[a],
+                    "shaper: step %zu axis %d raw value %g", i, a,
+                    (double) raw[a]);
+        }
+
+        if (i == 0) {
+            CHECK(SFGP_IsXAtZero(pad.left_stick)
+                    && SFGP_IsYAtZero(pad.right_stick),
+                    "shaper: stick inside deadzone not at zero");
+        }
+        if (i == 2) {
+            CHECK(SFGP_IsXAtMax(pad.left_stick)
+                    && SFGP_IsYJustAtMin(pad.left_stick),
+                    "shaper: stick past saturation not at the edge");
+        }
+    }
+
+    // Detached, values pass through again.
+    SFGP_AttachShaper(&pad, NULL);
+    write_frame(frame, 1, 100, steps[0].raw, 0);
+    SFGP_UpdateGamepad(&pad, frame);
+    CHECK(SFGP_GetXValue(pad.left_stick) == 0.1f
+            && SFGP_GetTriggerValue(pad.right_trigger) == 0.5f,
+            "shaper: detached shaper still applied");
+
+    SFGP_DeinitGamepad(&pad);
+    printf("shaper: %zu frames checked\n", sizeof (steps) / sizeof (*steps));
+}
+
+
+// ============================================================================
+//
+//      Filter:
+//
+// ============================================================================
+
+
+static void test_filter(void) {
+    const uint32_t a = SFGP_BUTTON_MASK(SFGP_BUTTON_A);
+
+    SFGP_FilterBank bank;
+    SFGP_InitFilterBank(&bank);
+    SFGP_SetAxisSmoothing(&bank, SFGP_AXIS_RIGHT_TRIGGER, 0.5f);
+    SFGP_SetAxisHysteresis(&bank, SFGP_AXIS_LEFT_X, 0.9f, 0.5f);
+    SFGP_SetButtonDebounce(&bank, SFGP_BUTTON_A, 3);
+
+    SFGP_Gamepad pad;
+    if (SFGP_InitGamepad(&pad) != SFGP_ERROR_OK) {
+        CHECK(0, "filter: cannot allocate gamepad");
+        return;
+    }
+    SFGP_AttachFilterBank(&pad, &bank);
+
+    uint8_t frame[SFGP_FRAME_SIZE];
+    float axes[SFGP_AXIS_ELEM] = { 0 };
+    int64_t now = 0;
+
+    write_frame(frame, 1, now, axes, 0);
+    SFGP_UpdateGamepad(&pad, frame);
+
+    // A held trigger creeps up on 1 through the EMA, and still latches.
+    axes[SFGP_AXIS_RIGHT_TRIGGER] = 1.0f;
+    float expected = 0.0f;
+    int presses = 0, pressed_at = -1;
+    for (int i = 0; i < 12; ++i) {
+        write_frame(frame, 1, now += 10, axes, 0);
+        SFGP_UpdateGamepad(&pad, frame);
+
+        expected += (1.0f - expected) * 0.5f;
+        const float value = SFGP_GetTriggerValue(pad.right_trigger);
+        CHECK(near(value, expected), "filter: EMA at %g, expected %g",
+                (double) value, (double) expected);
+
+        presses += SFGP_IsTriggerJustPressed(pad.right_trigger);
+        if (pressed_at < 0 && SFGP_IsTriggerPressed(pad.right_trigger))
+            pressed_at = i;
+    }
+    CHECK(presses == 1 && pressed_at == 5,
+            "filter: held trigger latched %d times, first on frame %d",
+            presses, pressed_at);
+    CHECK(SFGP_IsTriggerPressed(pad.right_trigger),
+            "filter: held trigger let go");
+    CHECK(SFGP_GetTriggerRawValue(pad.right_trigger) == 1.0f,
+            "filter: raw value filtered");
+
+    // Polling the same frame again does not advance the filter.
+    const float held = SFGP_GetTriggerValue(pad.right_trigger);
+    axes[SFGP_AXIS_RIGHT_TRIGGER] = 0.0f;
+    write_frame(frame, 1, now, axes, 0);
+    SFGP_UpdateGamepad(&pad, frame);
+    CHECK(SFGP_GetTriggerValue(pad.right_trigger) == held,
+            "filter: repeated timestamp advanced the EMA");
+
+    write_frame(frame, 1, now += 10, axes, 0);
+    SFGP_UpdateGamepad(&pad, frame);
+    CHECK(!SFGP_IsTriggerPressed(pad.right_trigger),
+            "filter: released trigger still latched");
+
+    // Hysteresis: latched at 0.9, held down to 0.5.
+    static const struct {
+        float x;
+        int8_t max, min;
+    } sweep[] = {
+        { 0.85f, 0, 0 }, { 0.95f, 1, 0 }, { 0.6f, 1, 0 }, { 0.45f, 0, 0 },
+        { -0.95f, 0, 1 }, { -0.55f, 0, 1 }, { -0.49f, 0, 0 },
+    };
+    for (size_t i = 0; i < sizeof (sweep) / sizeof (*sweep); ++i) {
+        axes[SFGP_AXIS_LEFT_X] = sweep[i].x;
+        write_frame(frame, 1, now += 10, axes, 0);
+        SFGP_UpdateGamepad(&pad, frame);
+
+        CHECK(SFGP_IsXAtMax(pad.left_stick) == sweep[i].max
+                && SFGP_IsXAtMin(pad.left_stick) == sweep[i].min,
+                "filter: x of %g at max %d and min %d", (double) sweep[i].x,
+                SFGP_IsXAtMax(pad.left_stick), SFGP_IsXAtMin(pad.left_stick));
+    }
+
+    // Debounce: a one frame bounce never shows, a press does on its third.
+    const uint32_t buttons[] = { a, 0, a, a, a, a, 0, a, 0, 0, 0 };
+    const int8_t debounced[] = { 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 0 };
+    for (size_t i = 0; i < sizeof (buttons) / sizeof (*buttons); ++i) {
+        write_frame(frame, 1, now += 10, axes, buttons[i]);
+        SFGP_UpdateGamepad(&pad, frame);
+
+        CHECK(SFGP_IsButtonPressed(pad.buttons[SFGP_BUTTON_A])
+                == debounced[i], "filter: button on frame %zu is %d", i,
+                SFGP_IsButtonPressed(pad.buttons[SFGP_BUTTON_A]));
+    }
+
+    // Detached, everything passes through.
+    SFGP_AttachFilterBank(&pad, NULL);
+    axes[SFGP_AXIS_RIGHT_TRIGGER] = 1.0f;
+    write_frame(frame, 1, now += 10, axes, a);
+    SFGP_UpdateGamepad(&pad, frame);
+    CHECK(SFGP_GetTriggerValue(pad.right_trigger) == 1.0f
+            && SFGP_IsButtonJustPressed(pad.buttons[SFGP_BUTTON_A]),
+            "filter: detached bank still applied");
+
+    SFGP_DeinitGamepad(&pad);
+    printf("filter: low-pass, hysteresis and debounce checked\n");
+}
+
+
+// ============================================================================
+//
+//      Packed:
+//
+// ============================================================================
+
+
+#define PACKED_FRAMES 2000
+
+/**
+ * @brief Random axis value, often exactly 0 or +-1 or right next to them.
+ */
+static float packed_axis(int axis, uint64_t *state) {
+    const uint64_t r = xorshift64(state);
+    static const float edges[] = { 0.0f, 1.0f, -1.0f, 1e-7f, -1e-7f,
+                                   0.99999f, -0.99999f };
+
+    float value = (r & 1)
+        ? edges[(r >> 8) % (sizeof (edges) / sizeof (*edges))]
+        : (float) (r >> 40) / (float) (1u << 23) - 1.0f;
+    if (axis >= SFGP_AXIS_LEFT_TRIGGER) value = fabsf(value);
+    return value;
+}
+
+static void test_packed(void) {
+    SFGP_Gamepad full, unpacked;
+    if (SFGP_InitGamepad(&full) != SFGP_ERROR_OK
+            || SFGP_InitGamepad(&unpacked) != SFGP_ERROR_OK) {
+        CHECK(0, "packed: cannot allocate gamepads");
+        return;
+    }
+
+    SFGP_PackedPad packed, from_full;
+    memset(&packed, 0, sizeof (packed));
+
+    uint64_t state = 0x5F69u;
+    uint8_t frame[SFGP_FRAME_SIZE];
+    for (int i = 0; i < PACKED_FRAMES; ++i) {
+        float axes[SFGP_AXIS_ELEM];
+        for (int a = 0; a < SFGP_AXIS_ELEM; ++a)
+            axes[a] = packed_axis(a, &state);
+        write_frame(frame, 7, i, axes, (uint32_t) xorshift64(&state));
+
+        SFGP_UpdateGamepad(&full, frame);
+        CHECK(SFGP_UpdatePackedPad(&packed, frame) == SFGP_ERROR_OK,
+                "packed: frame %d rejected", i);
+
+        // Updating packed, or packing the full pad, ends up the same.
+        SFGP_PackGamepad(&from_full, &full);
+        CHECK(memcmp(&from_full, &packed, sizeof (packed)) == 0,
+                "packed: frame %d packs differently", i);
+
+        SFGP_UnpackGamepad(&unpacked, &packed);
+
+        for (int a = 0; a < SFGP_AXIS_ELEM; ++a) {
+            const float want = axes[a];
+            const float got = SFGP_GetPackedAxisValue(&packed, a);
+            const int exact = (want == 0.0f) || (fabsf(want) == 1.0f);
+            CHECK(fabsf(got - want) <= 1.0f / SFGP_PACKED_AXIS_MAX
+                    && exact == ((got == 0.0f) || (fabsf(got) == 1.0f)),
+                    "packed: frame %d axis %d %.9g, expected %.9g", i, a,
+                    (double) got, (double) want);
+
+            CHECK(SFGP_IsPackedAxisAtMax(&packed, a) == (want >= 1.0f)
+                    && SFGP_IsPackedAxisAtMin(&packed, a) == (want <= -1.0f)
+                    && SFGP_IsPackedAxisAtZero(&packed, a) == (want == 0.0f),
+                    "packed: frame %d axis %d thresholds off", i, a);
+        }
+
+        // Queries on the unpacked pad answer as on the full one.
+        for (int s = 0; s < SFGP_JOYSTICK_ELEM; ++s) {
+            const SFGP_Joystick *f = full.joysticks[s];
+            const SFGP_Joystick *u = unpacked.joysticks[s];
+            CHECK(SFGP_IsXJustAtMax(f) == SFGP_IsXJustAtMax(u)
+                    && SFGP_IsXJustAtMin(f) == SFGP_IsXJustAtMin(u)
+                    && SFGP_IsYJustAtZero(f) == SFGP_IsYJustAtZero(u)
+                    && SFGP_IsYAtMax(f) == SFGP_IsYAtMax(u)
+                    && SFGP_GetXVelocity(u) == 0.0f,
+                    "packed: frame %d stick %d unpacked differently", i, s);
+        }
+        for (int t = 0; t < SFGP_TRIGGER_ELEM; ++t) {
+            CHECK(SFGP_IsTriggerJustPressed(full.triggers[t])
+                    == SFGP_IsTriggerJustPressed(unpacked.triggers[t])
+                    && SFGP_IsTriggerJustReleased(full.triggers[t])
+                    == SFGP_IsTriggerJustReleased(unpacked.triggers[t]),
+                    "packed: frame %d trigger %d unpacked differently", i, t);
+        }
+        CHECK(SFGP_GetPackedButtonsJustPressed(&packed)
+                == SFGP_GetButtonsJustPressed(&full)
+                && SFGP_GetPackedButtonsJustReleased(&packed)
+                == SFGP_GetButtonsJustReleased(&unpacked),
+                "packed: frame %d button edges differ", i);
+    }
+
+    // A malformed frame leaves the packed pad alone.
+    const SFGP_PackedPad before = packed;
+    float axes[SFGP_AXIS_ELEM] = { 0 };
+    axes[SFGP_AXIS_RIGHT_Y] = NAN;
+    write_frame(frame, 7, PACKED_FRAMES, axes, 0);
+    CHECK(SFGP_UpdatePackedPad(&packed, frame) == SFGP_ERROR_MALFORMED_FRAME
+            && memcmp(&before, &packed, sizeof (packed)) == 0,
+            "packed: NaN axis accepted");
+
+    axes[SFGP_AXIS_RIGHT_Y] = 0.0f;
+    axes[SFGP_AXIS_LEFT_TRIGGER] = -0.25f;
+    write_frame(frame, 7, PACKED_FRAMES, axes, 0);
+    CHECK(SFGP_UpdatePackedPad(&packed, frame) == SFGP_ERROR_MALFORMED_FRAME
+            && memcmp(&before, &packed, sizeof (packed)) == 0,
+            "packed: negative trigger accepted");
+
+    SFGP_DeinitGamepad(&unpacked);
+    SFGP_DeinitGamepad(&full);
+    printf("packed: %d frames round tripped\n", PACKED_FRAMES);
+}
+
+
+// ============================================================================
+//
+//      Repeat:
+//
+// ============================================================================
+
+
+static void test_repeat(void) {
+    const uint32_t a = SFGP_BUTTON_MASK(SFGP_BUTTON_A);
+    const uint32_t b = SFGP_BUTTON_MASK(SFGP_BUTTON_B);
+    const float axes[SFGP_AXIS_ELEM] = { [SFGP_AXIS_LEFT_X] = 1.0f };
+
+    SFGP_Gamepad pad;
+    if (SFGP_InitGamepad(&pad) != SFGP_ERROR_OK) {
+        CHECK(0, "repeat: cannot allocate gamepad");
+        return;
+    }
+    CHECK(SFGP_GetGamepadGeneration(&pad) == 0,
+            "repeat: fresh gamepad at generation %u",
+            SFGP_GetGamepadGeneration(&pad));
+
+    uint8_t frame[SFGP_FRAME_SIZE];
+    write_frame(frame, 1, 10, axes, a);
+    SFGP_UpdateGamepad(&pad, frame);
+    CHECK(SFGP_GetGamepadGeneration(&pad) == 1,
+            "repeat: first frame gave generation %u",
+            SFGP_GetGamepadGeneration(&pad));
+
+    // Repeats change nothing, edges of the original frame stay up.
+    for (int i = 0; i < 3; ++i) {
+        SFGP_UpdateGamepad(&pad, frame);
+        CHECK(SFGP_GetGamepadGeneration(&pad) == 1
+                && SFGP_GetButtonsJustPressed(&pad) == a
+                && SFGP_IsXJustAtMax(pad.left_stick),
+                "repeat: repeated frame %d applied", i);
+    }
+
+    SFGP_Event events[SFGP_MAX_EVENTS];
+    size_t count = 1;
+    CHECK(SFGP_UpdateGamepadEvents(&pad, frame, events, SFGP_MAX_EVENTS,
+                &count) == SFGP_ERROR_OK && count == 0,
+            "repeat: repeated frame gave %zu events", count);
+
+    // The same timestamp with anything else changed is a new frame.
+    write_frame(frame, 1, 10, axes, a | b);
+    SFGP_UpdateGamepad(&pad, frame);
+    CHECK(SFGP_GetGamepadGeneration(&pad) == 2
+            && SFGP_GetButtonsJustPressed(&pad) == b,
+            "repeat: changed frame skipped");
+
+    // Payloads go through the same check.
+    uint8_t payload[SFGP_PAYLOAD_SIZE_MAX];
+    const size_t size = write_payload(payload, 5, 20, axes, a);
+    SFGP_DecodeGamepad(&pad, payload, size);
+    SFGP_DecodeGamepad(&pad, payload, size);
+    CHECK(SFGP_GetGamepadGeneration(&pad) == 3
+            && SFGP_GetButtonsJustReleased(&pad) == b,
+            "repeat: repeated payload applied");
+
+    // Nor are repeats published to readers.
+    static SFGP_SharedGamepad shared;
+    SFGP_InitSharedGamepad(&shared);
+    SFGP_UpdateSharedGamepad(&shared, frame);
+    const uint32_t sequence = shared.sequence;
+    SFGP_UpdateSharedGamepad(&shared, frame);
+    CHECK(shared.sequence == sequence, "repeat: repeated frame republished");
+
+    // Packed pads skip them just the same.
+    SFGP_PackedPad packed;
+    memset(&packed, 0, sizeof (packed));
+    write_frame(frame, 1, 30, axes, a);
+    SFGP_UpdatePackedPad(&packed, frame);
+    SFGP_UpdatePackedPad(&packed, frame);
+    CHECK(SFGP_GetPackedButtonsJustPressed(&packed) == a
+            && SFGP_IsPackedAxisJustAtMax(&packed, SFGP_AXIS_LEFT_X),
+            "repeat: repeated frame cleared packed edges");
+
+    // Unpacking is a new state as well.
+    const uint32_t generation = SFGP_GetGamepadGeneration(&pad);
+    SFGP_UnpackGamepad(&pad, &packed);
+    CHECK(SFGP_GetGamepadGeneration(&pad) == generation + 1,
+            "repeat: unpacking kept generation %u",
+            SFGP_GetGamepadGeneration(&pad));
+
+    SFGP_DeinitGamepad(&pad);
+    printf("repeat: repeated frames skipped\n");
+}
+
+
+// ============================================================================
+//
+//      Registry:
+//
+// ============================================================================
+
+
+#define REGISTRY_CAPACITY 64
+#define REGISTRY_IDS 100
+#define REGISTRY_OPS 20000
+
+static void test_registry(void) {
+    // IDs all hashing to a few slots around the end of the table, so every
+    // lookup walks long runs that wrap around, and every removal has
+    // entries to shift back.
+    const uint32_t table_size = 2 * REGISTRY_CAPACITY;
+    int32_t ids[REGISTRY_IDS];
+    int count = 0;
+    for (int32_t id = 1; count < REGISTRY_IDS; ++id) {
+        const uint32_t home = _SFGP_HashSlot((uint32_t) id, table_size);
+        if (((home + 4) & (table_size - 1)) < 8) ids[count++] = id;
+    }
+
+    SFGP_Registry *registry;
+    if (SFGP_CreateRegistry(&registry, REGISTRY_CAPACITY) != SFGP_ERROR_OK) {
+        CHECK(0, "registry: cannot allocate registry");
+        return;
+    }
+
+    int64_t timestamps[REGISTRY_IDS] = { 0 };
+    SFGP_Gamepad *pads[REGISTRY_IDS] = { 0 };
+    int8_t present[REGISTRY_IDS] = { 0 };
+    size_t expected = 0;
+
+    uint64_t state = 0x5F69u;
+    uint8_t frame[SFGP_FRAME_SIZE];
+    const float axes[SFGP_AXIS_ELEM] = { 0 };
+
+    for (int op = 1; op <= REGISTRY_OPS; ++op) {
+        const uint64_t r = xorshift64(&state);
+        const int i = (int) ((r >> 8) % REGISTRY_IDS);
+
+        // Three adds to a removal, so the registry runs full now and then.
+        if (r & 3) {
+            write_frame(frame, ids[i], op, axes, 0);
+            SFGP_Gamepad *pad = NULL;
+            const SFGP_Error error = SFGP_RouteFrame(registry, frame, &pad);
+
+            if (!present[i] && expected == REGISTRY_CAPACITY) {
+                CHECK(error == SFGP_ERROR_REGISTRY_FULL,
+                        "registry: full registry took id %d", ids[i]);
+                continue;
+            }
+            CHECK(error == SFGP_ERROR_OK && pad != NULL,
+                    "registry: cannot route id %d, %d", ids[i], error);
+            if (pad == NULL) continue;
+
+            // Gamepads stay put for as long as they are registered.
+            CHECK(!present[i] || pad == pads[i],
+                    "registry: id %d moved", ids[i]);
+            expected += !present[i];
+            present[i] = 1;
+            pads[i] = pad;
+            timestamps[i] = op;
+        } else {
+            CHECK(SFGP_RemoveGamepad(registry, ids[i]) == present[i],
+                    "registry: removing id %d disagrees", ids[i]);
+            expected -= present[i];
+            present[i] = 0;
+        }
+
+        // After removals shifted runs back, everything is still found.
+        if (op % 16 == 0 || !(r & 3)) {
+            for (int j = 0; j < REGISTRY_IDS; ++j) {
+                SFGP_Gamepad *pad = SFGP_FindGamepad(registry, ids[j]);
+                CHECK((pad != NULL) == present[j],
+                        "registry: id %d found %d, present %d after op %d",
+                        ids[j], pad != NULL, present[j], op);
+                if (pad == NULL || !present[j]) continue;
+
+                CHECK(pad == pads[j] && SFGP_GetGamepadId(pad) == ids[j]
+                        && SFGP_GetGamepadTimestamp(pad) == timestamps[j],
+                        "registry: id %d holds the wrong gamepad", ids[j]);
+            }
+        }
+    }
+
+    CHECK(SFGP_GetRegistryCount(registry) == expected,
+            "registry: %zu gamepads, expected %zu",
+            SFGP_GetRegistryCount(registry), expected);
+
+    // Iteration covers every gamepad once.
+    size_t seen = 0;
+    for (size_t i = 0; i < SFGP_GetRegistryCount(registry); ++i) {
+        const int32_t id = SFGP_GetGamepadId(
+                SFGP_GetRegistryGamepad(registry, i));
+        for (int j = 0; j < REGISTRY_IDS; ++j)
+            seen += (ids[j] == id) && present[j];
+    }
+    CHECK(seen == expected, "registry: iterated %zu gamepads", seen);
+
+    // A payload that fails to decode creates nothing.
+    uint8_t payload[SFGP_PAYLOAD_SIZE_MAX];
+    for (int j = 0; j < REGISTRY_IDS; ++j) SFGP_RemoveGamepad(registry, ids[j]);
+    const size_t size = write_payload(payload, 5, 1, axes, 0);
+    CHECK(SFGP_RoutePayload(registry, payload, size - 1, NULL)
+            == SFGP_ERROR_MALFORMED_FRAME
+            && SFGP_GetRegistryCount(registry) == 0,
+            "registry: malformed payload registered a gamepad");
+
+    SFGP_Gamepad *pad = NULL;
+    CHECK(SFGP_RoutePayload(registry, payload, size, &pad) == SFGP_ERROR_OK
+            && pad == SFGP_FindGamepad(registry, 42),
+            "registry: payload routed elsewhere");
+
+    SFGP_DestroyRegistry(registry);
+    printf("registry: %d operations over %d colliding ids\n", REGISTRY_OPS,
+            REGISTRY_IDS);
+}
+
+
+// ============================================================================
+//
+//      Ring:
+//
+// ============================================================================
+
+
+#define RING_PATH "sfgp_test_ring.bin"
+#define RING_CAPACITY 8
+#define RING_FRAMES 20000
+
+static void *ring_producer(void *arg) {
+    SFGP_FrameRing *ring = arg;
+    const float axes[SFGP_AXIS_ELEM] = { 0 };
+
+    uint8_t frame[SFGP_FRAME_SIZE];
+    for (int64_t i = 1; i <= RING_FRAMES; ++i) {
+        write_frame(frame, 1, i, axes, shared_buttons(i));
+        while (SFGP_WriteFrameRing(ring, frame) == SFGP_ERROR_RING_FULL)
+            sched_yield();
+    }
+
+    return NULL;
+}
+
+static void test_ring(void) {
+    SFGP_FrameRing producer, consumer;
+    const SFGP_Error created = SFGP_CreateFrameRing(&producer, RING_PATH,
+            RING_CAPACITY);
+    if (created == SFGP_ERROR_UNSUPPORTED) {
+        printf("ring: not supported, skipped\n");
+        return;
+    }
+    CHECK(created == SFGP_ERROR_OK, "ring: cannot create, %d", created);
+    if (created != SFGP_ERROR_OK) return;
+
+    if (SFGP_OpenFrameRing(&consumer, RING_PATH) != SFGP_ERROR_OK) {
+        CHECK(0, "ring: cannot open");
+        SFGP_CloseFrameRing(&producer);
+        return;
+    }
+
+    SFGP_Gamepad pad;
+    if (SFGP_InitGamepad(&pad) != SFGP_ERROR_OK) {
+        CHECK(0, "ring: cannot allocate gamepad");
+        SFGP_CloseFrameRing(&consumer);
+        SFGP_CloseFrameRing(&producer);
+        return;
+    }
+
+    uint8_t frame[SFGP_FRAME_SIZE];
+    float axes[SFGP_AXIS_ELEM] = { 0 };
+    int64_t written = 0, taken = 0;
+    int8_t read = 0;
+
+    // Fills up, then drops.
+    for (int i = 0; i < RING_CAPACITY; ++i) {
+        write_frame(frame, 1, ++written, axes, 0);
+        CHECK(SFGP_WriteFrameRing(&producer, frame) == SFGP_ERROR_OK,
+                "ring: frame %d of %d rejected", i, RING_CAPACITY);
+    }
+    write_frame(frame, 1, written + 1, axes, 0);
+    CHECK(SFGP_WriteFrameRing(&producer, frame) == SFGP_ERROR_RING_FULL,
+            "ring: full ring took a frame");
+
+    // Drained in order, then empty.
+    for (int i = 0; i < RING_CAPACITY; ++i) {
+        CHECK(SFGP_ReadFrameRing(&consumer, &pad, SFGP_RING_NO_WAIT, 0,
+                    &read) == SFGP_ERROR_OK && read
+                && SFGP_GetGamepadTimestamp(&pad) == ++taken,
+                "ring: frame %d read out of order", i);
+    }
+    CHECK(SFGP_ReadFrameRing(&consumer, &pad, SFGP_RING_NO_WAIT, 0, &read)
+            == SFGP_ERROR_OK && !read, "ring: empty ring gave a frame");
+
+    // Positions wrap around the ring many times over.
+    for (int round = 0; round < 100; ++round) {
+        const int n = 1 + (round % RING_CAPACITY);
+        for (int i = 0; i < n; ++i) {
+            write_frame(frame, 1, ++written, axes, 0);
+            SFGP_WriteFrameRing(&producer, frame);
+        }
+        for (int i = 0; i < n; ++i) {
+            SFGP_ReadFrameRing(&consumer, &pad, SFGP_RING_NO_WAIT, 0, &read);
+            CHECK(read && SFGP_GetGamepadTimestamp(&pad) == ++taken,
+                    "ring: round %d frame %d read %lld", round, i,
+                    (long long) SFGP_GetGamepadTimestamp(&pad));
+        }
+    }
+
+    // Malformed frames are taken off the ring without touching the pad.
+    axes[SFGP_AXIS_LEFT_Y] = NAN;
+    write_frame(frame, 1, ++written, axes, 0);
+    SFGP_WriteFrameRing(&producer, frame);
+    CHECK(SFGP_ReadFrameRing(&consumer, &pad, SFGP_RING_NO_WAIT, 0, &read)
+            == SFGP_ERROR_MALFORMED_FRAME && read
+            && SFGP_GetGamepadTimestamp(&pad) == taken,
+            "ring: malformed frame applied");
+
+    // A producer thread against a sleeping consumer, which also runs on a
+    // single core.
+    pthread_t thread;
+    SFGP_FrameRing ring_a, ring_b;
+    SFGP_CreateFrameRing(&ring_a, RING_PATH, RING_CAPACITY);
+    SFGP_OpenFrameRing(&ring_b, RING_PATH);
+    if (pthread_create(&thread, NULL, ring_producer, &ring_a) != 0) {
+        CHECK(0, "ring: cannot start producer");
+    } else {
+        int64_t out_of_order = 0;
+        for (int64_t i = 1; i <= RING_FRAMES; ++i) {
+            if (SFGP_ReadFrameRing(&ring_b, &pad, SFGP_RING_SLEEP, -1, &read)
+                    == SFGP_ERROR_UNSUPPORTED)
+                SFGP_ReadFrameRing(&ring_b, &pad, SFGP_RING_SPIN, -1, &read);
+            const int64_t timestamp = SFGP_GetGamepadTimestamp(&pad);
+            out_of_order += !read || timestamp != i
+                || SFGP_GetButtonsPressed(&pad) != shared_buttons(timestamp);
+        }
+        pthread_join(thread, NULL);
+        CHECK(out_of_order == 0, "ring: %lld of %d frames out of order",
+                (long long) out_of_order, RING_FRAMES);
+    }
+    SFGP_CloseFrameRing(&ring_b);
+    SFGP_CloseFrameRing(&ring_a);
+
+    // Anything else is not a ring.
+    const uint8_t junk[256] = { 1, 2, 3 };
+    CHECK(write_file(RING_PATH, junk, sizeof (junk))
+            && SFGP_OpenFrameRing(&ring_b, RING_PATH)
+                == SFGP_ERROR_INVALID_FILE,
+            "ring: junk opened as a ring");
+
+    SFGP_DeinitGamepad(&pad);
+    SFGP_CloseFrameRing(&consumer);
+    SFGP_CloseFrameRing(&producer);
+    remove(RING_PATH);
+    printf("ring: %lld frames in order, %d across threads\n",
+            (long long) taken, RING_FRAMES);
+}
+
+
+// ============================================================================
+//
+//      Synth:
+//
+// ============================================================================
+
+
+#define SYNTH_FRAMES 56
+#define SYNTH_STRIDE 48
+
+static const SFGP_SynthStep synth_script[] = {
+    { .kind = SFGP_SYNTH_HOLD, .frames = 3,
+      .buttons = SFGP_BUTTON_MASK(SFGP_BUTTON_A) },
+    { .kind = SFGP_SYNTH_RAMP, .axis = SFGP_AXIS_LEFT_X, .frames = 5,
+      .from = -1.0f, .to = 1.0f },
+    { .kind = SFGP_SYNTH_SWEEP, .axis = SFGP_JOYSTICK_RIGHT, .frames = 8,
+      .from = 0.0f, .to = 1.0f },
+    { .kind = SFGP_SYNTH_MASH, .frames = 20,
+      .buttons = SFGP_BUTTON_MASK(SFGP_BUTTON_A)
+          | SFGP_BUTTON_MASK(SFGP_BUTTON_B) },
+    { .kind = SFGP_SYNTH_RANDOM, .frames = 20, .buttons = 0xFFFFu },
+};
+
+/**
+ * @brief Plays the whole synth script seeded by \p seed into \p frames, in
+ * chunks of growing size, returning the number of frames.
+ */
+static size_t synth_play(uint8_t *frames, uint64_t seed) {
+    SFGP_Synth synth;
+    SFGP_InitSynth(&synth, synth_script,
+            sizeof (synth_script) / sizeof (*synth_script), seed);
+    SFGP_SetSynthClock(&synth, 1000, 16);
+    SFGP_SetSynthId(&synth, 9);
+
+    size_t count = 0, chunk = 1, written;
+    do {
+        written = SFGP_SynthesizeFrames(&synth, &frames[count * SYNTH_STRIDE],
+                SYNTH_STRIDE, chunk);
+        count += written;
+        ++chunk;
+    } while (written != 0 && count < SYNTH_FRAMES + 8);
+
+    return count;
+}
+
+static void test_synth(void) {
+    static uint8_t first[(SYNTH_FRAMES + 8) * SYNTH_STRIDE];
+    static uint8_t again[(SYNTH_FRAMES + 8) * SYNTH_STRIDE];
+    static uint8_t other[(SYNTH_FRAMES + 8) * SYNTH_STRIDE];
+
+    // The same setup makes the same frames, however they are asked for.
+    const size_t count = synth_play(first, 7);
+    CHECK(count == SYNTH_FRAMES, "synth: script gave %zu frames", count);
+    CHECK(synth_play(again, 7) == count
+            && memcmp(first, again, count * SYNTH_STRIDE) == 0,
+            "synth: same seed gave different frames");
+    synth_play(other, 8);
+    CHECK(memcmp(first, other, count * SYNTH_STRIDE) != 0,
+            "synth: different seeds gave the same frames");
+
+    SFGP_Gamepad pad;
+    if (SFGP_InitGamepad(&pad) != SFGP_ERROR_OK) {
+        CHECK(0, "synth: cannot allocate gamepad");
+        return;
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        const uint8_t *frame = &first[i * SYNTH_STRIDE];
+        CHECK(_SFGP_IsFrameValid((const _SFGP_Frame *) frame),
+                "synth: frame %zu out of range", i);
+        SFGP_UpdateGamepad(&pad, frame);
+
+        CHECK(SFGP_GetGamepadId(&pad) == 9
+                && SFGP_GetGamepadTimestamp(&pad) == 1000 + (int64_t) i * 16,
+                "synth: frame %zu stamped %d at %lld", i,
+                SFGP_GetGamepadId(&pad),
+                (long long) SFGP_GetGamepadTimestamp(&pad));
+
+        const uint32_t buttons = SFGP_GetButtonsPressed(&pad);
+        if (i < 3) {
+            CHECK(buttons == SFGP_BUTTON_MASK(SFGP_BUTTON_A),
+                    "synth: held buttons %08x", buttons);
+        } else if (i >= 16 && i < 36) {
+            CHECK((buttons & ~synth_script[3].buttons) == 0,
+                    "synth: mashed buttons %08x", buttons);
+        } else if (i >= 36) {
+            CHECK((buttons & ~synth_script[4].buttons) == 0,
+                    "synth: random buttons %08x", buttons);
+        }
+
+        // Ramps hit both ends exactly, and sweeps are at full tilt.
+        if (i == 3) {
+            CHECK(SFGP_GetXValue(pad.left_stick) == -1.0f,
+                    "synth: ramp starts at %g",
+                    (double) SFGP_GetXValue(pad.left_stick));
+        } else if (i == 7) {
+            CHECK(SFGP_IsXAtMax(pad.left_stick),
+                    "synth: ramp ends at %g",
+                    (double) SFGP_GetXValue(pad.left_stick));
+        } else if (i >= 8 && i < 16) {
+            const float x = SFGP_GetXValue(pad.right_stick);
+            const float y = SFGP_GetYValue(pad.right_stick);
+            CHECK(fabsf((x * x) + (y * y) - 1.0f) < 1e-4f,
+                    "synth: sweep frame %zu at %g, %g", i, (double) x,
+                    (double) y);
+        }
+    }
+
+    // Without a script, frames keep coming.
+    SFGP_Synth endless;
+    SFGP_InitSynth(&endless, NULL, 0, 7);
+    CHECK(SFGP_SynthesizeFrames(&endless, other, SYNTH_STRIDE,
+                SYNTH_FRAMES + 8) == SYNTH_FRAMES + 8,
+            "synth: endless synth ran out");
+
+    SFGP_DeinitGamepad(&pad);
+    printf("synth: %zu frames reproduced\n", count);
+}
+
+
+// ============================================================================
+//
+//      Delta:
+//
+// ============================================================================
+
+
+#define DELTA_FRAMES 5000
+
+/**
+ * @brief State a delta stream has to rebuild for each frame.
+ */
+typedef struct DeltaState {
+    int64_t timestamp;
+    uint32_t buttons;
+    float axes[SFGP_AXIS_ELEM];
+} DeltaState;
+
+static DeltaState delta_state_of(const SFGP_Gamepad *pad) {
+    const SFGP_GamepadState *state = _SFGP_GetState(pad);
+    DeltaState result = {
+        .timestamp = state->timestamp,
+        .buttons = state->buttons_current,
+    };
+    for (int a = 0; a < SFGP_AXIS_ELEM; ++a)
+        result.axes[a] = state->axes[a].raw;
+    return result;
+}
+
+/**
+ * @brief Compares \p pad to the state recorded for frame \p frame.
+ *
+ * Axes are quantized on the way, so may be off by up to a step, as values
+ * next to 0 and +-1 are kept off them. Those three stay exact.
+ */
+static void check_delta_state(const SFGP_Gamepad *pad,
+        const DeltaState *expected, uint64_t frame, const char *what) {
+    const DeltaState actual = delta_state_of(pad);
+    const unsigned long long n = (unsigned long long) frame;
+
+    CHECK(actual.timestamp == expected->timestamp,
+            "delta: %s frame %llu timestamp %lld, expected %lld", what, n,
+            (long long) actual.timestamp, (long long) expected->timestamp);
+    CHECK(actual.buttons == expected->buttons,
+            "delta: %s frame %llu buttons 0x%x, expected 0x%x", what, n,
+            actual.buttons, expected->buttons);
+
+    for (int a = 0; a < SFGP_AXIS_ELEM; ++a) {
+        const float want = expected->axes[a], got = actual.axes[a];
+        const int exact = (want == 0.0f) || (fabsf(want) == 1.0f);
+        const float tolerance = exact ? 0.0f : 1.0f / SFGP_PACKED_AXIS_MAX;
+
+        CHECK(fabsf(got - want) <= tolerance
+                && exact == ((got == 0.0f) || (fabsf(got) == 1.0f)),
+                "delta: %s frame %llu axis %d %.9g, expected %.9g", what, n,
+                a, (double) got, (double) want);
+    }
+}
+
+static void test_delta(void) {
+    static const SFGP_SynthStep script[] = {
+        { .kind = SFGP_SYNTH_RANDOM, .frames = 1500,
+          .buttons = UINT32_C(0x3FFFF) },
+        { .kind = SFGP_SYNTH_HOLD, .frames = 700, .buttons = UINT32_C(0x41) },
+        { .kind = SFGP_SYNTH_SWEEP, .axis = SFGP_JOYSTICK_LEFT, .frames = 800,
+          .from = 0.0f, .to = 2.0f },
+        { .kind = SFGP_SYNTH_RAMP, .axis = SFGP_AXIS_RIGHT_TRIGGER,
+          .frames = 500, .from = 0.0f, .to = 1.0f },
+        { .kind = SFGP_SYNTH_MASH, .frames = 1500,
+          .buttons = UINT32_C(0x0F0F) },
+    };
+
+    static uint8_t frames[DELTA_FRAMES * SFGP_FRAME_SIZE];
+    static uint8_t stream[DELTA_FRAMES * SFGP_DELTA_FRAME_MAX];
+    static DeltaState expected[DELTA_FRAMES];
+
+    SFGP_Synth synth;
+    SFGP_InitSynth(&synth, script, sizeof (script) / sizeof (*script), 0x5F69u);
+    const size_t count = SFGP_SynthesizeFrames(&synth, frames, SFGP_FRAME_SIZE,
+            DELTA_FRAMES);
+    CHECK(count == DELTA_FRAMES, "delta: synthesized %zu frames", count);
+
+    // Write, keeping the state each written frame left behind. Frames that
+    // change nothing are skipped by the gamepad, and so by the writer too.
+    SFGP_Gamepad pad, replay;
+    if (SFGP_InitGamepad(&pad) != SFGP_ERROR_OK
+            || SFGP_InitGamepad(&replay) != SFGP_ERROR_OK) {
+        CHECK(0, "delta: cannot allocate gamepads");
+        return;
+    }
+
+    SFGP_DeltaWriter writer;
+    SFGP_InitDeltaWriter(&writer, stream, sizeof (stream),
+            SFGP_DELTA_KEYFRAME_INTERVAL);
+
+    uint64_t written = 0;
+    for (size_t i = 0; i < count; ++i) {
+        const uint32_t generation = SFGP_GetGamepadGeneration(&pad);
+        SFGP_UpdateGamepad(&pad, &frames[SFGP_FRAME_SIZE * i]);
+        if (SFGP_GetGamepadGeneration(&pad) == generation) continue;
+
+        CHECK(SFGP_WriteDelta(&writer, &pad) == SFGP_ERROR_OK,
+                "delta: cannot write frame %zu", i);
+        expected[written++] = delta_state_of(&pad);
+    }
+
+    const size_t size = SFGP_FlushDeltaWriter(&writer);
+
+    // Read everything back in order.
+    SFGP_DeltaReader reader;
+    SFGP_InitDeltaReader(&reader, stream, size);
+
+    uint64_t read_count = 0;
+    for (;;) {
+        int8_t read = 0;
+        const SFGP_Error error = SFGP_ReadDelta(&reader, &replay, &read);
+        CHECK(error == SFGP_ERROR_OK, "delta: read error %d", error);
+        if (error != SFGP_ERROR_OK || !read) break;
+
+        if (read_count < written) {
+            check_delta_state(&replay, &expected[read_count], read_count,
+                    "read");
+        }
+        ++read_count;
+    }
+
+    CHECK(read_count == written, "delta: read %llu frames, wrote %llu",
+            (unsigned long long) read_count, (unsigned long long) written);
+
+    // Seeks within the first segment, onto and around keyframes, and to the
+    // last frame.
+    const uint64_t k = SFGP_DELTA_KEYFRAME_INTERVAL;
+    const uint64_t seeks[] = { 0, 1, k / 2, k - 1, k, k + 1, 3 * k - 1, 3 * k,
+                               7 * k + 13, written - 2, written - 1, 5 };
+
+    for (size_t i = 0; i < sizeof (seeks) / sizeof (*seeks); ++i) {
+        const uint64_t frame = seeks[i];
+        if (frame >= written) continue;
+
+        const SFGP_Error error = SFGP_SeekDelta(&reader, frame);
+        CHECK(error == SFGP_ERROR_OK, "delta: seek to %llu error %d",
+                (unsigned long long) frame, error);
+
+        int8_t read = 0;
+        CHECK(SFGP_ReadDelta(&reader, &replay, &read) == SFGP_ERROR_OK
+                && read, "delta: nothing read after seek to %llu",
+                (unsigned long long) frame);
+        check_delta_state(&replay, &expected[frame], frame, "seek");
+    }
+
+    // Past the end, and reading on after it.
+    CHECK(SFGP_SeekDelta(&reader, written) == SFGP_ERROR_UNSUPPORTED,
+            "delta: seek to end succeeded");
+    CHECK(SFGP_SeekDelta(&reader, written + k) == SFGP_ERROR_UNSUPPORTED,
+            "delta: seek past end succeeded");
+
+    SFGP_DeinitGamepad(&pad);
+    SFGP_DeinitGamepad(&replay);
+
+    printf("delta: %llu frames in %zu bytes, %zu seeks\n",
+            (unsigned long long) written, size,
+            sizeof (seeks) / sizeof (*seeks));
+}
+
+
+// ============================================================================
+//
+//      Analytics:
+//
+// ============================================================================
+
+
+#define ANALYTICS_FILES 8
+#define ANALYTICS_PATH "sfgp_test_analytics_%d.bin"
+
+/**
+ * @brief Records synth frames of seed \p seed into \p path.
+ */
+static int analytics_record(const char *path, uint64_t seed, size_t count) {
+    // Few enough buttons for every chord to fit, as which ones are dropped
+    // would depend on merge order.
+    static const SFGP_SynthStep script[] = {
+        { .kind = SFGP_SYNTH_MASH, .frames = 50, .buttons = 0x0Fu },
+        { .kind = SFGP_SYNTH_RANDOM, .frames = 50, .buttons = 0x3Fu },
+    };
+
+    SFGP_Synth synth;
+    SFGP_InitSynth(&synth, script, 2, seed);
+    SFGP_SetSynthId(&synth, (int32_t) (seed % 3));
+
+    SFGP_Recorder rec;
+    if (SFGP_OpenRecorder(&rec, path) != SFGP_ERROR_OK) return 0;
+
+    int ok = 1;
+    uint8_t frame[SFGP_FRAME_SIZE];
+    for (size_t i = 0; i < count; ++i) {
+        if (SFGP_SynthesizeFrames(&synth, frame, SFGP_FRAME_SIZE, 1) == 0)
+            SFGP_InitSynth(&synth, script, 2, seed + i);
+        ok &= SFGP_RecordFrame(&rec, frame, SFGP_FRAME_SIZE) == SFGP_ERROR_OK;
+    }
+
+    return (SFGP_CloseRecorder(&rec) == SFGP_ERROR_OK) && ok;
+}
+
+/**
+ * @brief Whether \p a and \p b hold the same aggregates, chords in any
+ * order.
+ */
+static int analytics_equal(const SFGP_Analytics *a, const SFGP_Analytics *b) {
+    if (a->files != b->files || a->failed != b->failed
+            || a->frames != b->frames || a->skipped != b->skipped
+            || a->gamepads != b->gamepads || a->no_input != b->no_input
+            || a->chord_count != b->chord_count
+            || a->chords_dropped != b->chords_dropped
+            || memcmp(a->presses, b->presses, sizeof (a->presses)) != 0
+            || memcmp(a->held, b->held, sizeof (a->held)) != 0
+            || memcmp(a->utilization, b->utilization,
+                sizeof (a->utilization)) != 0
+            || memcmp(&a->first_input, &b->first_input,
+                sizeof (a->first_input)) != 0)
+        return 0;
+
+    for (uint32_t i = 0; i < a->chord_count; ++i) {
+        int found = 0;
+        for (uint32_t j = 0; j < b->chord_count; ++j)
+            found |= (a->chords[i].buttons == b->chords[j].buttons)
+                && (a->chords[i].count == b->chords[j].count);
+        if (!found) return 0;
+    }
+
+    return 1;
+}
+
+static void test_analytics(void) {
+    const uint32_t a = SFGP_BUTTON_MASK(SFGP_BUTTON_A);
+    const uint32_t b = SFGP_BUTTON_MASK(SFGP_BUTTON_B);
+
+    SFGP_AnalyticsConfig config;
+    SFGP_InitAnalyticsConfig(&config);
+
+    // A file small enough to count by hand: gamepad 1 presses A, then B on
+    // top with the stick half out, while gamepad 2 never does anything.
+    char paths[ANALYTICS_FILES + 1][64];
+    snprintf(paths[0], sizeof (paths[0]), ANALYTICS_PATH, 0);
+
+    SFGP_Recorder rec;
+    if (SFGP_OpenRecorder(&rec, paths[0]) != SFGP_ERROR_OK) {
+        CHECK(0, "analytics: cannot open %s", paths[0]);
+        return;
+    }
+
+    const struct {
+        int32_t id;
+        int64_t timestamp;
+        float x;
+        uint32_t buttons;
+    } steps[] = {
+        { 1, 0, 0.0f, 0 }, { 2, 0, 0.0f, 0 }, { 1, 10, 0.55f, a },
+        { 1, 20, 0.55f, a | b }, { 1, 30, 0.0f, 0 }, { 1, 40, NAN, 0 },
+        { 2, 40, 0.0f, 0 },
+    };
+    uint8_t frame[SFGP_FRAME_SIZE];
+    for (size_t i = 0; i < sizeof (steps) / sizeof (*steps); ++i) {
+        const float axes[SFGP_AXIS_ELEM] = { [SFGP_AXIS_LEFT_X] = steps[i].x };
+        write_frame(frame, steps[i].id, steps[i].timestamp, axes,
+                steps[i].buttons);
+        SFGP_RecordFrame(&rec, frame, SFGP_FRAME_SIZE);
+    }
+    CHECK(SFGP_CloseRecorder(&rec) == SFGP_ERROR_OK,
+            "analytics: cannot close %s", paths[0]);
+
+    SFGP_Analytics counted;
+    SFGP_InitAnalytics(&counted);
+    CHECK(SFGP_AnalyzeFile(&counted, paths[0], &config) == SFGP_ERROR_OK,
+            "analytics: cannot analyze %s", paths[0]);
+
+    CHECK(counted.frames == 6 && counted.skipped == 1
+            && counted.gamepads == 2 && counted.no_input == 1,
+            "analytics: %llu frames, %llu skipped, %llu gamepads",
+            (unsigned long long) counted.frames,
+            (unsigned long long) counted.skipped,
+            (unsigned long long) counted.gamepads);
+    CHECK(counted.presses[SFGP_BUTTON_A] == 1
+            && counted.presses[SFGP_BUTTON_B] == 1
+            && counted.held[SFGP_BUTTON_A] == 20
+            && counted.held[SFGP_BUTTON_B] == 10,
+            "analytics: A held %lld, B held %lld",
+            (long long) counted.held[SFGP_BUTTON_A],
+            (long long) counted.held[SFGP_BUTTON_B]);
+    CHECK(counted.utilization[SFGP_AXIS_LEFT_X][5] == 20
+            && counted.utilization[SFGP_AXIS_LEFT_X][0] == 10 + 40,
+            "analytics: stick utilization off");
+    CHECK(counted.chord_count == 1 && counted.chords[0].buttons == (a | b)
+            && counted.chords[0].count == 1,
+            "analytics: %u chords", counted.chord_count);
+    CHECK(counted.first_input.total == 1 && counted.first_input.max == 10,
+            "analytics: first input after %lld",
+            (long long) counted.first_input.max);
+
+    // Then files of different sizes, plus one missing.
+    for (int i = 1; i < ANALYTICS_FILES; ++i) {
+        snprintf(paths[i], sizeof (paths[i]), ANALYTICS_PATH, i);
+        CHECK(analytics_record(paths[i], (uint64_t) i, 300 * (size_t) i),
+                "analytics: cannot record %s", paths[i]);
+    }
+    snprintf(paths[ANALYTICS_FILES], sizeof (paths[ANALYTICS_FILES]),
+            ANALYTICS_PATH, ANALYTICS_FILES);
+    remove(paths[ANALYTICS_FILES]);
+
+    // File by file, merged in order, is what every pool must come to.
+    static SFGP_Analytics serial, single;
+    SFGP_InitAnalytics(&serial);
+    for (int i = 0; i <= ANALYTICS_FILES; ++i) {
+        SFGP_InitAnalytics(&single);
+        SFGP_AnalyzeFile(&single, paths[i], &config);
+        SFGP_MergeAnalytics(&serial, &single);
+    }
+    CHECK(serial.files == ANALYTICS_FILES + 1 && serial.failed == 1,
+            "analytics: %llu of %llu files failed",
+            (unsigned long long) serial.failed,
+            (unsigned long long) serial.files);
+
+    const char *path_list[ANALYTICS_FILES + 1];
+    for (int i = 0; i <= ANALYTICS_FILES; ++i) path_list[i] = paths[i];
+
+    static SFGP_Analytics pooled;
+    for (uint32_t threads = 0; threads <= 4; ++threads) {
+        config.threads = threads;
+        SFGP_InitAnalytics(&pooled);
+        CHECK(SFGP_AnalyzeFiles(&pooled, path_list, ANALYTICS_FILES + 1,
+                    &config) == SFGP_ERROR_OK
+                && analytics_equal(&pooled, &serial),
+                "analytics: %u threads disagree with one by one", threads);
+    }
+
+    for (int i = 0; i < ANALYTICS_FILES; ++i) remove(paths[i]);
+    printf("analytics: %llu frames merged over %d files\n",
+            (unsigned long long) serial.frames, ANALYTICS_FILES + 1);
+}
+
+
+// ============================================================================
+//
+//      Main:
+//
+// ============================================================================
+
+
+static const struct {
+    const char *name;
+    void (*run)(void);
+} tests[] = {
+    { "mask", test_mask },
+    { "batch", test_batch },
+    { "events", test_events },
+    { "shared", test_shared },
+    { "record", test_record },
+    { "payload", test_payload },
+    { "rates", test_rates },
+    { "history", test_history },
+    { "matcher", test_matcher },
+    { "shaper", test_shaper },
+    { "filter", test_filter },
+    { "packed", test_packed },
+    { "repeat", test_repeat },
+    { "registry", test_registry },
+    { "ring", test_ring },
+    { "synth", test_synth },
+    { "delta", test_delta },
+    { "analytics", test_analytics },
+};
+
+
+int main(int argc, char **argv) {
+    const char *filter = (argc > 1) ? argv[1] : "";
+
+    int ran = 0;
+    for (size_t i = 0; i < sizeof (tests) / sizeof (*tests); ++i) {
+        if (strncmp(tests[i].name, filter, strlen(filter)) != 0) continue;
+        tests[i].run();
+        ran = 1;
+    }
+
+    if (!ran) {
+        fprintf(stderr, "sfgp_test: no test matching '%s'\n", filter);
+        return 1;
+    }
+
+    return (failures == 0) ? 0 : 1;
+}